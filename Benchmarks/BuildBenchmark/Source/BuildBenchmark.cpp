@@ -0,0 +1,549 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Navmesh build benchmark. Runs generated terrain, city and building
+// scenes and OBJ files through BuildNavmesh and the tiled NavmeshBuilder
+// for every combination of the given cell sizes and heights. Each build
+// reports the time of every Recast stage, the size of the navmesh and
+// the peak Recast memory. Results are printed and can be written as CSV
+// or JSON for comparing runs. BuildNavmesh also runs with the intermediate
+// data kept, which the following build has to free.
+//
+// The compression mode builds tile cache layers with each of the built-in
+// compressors instead, and compares how small they make the layers with
+// how long dtDecompressTileCacheLayer takes to unpack them. Layers are
+// unpacked every time an obstacle changes a tile, so decoding has to stay
+// cheap.
+//
+// BuildBenchmark [--mode build|compression]
+//                [--scene terrain|city|building] [--obj path]
+//                [--cell-sizes s,s,...] [--cell-heights h,h,...]
+//                [--tile-size cells] [--repeats n] [--csv path] [--json path]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "Navmesh.h"
+#include "PerfTimer.h"
+#include "TileCacheSet.h"
+#include "BenchGeometry.h"
+#include "BenchReport.h"
+#include "BenchScenes.h"
+
+static const float AGENT_HEIGHT = 2.0f;
+static const float AGENT_RADIUS = 0.4f;
+static const float AGENT_CLIMB = 0.9f;
+static const float AGENT_SLOPE = 45.0f;
+
+static const int TERRAIN_SIZE = 256;
+static const int CITY_BLOCKS = 8;
+static const int BUILDING_STOREYS = 6;
+
+static const int MAX_OBSTACLES = 128;
+// Every layer is decoded this many times, keeping the fastest pass
+static const int DECODE_PASSES = 10;
+
+// Indexed by rcTimerLabel
+static const char* STAGE_NAMES[RC_MAX_TIMERS] = 
+{
+	"total",
+	"temp",
+	"rasterize_triangles",
+	"build_compactheightfield",
+	"build_contours",
+	"build_contours_trace",
+	"build_contours_simplify",
+	"filter_border",
+	"filter_walkable",
+	"median_area",
+	"filter_low_obstacles",
+	"build_polymesh",
+	"merge_polymesh",
+	"erode_area",
+	"mark_box_area",
+	"mark_cylinder_area",
+	"mark_convexpoly_area",
+	"build_distancefield",
+	"build_distancefield_dist",
+	"build_distancefield_blur",
+	"build_regions",
+	"build_regions_watershed",
+	"build_regions_expand",
+	"build_regions_flood",
+	"build_regions_filter",
+	"build_layers",
+	"build_polymeshdetail",
+	"merge_polymeshdetail",
+};
+
+enum BuildSceneType
+{
+	BUILDSCENE_TERRAIN,
+	BUILDSCENE_CITY,
+	BUILDSCENE_BUILDING,
+	BUILDSCENE_COUNT,
+};
+
+static const char* BUILDSCENE_NAMES[BUILDSCENE_COUNT] = 
+{
+	"terrain",
+	"city",
+	"building",
+};
+
+// Indexed by dtTileCacheCompressorType
+static const char* COMPRESSOR_NAMES[] = 
+{
+	"none",
+	"lz",
+	"rle",
+};
+static const int COMPRESSOR_COUNT = sizeof(COMPRESSOR_NAMES) / sizeof(COMPRESSOR_NAMES[0]);
+
+struct BenchOptions
+{
+	bool compressionMode;
+	std::vector<int> scenes;
+	std::vector<const char*> objPaths;
+	std::vector<float> cellSizes;
+	std::vector<float> cellHeights;
+	int tileSize;
+	int repeats;
+	const char* csvPath;
+	const char* jsonPath;
+};
+
+struct BuildResult
+{
+	int status;					// Size of the navmesh data, or the negative error
+	BuildReport report;
+	int arenaHighWater;			// The single build arena is kept between builds
+};
+
+static bool ParseFloatList(const char* value, std::vector<float>* list)
+{
+	for (const char* s = value; *s != '\0'; )
+	{
+		const float f = (float)atof(s);
+		if (f <= 0.0f)
+			return false;
+		list->push_back(f);
+		s = strchr(s, ',');
+		if (s == NULL)
+			break;
+		++s;
+	}
+	return !list->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions* options)
+{
+	options->compressionMode = false;
+	options->tileSize = 64;
+	options->repeats = 1;
+	options->csvPath = NULL;
+	options->jsonPath = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (value == NULL)
+			return false;
+
+		if (strcmp(argv[i], "--mode") == 0)
+		{
+			if (strcmp(value, "compression") == 0)
+				options->compressionMode = true;
+			else if (strcmp(value, "build") != 0)
+				return false;
+		}
+		else if (strcmp(argv[i], "--scene") == 0)
+		{
+			int scene = 0;
+			while (scene < BUILDSCENE_COUNT && strcmp(value, BUILDSCENE_NAMES[scene]) != 0)
+				++scene;
+			if (scene == BUILDSCENE_COUNT)
+				return false;
+			options->scenes.push_back(scene);
+		}
+		else if (strcmp(argv[i], "--obj") == 0)
+			options->objPaths.push_back(value);
+		else if (strcmp(argv[i], "--cell-sizes") == 0)
+		{
+			if (!ParseFloatList(value, &options->cellSizes))
+				return false;
+		}
+		else if (strcmp(argv[i], "--cell-heights") == 0)
+		{
+			if (!ParseFloatList(value, &options->cellHeights))
+				return false;
+		}
+		else if (strcmp(argv[i], "--tile-size") == 0)
+			options->tileSize = atoi(value);
+		else if (strcmp(argv[i], "--repeats") == 0)
+			options->repeats = atoi(value);
+		else if (strcmp(argv[i], "--csv") == 0)
+			options->csvPath = value;
+		else if (strcmp(argv[i], "--json") == 0)
+			options->jsonPath = value;
+		else
+			return false;
+		++i;
+	}
+
+	// Only OBJ files when some are given and no scene is asked for
+	if (options->scenes.empty() && options->objPaths.empty())
+	{
+		for (int scene = 0; scene < BUILDSCENE_COUNT; ++scene)
+			options->scenes.push_back(scene);
+	}
+	if (options->cellSizes.empty())
+	{
+		options->cellSizes.push_back(0.2f);
+		options->cellSizes.push_back(0.3f);
+		options->cellSizes.push_back(0.4f);
+	}
+	if (options->cellHeights.empty())
+	{
+		options->cellHeights.push_back(0.1f);
+		options->cellHeights.push_back(0.2f);
+	}
+	// Tile cache layers are always tiled
+	if (options->compressionMode && options->tileSize == 0)
+		return false;
+	return options->tileSize >= 0 && options->repeats > 0;
+}
+
+static BuildResult BuildSingle(BenchGeometry& geometry, float cellSize, float cellHeight, bool keepIntermediate)
+{
+	const float* bmin = geometry.getBoundsMin();
+	const float* bmax = geometry.getBoundsMax();
+
+	BuildResult result;
+	result.status = BuildNavmesh(
+		geometry.getVertexCount(), geometry.getVertices(), 
+		geometry.getIndexCount(), geometry.getIndices(), 
+		bmin[0], bmin[1] - 1.0f, bmin[2], bmax[0], bmax[1] + 1.0f, bmax[2], 
+		cellSize, cellHeight, AGENT_HEIGHT, AGENT_SLOPE, AGENT_CLIMB, AGENT_RADIUS, 
+		12.0f, 1.3f, false, 8.0f, 20.0f, 6.0f, 1.0f, keepIntermediate, 
+		1000000);
+	GetBuildReport(&result.report);
+
+	int capacity = 0;
+	int systemAllocs = 0;
+	GetBuildArenaStats(&result.arenaHighWater, &capacity, &systemAllocs);
+	return result;
+}
+
+static BuildResult BuildTiled(BenchGeometry& geometry, float cellSize, float cellHeight, int tileSize)
+{
+	const float* bmin = geometry.getBoundsMin();
+	const float* bmax = geometry.getBoundsMax();
+
+	BuildResult result;
+	memset(&result, 0, sizeof(result));
+	NavmeshBuilder* builder = CreateNavmeshBuilder(
+		bmin[0], bmin[1] - 1.0f, bmin[2], bmax[0], bmax[1] + 1.0f, bmax[2], 
+		cellSize, cellHeight, AGENT_HEIGHT, AGENT_SLOPE, AGENT_CLIMB, AGENT_RADIUS, 
+		12.0f, 1.3f, false, 8.0f, 20.0f, 6.0f, 1.0f, tileSize, 
+		1000000);
+	if (builder == NULL)
+	{
+		result.status = -1;
+		return result;
+	}
+
+	NavmeshBuilderSetMesh(builder, 0, 
+		geometry.getVertexCount(), geometry.getVertices(), 
+		geometry.getIndexCount(), geometry.getIndices());
+	result.status = NavmeshBuilderBuild(builder);
+	GetBuildReport(&result.report);
+
+	int capacity = 0;
+	int systemAllocs = 0;
+	NavmeshBuilderGetArenaStats(builder, &result.arenaHighWater, &capacity, &systemAllocs);
+	DestroyNavmeshBuilder(builder);
+	return result;
+}
+
+static void AddResultRow(const char* scene, BenchGeometry& geometry, const char* builder, 
+	float cellSize, float cellHeight, const BuildResult& result, BenchReport* report)
+{
+	const BuildReport& r = result.report;
+	report->beginRow();
+	report->addText("scene", scene);
+	report->addInt("triangles", geometry.getIndexCount() / 3);
+	report->addText("builder", builder);
+	report->addFloat("cell_size", cellSize);
+	report->addFloat("cell_height", cellHeight);
+	report->addInt("status", result.status < 0 ? result.status : 0);
+	report->addInt("tiles", r.tileCount);
+	report->addInt("polys", r.polyCount);
+	report->addInt("verts", r.vertCount);
+	report->addInt("detail_tris", r.detailTriCount);
+	report->addInt("data_bytes", r.dataSize);
+	report->addInt("peak_bytes", r.peakBytes);
+	report->addInt("alloc_count", r.allocCount);
+	report->addInt("arena_high_water", result.arenaHighWater);
+
+	// The stage that needed the most memory on top of what was in use
+	// when it started, leaving out the total and temporary timers
+	int peakStage = RC_TIMER_RASTERIZE_TRIANGLES;
+	for (int i = RC_TIMER_RASTERIZE_TRIANGLES + 1; i < RC_MAX_TIMERS; ++i)
+	{
+		if (r.stagePeakBytes[i] > r.stagePeakBytes[peakStage])
+			peakStage = i;
+	}
+	report->addText("peak_stage", STAGE_NAMES[peakStage]);
+	report->addInt("peak_stage_bytes", r.stagePeakBytes[peakStage]);
+
+	// Stages that did not run report -1
+	for (int i = 0; i < RC_MAX_TIMERS; ++i)
+	{
+		const std::string name = std::string(STAGE_NAMES[i]) + "_ms";
+		report->addFloat(name.c_str(), r.stageUsec[i] < 0 ? -1.0 : r.stageUsec[i] / 1000.0);
+	}
+	report->printRow(stdout);
+}
+
+enum BuilderType
+{
+	BUILDER_SINGLE,
+	BUILDER_SINGLE_KEPT,		// Keeps the intermediate data, which the next build frees
+	BUILDER_TILED,
+	BUILDER_COUNT,
+};
+
+static const char* BUILDER_NAMES[BUILDER_COUNT] = 
+{
+	"single",
+	"single_kept",
+	"tiled",
+};
+
+static BuildResult Build(BuilderType builder, BenchGeometry& geometry, float cellSize, float cellHeight, int tileSize)
+{
+	if (builder == BUILDER_TILED)
+		return BuildTiled(geometry, cellSize, cellHeight, tileSize);
+	return BuildSingle(geometry, cellSize, cellHeight, builder == BUILDER_SINGLE_KEPT);
+}
+
+// Builds the scene for each cell size and height, keeping the fastest of
+// the repeated builds
+static bool RunScene(const char* scene, BenchGeometry& geometry, const BenchOptions& options, BenchReport* report)
+{
+	bool ok = true;
+	for (size_t s = 0; s < options.cellSizes.size(); ++s)
+	{
+		for (size_t h = 0; h < options.cellHeights.size(); ++h)
+		{
+			const float cellSize = options.cellSizes[s];
+			const float cellHeight = options.cellHeights[h];
+			for (int builder = 0; builder < BUILDER_COUNT; ++builder)
+			{
+				if (builder == BUILDER_TILED && options.tileSize == 0)
+					continue;
+
+				// The kept builds always run twice, so the second one frees
+				// the data kept by the first
+				const int repeats = builder == BUILDER_SINGLE_KEPT && options.repeats < 2 ? 2 : options.repeats;
+				BuildResult best = Build((BuilderType)builder, geometry, cellSize, cellHeight, options.tileSize);
+				for (int i = 1; i < repeats; ++i)
+				{
+					const BuildResult result = Build((BuilderType)builder, geometry, cellSize, cellHeight, options.tileSize);
+					if (result.report.stageUsec[RC_TIMER_TOTAL] < best.report.stageUsec[RC_TIMER_TOTAL])
+						best = result;
+				}
+				AddResultRow(scene, geometry, BUILDER_NAMES[builder], cellSize, cellHeight, best, report);
+				ok &= best.status > 0;
+			}
+		}
+	}
+	return ok;
+}
+
+// Builds the tile cache layers of the scene with each compressor, then
+// times decoding all of them
+static bool RunCompression(const char* scene, BenchGeometry& geometry, const BenchOptions& options, BenchReport* report)
+{
+	const float* bmin = geometry.getBoundsMin();
+	const float* bmax = geometry.getBoundsMax();
+	const int headerSize = (sizeof(dtTileCacheLayerHeader) + 3) & ~3;
+
+	bool ok = true;
+	for (size_t s = 0; s < options.cellSizes.size(); ++s)
+	{
+		for (size_t h = 0; h < options.cellHeights.size(); ++h)
+		{
+			const float cellSize = options.cellSizes[s];
+			const float cellHeight = options.cellHeights[h];
+			for (int compressor = 0; compressor < COMPRESSOR_COUNT; ++compressor)
+			{
+				const int status = BuildTileCache(
+					geometry.getVertexCount(), geometry.getVertices(), 
+					geometry.getIndexCount(), geometry.getIndices(), 
+					bmin[0], bmin[1] - 1.0f, bmin[2], bmax[0], bmax[1] + 1.0f, bmax[2], 
+					cellSize, cellHeight, AGENT_HEIGHT, AGENT_SLOPE, AGENT_CLIMB, AGENT_RADIUS, 
+					1.3f, options.tileSize, MAX_OBSTACLES, compressor, 
+					1000000);
+				BuildReport buildReport;
+				GetBuildReport(&buildReport);
+
+				// Each layer gets its own buffer, as in the tile cache
+				std::vector<std::vector<unsigned char> > layers;
+				int rawBytes = 0;
+				int compressedBytes = 0;
+				if (status > 0)
+				{
+					std::vector<unsigned char> data(status);
+					RetrieveNavmeshData(&data[0]);
+					const TileCacheSetHeader* setHeader = (const TileCacheSetHeader*)&data[0];
+					const unsigned char* p = &data[0] + sizeof(TileCacheSetHeader);
+					for (int i = 0; i < setHeader->numTiles; ++i)
+					{
+						const TileCacheTileHeader* tileHeader = (const TileCacheTileHeader*)p;
+						p += sizeof(TileCacheTileHeader);
+						layers.push_back(std::vector<unsigned char>(p, p + tileHeader->dataSize));
+						p += tileHeader->dataSize;
+
+						// The layer stores the height, area and connection grids
+						const dtTileCacheLayerHeader* layerHeader = (const dtTileCacheLayerHeader*)&layers.back()[0];
+						rawBytes += layerHeader->width * layerHeader->height * 3;
+						compressedBytes += tileHeader->dataSize - headerSize;
+					}
+				}
+
+				dtTileCacheAlloc alloc;
+				dtTileCacheCompressor* comp = dtAllocTileCacheCompressor(compressor);
+				int decodeUsec = 0;
+				int decodeFailures = 0;
+				for (int pass = 0; pass < DECODE_PASSES && !layers.empty(); ++pass)
+				{
+					const TimeVal start = getPerfTime();
+					for (size_t i = 0; i < layers.size(); ++i)
+					{
+						dtTileCacheLayer* layer = NULL;
+						if (dtStatusFailed(dtDecompressTileCacheLayer(&alloc, comp, &layers[i][0], (int)layers[i].size(), &layer)))
+						{
+							++decodeFailures;
+							continue;
+						}
+						dtFreeTileCacheLayer(&alloc, layer);
+					}
+					const int usec = getPerfTimeUsec(getPerfTime() - start);
+					if (pass == 0 || usec < decodeUsec)
+						decodeUsec = usec;
+				}
+				dtFreeTileCacheCompressor(comp);
+
+				report->beginRow();
+				report->addText("scene", scene);
+				report->addInt("triangles", geometry.getIndexCount() / 3);
+				report->addFloat("cell_size", cellSize);
+				report->addFloat("cell_height", cellHeight);
+				report->addInt("tile_size", options.tileSize);
+				report->addText("compressor", COMPRESSOR_NAMES[compressor]);
+				report->addInt("status", status < 0 ? status : 0);
+				report->addInt("decode_failures", decodeFailures);
+				report->addInt("layers", (int)layers.size());
+				report->addInt("raw_bytes", rawBytes);
+				report->addInt("compressed_bytes", compressedBytes);
+				report->addFloat("ratio", compressedBytes > 0 ? (double)rawBytes / compressedBytes : 0.0);
+				report->addFloat("build_ms", buildReport.stageUsec[RC_TIMER_TOTAL] / 1000.0);
+				report->addFloat("decode_us_per_layer", layers.empty() ? 0.0 : (double)decodeUsec / layers.size());
+				report->addFloat("decode_mb_per_sec", decodeUsec > 0 ? (double)rawBytes / decodeUsec : 0.0);
+				report->printRow(stdout);
+				ok &= status > 0 && decodeFailures == 0;
+			}
+		}
+	}
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		fprintf(stderr, 
+			"usage: BuildBenchmark [--mode build|compression]\n"
+			"                      [--scene terrain|city|building] [--obj path]\n"
+			"                      [--cell-sizes s,s,...] [--cell-heights h,h,...]\n"
+			"                      [--tile-size cells] [--repeats n] [--csv path] [--json path]\n"
+			"--scene and --obj can be given more than once. A tile size of 0\n"
+			"skips the tiled builds, and cannot be used in the compression mode.\n");
+		return 1;
+	}
+
+	BenchReport report;
+	bool ok = true;
+	for (size_t i = 0; i < options.scenes.size(); ++i)
+	{
+		BenchGeometry geometry;
+		switch (options.scenes[i])
+		{
+		case BUILDSCENE_TERRAIN:
+			buildTerrainScene(TERRAIN_SIZE, 1, &geometry);
+			break;
+		case BUILDSCENE_CITY:
+			buildCityScene(CITY_BLOCKS, 1, &geometry);
+			break;
+		case BUILDSCENE_BUILDING:
+			buildBuildingScene(BUILDING_STOREYS, 1, &geometry);
+			break;
+		}
+		if (options.compressionMode)
+			ok &= RunCompression(BUILDSCENE_NAMES[options.scenes[i]], geometry, options, &report);
+		else
+			ok &= RunScene(BUILDSCENE_NAMES[options.scenes[i]], geometry, options, &report);
+	}
+
+	for (size_t i = 0; i < options.objPaths.size(); ++i)
+	{
+		BenchGeometry geometry;
+		if (!geometry.loadObj(options.objPaths[i]) || geometry.getIndexCount() == 0)
+		{
+			fprintf(stderr, "Could not load %s\n", options.objPaths[i]);
+			ok = false;
+			continue;
+		}
+		if (options.compressionMode)
+			ok &= RunCompression(options.objPaths[i], geometry, options, &report);
+		else
+			ok &= RunScene(options.objPaths[i], geometry, options, &report);
+	}
+
+	if (options.csvPath != NULL && !report.writeCsv(options.csvPath))
+	{
+		fprintf(stderr, "Could not write %s\n", options.csvPath);
+		ok = false;
+	}
+	if (options.jsonPath != NULL && !report.writeJson(options.jsonPath))
+	{
+		fprintf(stderr, "Could not write %s\n", options.jsonPath);
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHGEOMETRY_H
+#define BENCHGEOMETRY_H
+
+#include <stddef.h>
+#include <vector>
+
+// Triangle soup for the benchmark scenes, laid out the way BuildNavmesh
+// takes it. Floors face up, so they are walkable, and boxes stand on
+// them as obstacles.
+class BenchGeometry
+{
+public:
+	BenchGeometry();
+
+	void clear();
+
+	int addVertex(float x, float y, float z);
+	// The triangle faces the way (b - a) x (c - a) points, as in OBJ files
+	void addTriangle(int a, int b, int c);
+	void addQuad(float minX, float minZ, float maxX, float maxZ, float y);
+	// Top and sides of a box from y up to y + height
+	void addBox(float minX, float minZ, float maxX, float maxZ, float y, float height);
+
+	// Appends the vertices and faces of a Wavefront OBJ file. Faces with
+	// more than three vertices are split into fans. Returns false if the
+	// file could not be read or refers to missing vertices.
+	bool loadObj(const char* path);
+
+	int getVertexCount() const { return (int)vertices.size() / 3; }
+	int getIndexCount() const { return (int)indices.size(); }
+	float* getVertices() { return vertices.empty() ? NULL : &vertices[0]; }
+	int* getIndices() { return indices.empty() ? NULL : &indices[0]; }
+	const float* getBoundsMin() const { return bmin; }
+	const float* getBoundsMax() const { return bmax; }
+
+private:
+	std::vector<float> vertices;
+	std::vector<int> indices;
+	float bmin[3];
+	float bmax[3];
+};
+
+#endif
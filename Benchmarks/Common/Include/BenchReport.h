@@ -0,0 +1,61 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Result table of a benchmark run. Each row holds named values, added in
+// the same order for every row, and the table is written out as CSV or
+// as a JSON array with one object per row.
+class BenchReport
+{
+public:
+	void beginRow();
+	void addText(const char* name, const char* value);
+	void addInt(const char* name, long long value);
+	void addFloat(const char* name, double value);
+
+	// Prints the last row as name=value pairs
+	void printRow(FILE* file) const;
+
+	// Return false if the file could not be written
+	bool writeCsv(const char* path) const;
+	bool writeJson(const char* path) const;
+
+private:
+	struct Value
+	{
+		std::string name;
+		std::string text;
+		bool quoted;
+	};
+
+	std::vector<std::vector<Value> > rows;
+
+	void add(const char* name, const std::string& text, bool quoted);
+};
+
+#endif
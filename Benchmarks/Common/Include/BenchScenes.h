@@ -0,0 +1,50 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHSCENES_H
+#define BENCHSCENES_H
+
+#include "BenchGeometry.h"
+
+// Procedural scenes shared by the benchmarks. The same size and seed
+// always give the same geometry.
+
+// A square floor of cells x cells with a pillar in every cell, each
+// pushed off centre to break up the polygons.
+void buildGridScene(int cells, unsigned int seed, BenchGeometry* geometry);
+
+// Blocks x blocks buildings on a street grid. Some street segments are
+// closed off, so paths have to find their way around them.
+void buildCityScene(int blocks, unsigned int seed, BenchGeometry* geometry);
+
+// A size x size metre heightfield of rolling hills on a 1 m grid, with
+// some slopes too steep to walk.
+void buildTerrainScene(int size, unsigned int seed, BenchGeometry* geometry);
+
+// A building of the given number of storeys, each with interior walls
+// and doors, joined by ramps that pass through openings in the floors.
+void buildBuildingScene(int storeys, unsigned int seed, BenchGeometry* geometry);
+
+// Uniform in [0, 1], advancing the seed
+float benchRandom(unsigned int* seed);
+
+#endif
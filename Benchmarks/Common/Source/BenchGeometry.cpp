@@ -0,0 +1,146 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <float.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BenchGeometry.h"
+
+BenchGeometry::BenchGeometry()
+{
+	clear();
+}
+
+void BenchGeometry::clear()
+{
+	vertices.clear();
+	indices.clear();
+	bmin[0] = bmin[1] = bmin[2] = FLT_MAX;
+	bmax[0] = bmax[1] = bmax[2] = -FLT_MAX;
+}
+
+void BenchGeometry::addQuad(float minX, float minZ, float maxX, float maxZ, float y)
+{
+	const int a = addVertex(minX, y, minZ);
+	const int b = addVertex(maxX, y, minZ);
+	const int c = addVertex(maxX, y, maxZ);
+	const int d = addVertex(minX, y, maxZ);
+	// Wound so the normal points up
+	addTriangle(a, d, c);
+	addTriangle(a, c, b);
+}
+
+void BenchGeometry::addBox(float minX, float minZ, float maxX, float maxZ, float y, float height)
+{
+	const float top = y + height;
+	addQuad(minX, minZ, maxX, maxZ, top);
+
+	const float corners[4][2] = { { minX, minZ }, { maxX, minZ }, { maxX, maxZ }, { minX, maxZ } };
+	for (int i = 0; i < 4; ++i)
+	{
+		const float* p = corners[i];
+		const float* q = corners[(i + 1) % 4];
+		const int a = addVertex(p[0], y, p[1]);
+		const int b = addVertex(q[0], y, q[1]);
+		const int c = addVertex(q[0], top, q[1]);
+		const int d = addVertex(p[0], top, p[1]);
+		addTriangle(a, c, b);
+		addTriangle(a, d, c);
+	}
+}
+
+int BenchGeometry::addVertex(float x, float y, float z)
+{
+	const float v[3] = { x, y, z };
+	for (int i = 0; i < 3; ++i)
+	{
+		vertices.push_back(v[i]);
+		if (v[i] < bmin[i])
+			bmin[i] = v[i];
+		if (v[i] > bmax[i])
+			bmax[i] = v[i];
+	}
+	return getVertexCount() - 1;
+}
+
+void BenchGeometry::addTriangle(int a, int b, int c)
+{
+	indices.push_back(a);
+	indices.push_back(b);
+	indices.push_back(c);
+}
+
+// Resolves an OBJ vertex reference, which counts from 1, or back from
+// the last vertex read when negative. Returns -1 if it is out of range.
+static int ObjVertexIndex(const char* token, int first, int count)
+{
+	const int ref = atoi(token);
+	const int index = ref < 0 ? count + ref : ref - 1;
+	return index >= 0 && index < count ? first + index : -1;
+}
+
+bool BenchGeometry::loadObj(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+		return false;
+
+	const int first = getVertexCount();
+	int count = 0;
+	bool ok = true;
+	char line[1024];
+	std::vector<int> face;
+	while (ok && fgets(line, sizeof(line), file) != NULL)
+	{
+		if (line[0] == 'v' && line[1] == ' ')
+		{
+			float x = 0.0f, y = 0.0f, z = 0.0f;
+			if (sscanf(line + 2, "%f %f %f", &x, &y, &z) != 3)
+				ok = false;
+			addVertex(x, y, z);
+			++count;
+		}
+		else if (line[0] == 'f' && line[1] == ' ')
+		{
+			// Each token is v, v/vt, v//vn or v/vt/vn; only v is used
+			face.clear();
+			for (char* token = strtok(line + 2, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n"))
+			{
+				const int index = ObjVertexIndex(token, first, count);
+				if (index == -1)
+				{
+					ok = false;
+					break;
+				}
+				face.push_back(index);
+			}
+			for (size_t i = 2; ok && i < face.size(); ++i)
+				addTriangle(face[0], face[i - 1], face[i]);
+		}
+	}
+
+	fclose(file);
+	return ok;
+}
@@ -0,0 +1,127 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchReport.h"
+
+void BenchReport::beginRow()
+{
+	rows.push_back(std::vector<Value>());
+}
+
+void BenchReport::addText(const char* name, const char* value)
+{
+	add(name, value, true);
+}
+
+void BenchReport::addInt(const char* name, long long value)
+{
+	char text[32];
+	sprintf(text, "%lld", value);
+	add(name, text, false);
+}
+
+void BenchReport::addFloat(const char* name, double value)
+{
+	char text[32];
+	sprintf(text, "%.4f", value);
+	add(name, text, false);
+}
+
+void BenchReport::add(const char* name, const std::string& text, bool quoted)
+{
+	if (rows.empty())
+		beginRow();
+	Value value;
+	value.name = name;
+	value.text = text;
+	value.quoted = quoted;
+	rows.back().push_back(value);
+}
+
+void BenchReport::printRow(FILE* file) const
+{
+	if (rows.empty())
+		return;
+	const std::vector<Value>& row = rows.back();
+	for (size_t i = 0; i < row.size(); ++i)
+		fprintf(file, "%s%s=%s", i > 0 ? " " : "", row[i].name.c_str(), row[i].text.c_str());
+	fprintf(file, "\n");
+}
+
+bool BenchReport::writeCsv(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	// The columns are the ones of the first row
+	if (!rows.empty())
+	{
+		const std::vector<Value>& header = rows[0];
+		for (size_t i = 0; i < header.size(); ++i)
+			fprintf(file, "%s%s", i > 0 ? "," : "", header[i].name.c_str());
+		fprintf(file, "\n");
+	}
+	for (size_t r = 0; r < rows.size(); ++r)
+	{
+		for (size_t i = 0; i < rows[r].size(); ++i)
+			fprintf(file, "%s%s", i > 0 ? "," : "", rows[r][i].text.c_str());
+		fprintf(file, "\n");
+	}
+	return fclose(file) == 0;
+}
+
+bool BenchReport::writeJson(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	// Names and text values are identifiers and file names, which need
+	// no escaping beyond backslashes and quotes
+	fprintf(file, "[");
+	for (size_t r = 0; r < rows.size(); ++r)
+	{
+		fprintf(file, "%s\n{", r > 0 ? "," : "");
+		for (size_t i = 0; i < rows[r].size(); ++i)
+		{
+			const Value& value = rows[r][i];
+			fprintf(file, "%s\"%s\":", i > 0 ? "," : "", value.name.c_str());
+			if (!value.quoted)
+			{
+				fprintf(file, "%s", value.text.c_str());
+				continue;
+			}
+			fputc('"', file);
+			for (size_t c = 0; c < value.text.size(); ++c)
+			{
+				if (value.text[c] == '"' || value.text[c] == '\\')
+					fputc('\\', file);
+				fputc(value.text[c], file);
+			}
+			fputc('"', file);
+		}
+		fprintf(file, "}");
+	}
+	fprintf(file, "\n]\n");
+	return fclose(file) == 0;
+}
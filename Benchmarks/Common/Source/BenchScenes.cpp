@@ -0,0 +1,222 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+
+#include "BenchScenes.h"
+
+static const float GRID_PITCH = 8.0f;
+static const float PILLAR_SIZE = 2.0f;
+static const float WALL_HEIGHT = 3.0f;
+
+static const float BLOCK_SIZE = 24.0f;
+static const float STREET_WIDTH = 8.0f;
+static const float BUILDING_HEIGHT = 12.0f;
+static const float BARRIER_THICKNESS = 1.0f;
+// Chance of each street segment between two crossings being closed
+static const float BARRIER_CHANCE = 0.25f;
+
+// Wavelength and height of each octave of the terrain noise
+static const int TERRAIN_OCTAVES = 3;
+static const float TERRAIN_WAVELENGTHS[TERRAIN_OCTAVES] = { 64.0f, 16.0f, 4.0f };
+static const float TERRAIN_HEIGHTS[TERRAIN_OCTAVES] = { 16.0f, 4.0f, 0.5f };
+
+static const float BUILDING_SIZE = 48.0f;
+static const float STOREY_HEIGHT = 4.0f;
+// The ramps climb a storey at about 18 degrees
+static const float RAMP_START = 4.0f;
+static const float RAMP_LENGTH = 12.0f;
+static const float RAMP_WIDTH = 3.0f;
+static const float WALL_THICKNESS = 0.3f;
+static const float DOOR_WIDTH = 2.0f;
+
+float benchRandom(unsigned int* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return ((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+void buildGridScene(int cells, unsigned int seed, BenchGeometry* geometry)
+{
+	const float side = cells * GRID_PITCH;
+	geometry->addQuad(0.0f, 0.0f, side, side, 0.0f);
+
+	// The free space left in each cell is wide enough for an agent of
+	// radius 0.4 on every side of the pillar
+	const float play = (GRID_PITCH - PILLAR_SIZE) * 0.5f - 1.0f;
+	for (int z = 0; z < cells; ++z)
+	{
+		for (int x = 0; x < cells; ++x)
+		{
+			const float cx = (x + 0.5f) * GRID_PITCH + (benchRandom(&seed) * 2.0f - 1.0f) * play;
+			const float cz = (z + 0.5f) * GRID_PITCH + (benchRandom(&seed) * 2.0f - 1.0f) * play;
+			geometry->addBox(cx - PILLAR_SIZE * 0.5f, cz - PILLAR_SIZE * 0.5f, 
+				cx + PILLAR_SIZE * 0.5f, cz + PILLAR_SIZE * 0.5f, 0.0f, WALL_HEIGHT);
+		}
+	}
+}
+
+void buildCityScene(int blocks, unsigned int seed, BenchGeometry* geometry)
+{
+	const float pitch = BLOCK_SIZE + STREET_WIDTH;
+	const float side = blocks * pitch + STREET_WIDTH;
+	geometry->addQuad(0.0f, 0.0f, side, side, 0.0f);
+
+	for (int z = 0; z < blocks; ++z)
+	{
+		for (int x = 0; x < blocks; ++x)
+		{
+			const float minX = STREET_WIDTH + x * pitch;
+			const float minZ = STREET_WIDTH + z * pitch;
+			geometry->addBox(minX, minZ, minX + BLOCK_SIZE, minZ + BLOCK_SIZE, 0.0f, BUILDING_HEIGHT);
+
+			// Close the street east of the block or the one south of it.
+			// The outer ring of streets stays open, so every block can
+			// still be reached.
+			if (benchRandom(&seed) < BARRIER_CHANCE && x + 1 < blocks)
+			{
+				const float bx = minX + BLOCK_SIZE + (STREET_WIDTH - BARRIER_THICKNESS) * 0.5f;
+				geometry->addBox(bx, minZ, bx + BARRIER_THICKNESS, minZ + BLOCK_SIZE, 0.0f, WALL_HEIGHT);
+			}
+			if (benchRandom(&seed) < BARRIER_CHANCE && z + 1 < blocks)
+			{
+				const float bz = minZ + BLOCK_SIZE + (STREET_WIDTH - BARRIER_THICKNESS) * 0.5f;
+				geometry->addBox(minX, bz, minX + BLOCK_SIZE, bz + BARRIER_THICKNESS, 0.0f, WALL_HEIGHT);
+			}
+		}
+	}
+}
+
+// Random value at a lattice point of the terrain noise
+static float LatticeValue(int x, int z, unsigned int seed)
+{
+	unsigned int h = seed ^ ((unsigned int)x * 73856093u) ^ ((unsigned int)z * 19349663u);
+	h = (h ^ (h >> 13)) * 1274126177u;
+	return ((h ^ (h >> 16)) & 0xffff) / 65535.0f;
+}
+
+static float SmoothNoise(float x, float z, unsigned int seed)
+{
+	const int ix = (int)floorf(x);
+	const int iz = (int)floorf(z);
+	float tx = x - ix;
+	float tz = z - iz;
+	tx = tx * tx * (3.0f - 2.0f * tx);
+	tz = tz * tz * (3.0f - 2.0f * tz);
+	const float v0 = LatticeValue(ix, iz, seed) + (LatticeValue(ix + 1, iz, seed) - LatticeValue(ix, iz, seed)) * tx;
+	const float v1 = LatticeValue(ix, iz + 1, seed) + (LatticeValue(ix + 1, iz + 1, seed) - LatticeValue(ix, iz + 1, seed)) * tx;
+	return v0 + (v1 - v0) * tz;
+}
+
+void buildTerrainScene(int size, unsigned int seed, BenchGeometry* geometry)
+{
+	const int first = geometry->getVertexCount();
+	for (int z = 0; z <= size; ++z)
+	{
+		for (int x = 0; x <= size; ++x)
+		{
+			float y = 0.0f;
+			for (int i = 0; i < TERRAIN_OCTAVES; ++i)
+				y += SmoothNoise(x / TERRAIN_WAVELENGTHS[i], z / TERRAIN_WAVELENGTHS[i], seed + i) * TERRAIN_HEIGHTS[i];
+			geometry->addVertex((float)x, y, (float)z);
+		}
+	}
+
+	const int row = size + 1;
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const int a = first + z * row + x;
+			geometry->addTriangle(a, a + row, a + row + 1);
+			geometry->addTriangle(a, a + row + 1, a + 1);
+		}
+	}
+}
+
+// A floor with a rectangular opening, as the four quads around it
+static void AddFloorWithOpening(BenchGeometry* geometry, float y, 
+	float minX, float minZ, float maxX, float maxZ)
+{
+	geometry->addQuad(0.0f, 0.0f, BUILDING_SIZE, minZ, y);
+	geometry->addQuad(0.0f, maxZ, BUILDING_SIZE, BUILDING_SIZE, y);
+	geometry->addQuad(0.0f, minZ, minX, maxZ, y);
+	geometry->addQuad(maxX, minZ, BUILDING_SIZE, maxZ, y);
+}
+
+// A wall along x or z from min to max, with a door centred at each of the
+// given positions
+static void AddWall(BenchGeometry* geometry, bool alongX, float at, float min, float max, 
+	const float* doors, int doorCount, float y)
+{
+	float start = min;
+	for (int i = 0; i <= doorCount; ++i)
+	{
+		const float end = i < doorCount ? doors[i] - DOOR_WIDTH * 0.5f : max;
+		if (alongX)
+			geometry->addBox(start, at, end, at + WALL_THICKNESS, y, WALL_HEIGHT);
+		else
+			geometry->addBox(at, start, at + WALL_THICKNESS, end, y, WALL_HEIGHT);
+		if (i < doorCount)
+			start = doors[i] + DOOR_WIDTH * 0.5f;
+	}
+}
+
+void buildBuildingScene(int storeys, unsigned int seed, BenchGeometry* geometry)
+{
+	const float rampEnd = RAMP_START + RAMP_LENGTH;
+	for (int i = 0; i < storeys; ++i)
+	{
+		const float y = i * STOREY_HEIGHT;
+
+		// The ramp up from each storey runs along one side or the other,
+		// so each floor is cut open above the ramp from the storey below
+		if (i == 0)
+			geometry->addQuad(0.0f, 0.0f, BUILDING_SIZE, BUILDING_SIZE, y);
+		else
+		{
+			const float rampZ = (i - 1) % 2 == 0 ? 2.0f : BUILDING_SIZE - 2.0f - RAMP_WIDTH;
+			AddFloorWithOpening(geometry, y, RAMP_START, rampZ, rampEnd, rampZ + RAMP_WIDTH);
+		}
+
+		if (i + 1 < storeys)
+		{
+			const float rampZ = i % 2 == 0 ? 2.0f : BUILDING_SIZE - 2.0f - RAMP_WIDTH;
+			const int a = geometry->addVertex(RAMP_START, y, rampZ);
+			const int b = geometry->addVertex(rampEnd, y + STOREY_HEIGHT, rampZ);
+			const int c = geometry->addVertex(rampEnd, y + STOREY_HEIGHT, rampZ + RAMP_WIDTH);
+			const int d = geometry->addVertex(RAMP_START, y, rampZ + RAMP_WIDTH);
+			geometry->addTriangle(a, d, c);
+			geometry->addTriangle(a, c, b);
+		}
+
+		// Walls split the far half of each floor into rooms, with the
+		// doors moved about from storey to storey
+		const float half = BUILDING_SIZE * 0.5f;
+		const float crossDoors[2] = { 
+			4.0f + benchRandom(&seed) * (half - 8.0f), 
+			half + 4.0f + benchRandom(&seed) * (half - 8.0f) };
+		AddWall(geometry, false, half, 0.0f, BUILDING_SIZE, crossDoors, 2, y);
+		const float roomDoor = half + 4.0f + benchRandom(&seed) * (half - 8.0f);
+		AddWall(geometry, true, half, half + WALL_THICKNESS, BUILDING_SIZE, &roomDoor, 1, y);
+	}
+}
@@ -0,0 +1,63 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CROWDSCENARIOS_H
+#define CROWDSCENARIOS_H
+
+#include <vector>
+
+#include "BenchGeometry.h"
+#include "Steering.h"
+
+enum CrowdScenarioType
+{
+	SCENARIO_CORRIDOR,		// Two groups swap the ends of a long corridor
+	SCENARIO_BOTTLENECK,	// One room empties into the next through a door
+	SCENARIO_PLAZA,			// Everyone crosses a square with pillars to the far side
+	SCENARIO_WANDER,		// Agents walk between random points of the square
+	SCENARIO_COUNT,
+};
+
+// The scene of a scenario, sized so that the agents start out at the
+// same density whatever their number.
+struct CrowdScenario
+{
+	BenchGeometry geometry;
+	std::vector<Vector3> spawns;
+	std::vector<Vector3> targets;
+
+	// Wandering agents get a new target from the free part of the area
+	// whenever they reach the last one.
+	bool wander;
+	float areaMin[2];
+	float areaMax[2];
+	std::vector<float> pillars;		// minX, minZ, maxX, maxZ of each pillar
+};
+
+const char* getCrowdScenarioName(int type);
+// Returns -1 for an unknown name
+int findCrowdScenario(const char* name);
+
+void buildCrowdScenario(int type, int agentCount, CrowdScenario* scenario);
+Vector3 pickWanderTarget(const CrowdScenario& scenario, unsigned int* seed);
+
+#endif
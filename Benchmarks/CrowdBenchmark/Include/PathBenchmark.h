@@ -0,0 +1,43 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATHBENCHMARK_H
+#define PATHBENCHMARK_H
+
+#include "BenchReport.h"
+
+enum PathSceneType
+{
+	PATHSCENE_GRID,			// Open floor broken up by a grid of pillars
+	PATHSCENE_CITY,			// Street grid with some streets closed
+	PATHSCENE_COUNT,
+};
+
+const char* getPathSceneName(int type);
+int findPathScene(const char* name);
+
+// Times findPath and the sliced search over random queries on a node
+// pool the size of the crowd's path queue pool, and reports the probe
+// statistics of the pool. Adds a row to the report.
+bool runPathBenchmark(int type, int queries, BenchReport* report);
+
+#endif
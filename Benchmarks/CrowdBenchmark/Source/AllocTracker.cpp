@@ -0,0 +1,88 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+
+#include <DetourAlloc.h>
+
+#include "AllocTracker.h"
+
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+// Each block is preceded by its size, padded to keep malloc's alignment
+static const int ALLOC_HEADER_SIZE = 16;
+
+static volatile long long s_bytes = 0;
+static volatile long long s_peakBytes = 0;
+
+static long long AddBytes(long long size)
+{
+#ifdef _MSC_VER
+	return InterlockedExchangeAdd64(&s_bytes, size) + size;
+#else
+	return __sync_add_and_fetch(&s_bytes, size);
+#endif
+}
+
+static void* TrackedAlloc(int size, dtAllocHint)
+{
+	unsigned char* mem = (unsigned char*)malloc(size + ALLOC_HEADER_SIZE);
+	if (mem == NULL)
+		return NULL;
+	*(int*)mem = size;
+	const long long bytes = AddBytes(size);
+	if (bytes > s_peakBytes)
+		s_peakBytes = bytes;
+	return mem + ALLOC_HEADER_SIZE;
+}
+
+static void TrackedFree(void* ptr)
+{
+	if (ptr == NULL)
+		return;
+	unsigned char* mem = (unsigned char*)ptr - ALLOC_HEADER_SIZE;
+	AddBytes(-*(int*)mem);
+	free(mem);
+}
+
+void installAllocTracker()
+{
+	dtAllocSetCustom(TrackedAlloc, TrackedFree);
+}
+
+long long getAllocatedBytes()
+{
+	return s_bytes;
+}
+
+long long getPeakAllocatedBytes()
+{
+	return s_peakBytes;
+}
+
+void resetPeakAllocatedBytes()
+{
+	s_peakBytes = s_bytes;
+}
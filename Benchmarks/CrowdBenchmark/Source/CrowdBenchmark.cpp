@@ -0,0 +1,351 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Headless crowd benchmark. Builds a navmesh for each scenario, fills it
+// with agents and measures the SteeringManager update, the path latency
+// and the Detour memory. The path mode times the path searches on their
+// own instead. Results are printed and can be written as CSV or JSON for
+// comparing runs.
+//
+// CrowdBenchmark [--mode crowd|path] [--scenario name] [--agents n,n,...]
+//                [--warmup n] [--updates n] [--queries n]
+//                [--csv path] [--json path]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "Navmesh.h"
+#include "Steering.h"
+#include "PerfTimer.h"
+#include "AllocTracker.h"
+#include "BenchReport.h"
+#include "CrowdScenarios.h"
+#include "PathBenchmark.h"
+
+static const float UPDATE_STEP = 0.1f;
+static const float AGENT_RADIUS = 0.4f;
+static const float AGENT_HEIGHT = 2.0f;
+static const float AGENT_ACCEL = 8.0f;
+static const float AGENT_SPEED = 3.5f;
+// Agents closer than this to their target have arrived
+static const float ARRIVAL_DISTANCE = 1.5f;
+
+// The Dense and Lightweight configurations build the crowd with other
+// limits, see DetourCrowdConfig.h
+#if defined(DT_CROWD_DENSE)
+static const char* CROWD_CONFIG = "dense";
+#elif defined(DT_CROWD_LIGHTWEIGHT)
+static const char* CROWD_CONFIG = "lightweight";
+#else
+static const char* CROWD_CONFIG = "default";
+#endif
+
+struct BenchOptions
+{
+	bool pathMode;
+	int scenario;				// -1 runs every scenario of the mode
+	std::vector<int> agentCounts;
+	int warmupUpdates;
+	int updates;
+	int queries;
+	const char* csvPath;
+	const char* jsonPath;
+};
+
+static bool ParseOptions(int argc, char** argv, BenchOptions* options)
+{
+	options->pathMode = false;
+	options->scenario = -1;
+	options->warmupUpdates = 10;
+	options->updates = 200;
+	options->queries = 1000;
+	options->csvPath = NULL;
+	options->jsonPath = NULL;
+	const char* scenarioName = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (value == NULL)
+			return false;
+
+		if (strcmp(argv[i], "--mode") == 0)
+		{
+			if (strcmp(value, "path") == 0)
+				options->pathMode = true;
+			else if (strcmp(value, "crowd") != 0)
+				return false;
+		}
+		else if (strcmp(argv[i], "--scenario") == 0)
+			scenarioName = value;
+		else if (strcmp(argv[i], "--agents") == 0)
+		{
+			for (const char* s = value; *s != '\0'; )
+			{
+				const int count = atoi(s);
+				if (count <= 0)
+					return false;
+				options->agentCounts.push_back(count);
+				s = strchr(s, ',');
+				if (s == NULL)
+					break;
+				++s;
+			}
+		}
+		else if (strcmp(argv[i], "--warmup") == 0)
+			options->warmupUpdates = atoi(value);
+		else if (strcmp(argv[i], "--updates") == 0)
+			options->updates = atoi(value);
+		else if (strcmp(argv[i], "--queries") == 0)
+			options->queries = atoi(value);
+		else if (strcmp(argv[i], "--csv") == 0)
+			options->csvPath = value;
+		else if (strcmp(argv[i], "--json") == 0)
+			options->jsonPath = value;
+		else
+			return false;
+		++i;
+	}
+
+	if (scenarioName != NULL)
+	{
+		options->scenario = options->pathMode ? findPathScene(scenarioName) : findCrowdScenario(scenarioName);
+		if (options->scenario == -1)
+			return false;
+	}
+
+	if (options->agentCounts.empty())
+	{
+		options->agentCounts.push_back(100);
+		options->agentCounts.push_back(1000);
+		options->agentCounts.push_back(10000);
+	}
+	return options->updates > 0 && options->warmupUpdates >= 0 && options->queries > 0;
+}
+
+static bool BuildScenarioNavmesh(CrowdScenario& scenario, std::vector<unsigned char>* data)
+{
+	BenchGeometry& geometry = scenario.geometry;
+	const float* bmin = geometry.getBoundsMin();
+	const float* bmax = geometry.getBoundsMax();
+	const int size = BuildNavmesh(
+		geometry.getVertexCount(), geometry.getVertices(), 
+		geometry.getIndexCount(), geometry.getIndices(), 
+		bmin[0], bmin[1] - 1.0f, bmin[2], bmax[0], bmax[1] + 1.0f, bmax[2], 
+		0.3f, 0.2f, AGENT_HEIGHT, 45.0f, 0.9f, AGENT_RADIUS, 
+		12.0f, 1.3f, false, 8.0f, 20.0f, 6.0f, 1.0f, false, 
+		1000000);
+	if (size <= 0)
+		return false;
+
+	data->resize(size);
+	RetrieveNavmeshData(&(*data)[0]);
+	return true;
+}
+
+static float DistanceSqr2D(const Vector3& a, const Vector3& b)
+{
+	const float dx = a.x - b.x;
+	const float dz = a.z - b.z;
+	return dx * dx + dz * dz;
+}
+
+static double Percentile(const std::vector<double>& sorted, double fraction)
+{
+	return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+}
+
+static bool RunScenario(int type, int agentCount, const BenchOptions& options, BenchReport* report)
+{
+	CrowdScenario scenario;
+	buildCrowdScenario(type, agentCount, &scenario);
+
+	const TimeVal buildStart = getPerfTime();
+	std::vector<unsigned char> navmeshData;
+	if (!BuildScenarioNavmesh(scenario, &navmeshData))
+	{
+		fprintf(stderr, "%s: navmesh build failed\n", getCrowdScenarioName(type));
+		return false;
+	}
+	const double buildMs = getPerfTimeUsec(getPerfTime() - buildStart) / 1000.0;
+
+	// The manager keeps pointers into the navmesh data, which must
+	// outlive it
+	SteeringManager* steering = new SteeringManager();
+	if (!steering->init(&navmeshData[0], (int)navmeshData.size(), agentCount, AGENT_RADIUS))
+	{
+		fprintf(stderr, "%s: steering init failed\n", getCrowdScenarioName(type));
+		delete steering;
+		return false;
+	}
+
+	std::vector<int> agents;
+	int failedTargets = 0;
+	for (size_t i = 0; i < scenario.spawns.size(); ++i)
+	{
+		const int agent = steering->addAgent(scenario.spawns[i], AGENT_RADIUS, AGENT_HEIGHT, AGENT_ACCEL, AGENT_SPEED);
+		if (agent == -1)
+			continue;
+		if (!steering->setAgentTarget(agent, scenario.targets[i]))
+			++failedTargets;
+		agents.push_back(agent);
+	}
+	std::vector<Vector3> targets(scenario.targets.begin(), scenario.targets.begin() + agents.size());
+
+	unsigned int wanderSeed = 7;
+	std::vector<double> updateMs;
+	long long pathIterations = 0;
+	long long nodeLookups = 0;
+	long long nodeProbes = 0;
+	const float arrivalSqr = ARRIVAL_DISTANCE * ARRIVAL_DISTANCE;
+
+	for (int u = 0; u < options.warmupUpdates + options.updates; ++u)
+	{
+		// The path latency keeps the requests made before the warmup, as
+		// most scenarios make all of theirs at the start
+		if (u == options.warmupUpdates)
+			resetPeakAllocatedBytes();
+
+		if (scenario.wander)
+		{
+			for (size_t i = 0; i < agents.size(); ++i)
+			{
+				if (DistanceSqr2D(steering->getAgentPosition(agents[i]), targets[i]) > arrivalSqr)
+					continue;
+				targets[i] = pickWanderTarget(scenario, &wanderSeed);
+				if (!steering->setAgentTarget(agents[i], targets[i]))
+					++failedTargets;
+			}
+		}
+
+		const TimeVal start = getPerfTime();
+		steering->update(UPDATE_STEP);
+		const int usec = getPerfTimeUsec(getPerfTime() - start);
+
+		if (u >= options.warmupUpdates)
+		{
+			CrowdUpdateTimings timings;
+			steering->getCrowdUpdateTimings(&timings);
+			pathIterations += timings.counters.pathIterations;
+			nodeLookups += timings.counters.nodeLookups;
+			nodeProbes += timings.counters.nodeProbes;
+			updateMs.push_back(usec / 1000.0);
+		}
+	}
+
+	int arrived = 0;
+	for (size_t i = 0; i < agents.size(); ++i)
+	{
+		if (DistanceSqr2D(steering->getAgentPosition(agents[i]), targets[i]) <= arrivalSqr)
+			++arrived;
+	}
+
+	PathLatencyStats latency;
+	steering->getPathLatencyStats(&latency);
+
+	double totalMs = 0.0;
+	for (size_t i = 0; i < updateMs.size(); ++i)
+		totalMs += updateMs[i];
+	std::sort(updateMs.begin(), updateMs.end());
+
+	report->beginRow();
+	report->addText("scenario", getCrowdScenarioName(type));
+	report->addText("crowd_config", CROWD_CONFIG);
+	report->addInt("agents", (int)agents.size());
+	report->addFloat("build_ms", buildMs);
+	report->addInt("navmesh_bytes", (int)navmeshData.size());
+	report->addFloat("update_ms_mean", totalMs / updateMs.size());
+	report->addFloat("update_ms_p50", Percentile(updateMs, 0.5));
+	report->addFloat("update_ms_p95", Percentile(updateMs, 0.95));
+	report->addFloat("update_ms_max", updateMs.back());
+	report->addFloat("path_latency_ms_p50", latency.p50Usec / 1000.0);
+	report->addFloat("path_latency_ms_p90", latency.p90Usec / 1000.0);
+	report->addFloat("path_latency_ms_p99", latency.p99Usec / 1000.0);
+	report->addFloat("path_latency_ms_max", latency.maxUsec / 1000.0);
+	report->addInt("path_latency_samples", latency.samples);
+	report->addInt("path_latency_pending", latency.pending);
+	report->addFloat("path_iterations_per_update", (double)pathIterations / updateMs.size());
+	report->addFloat("node_probes_per_lookup", nodeLookups > 0 ? (double)nodeProbes / nodeLookups : 0.0);
+	report->addInt("detour_bytes", getAllocatedBytes());
+	report->addInt("detour_peak_bytes", getPeakAllocatedBytes());
+	report->addInt("agent_bytes", (int)sizeof(dtCrowdAgent));
+	report->addInt("max_neighbours", DT_CROWD_MAX_NEIGHBOURS);
+	report->addInt("arrived", arrived);
+	report->addInt("failed_targets", failedTargets);
+	report->printRow(stdout);
+
+	delete steering;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	// Must come before anything is allocated through Detour
+	installAllocTracker();
+
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		fprintf(stderr, 
+			"usage: CrowdBenchmark [--mode crowd|path] [--scenario name] [--agents n,n,...]\n"
+			"                      [--warmup n] [--updates n] [--queries n] [--csv path] [--json path]\n"
+			"crowd scenarios: corridor, bottleneck, plaza, wander\n"
+			"path scenarios: grid, city\n");
+		return 1;
+	}
+
+	BenchReport report;
+	bool ok = true;
+	if (options.pathMode)
+	{
+		for (int type = 0; type < PATHSCENE_COUNT; ++type)
+		{
+			if (options.scenario == -1 || type == options.scenario)
+				ok &= runPathBenchmark(type, options.queries, &report);
+		}
+	}
+	else
+	{
+		for (int type = 0; type < SCENARIO_COUNT; ++type)
+		{
+			if (options.scenario != -1 && type != options.scenario)
+				continue;
+			for (size_t i = 0; i < options.agentCounts.size(); ++i)
+				ok &= RunScenario(type, options.agentCounts[i], options, &report);
+		}
+	}
+
+	if (options.csvPath != NULL && !report.writeCsv(options.csvPath))
+	{
+		fprintf(stderr, "Could not write %s\n", options.csvPath);
+		ok = false;
+	}
+	if (options.jsonPath != NULL && !report.writeJson(options.jsonPath))
+	{
+		fprintf(stderr, "Could not write %s\n", options.jsonPath);
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "BenchScenes.h"
+#include "CrowdScenarios.h"
+
+// Distance between agents in the spawn grids, for agents of radius 0.4
+static const float AGENT_SPACING = 1.2f;
+static const float CORRIDOR_WIDTH = 10.0f;
+static const float DOOR_WIDTH = 3.0f;
+static const float WALL_HEIGHT = 3.0f;
+static const float PILLAR_SIZE = 2.0f;
+static const float PILLAR_SPACING = 15.0f;
+// Free space kept around pillars when placing agents and targets
+static const float PILLAR_MARGIN = 1.0f;
+
+static const char* SCENARIO_NAMES[SCENARIO_COUNT] = 
+{
+	"corridor",
+	"bottleneck",
+	"plaza",
+	"wander",
+};
+
+static Vector3 MakeVector(float x, float z)
+{
+	Vector3 v = { x, 0.0f, z };
+	return v;
+}
+
+static bool IsInPillar(const CrowdScenario& scenario, float x, float z)
+{
+	for (size_t i = 0; i < scenario.pillars.size(); i += 4)
+	{
+		const float* p = &scenario.pillars[i];
+		if (x > p[0] - PILLAR_MARGIN && x < p[2] + PILLAR_MARGIN 
+			&& z > p[1] - PILLAR_MARGIN && z < p[3] + PILLAR_MARGIN)
+			return true;
+	}
+	return false;
+}
+
+static void BuildCorridor(int agentCount, CrowdScenario* scenario)
+{
+	// Each half of the agents fills one end and walks to the other
+	const int columns = (int)((CORRIDOR_WIDTH - 2.0f) / AGENT_SPACING) + 1;
+	const int half = (agentCount + 1) / 2;
+	const int rows = (half + columns - 1) / columns;
+	const float groupLength = rows * AGENT_SPACING;
+	const float length = 2.0f * groupLength + 40.0f;
+	scenario->geometry.addQuad(0.0f, 0.0f, length, CORRIDOR_WIDTH, 0.0f);
+
+	for (int i = 0; i < agentCount; ++i)
+	{
+		const int slot = i % half;
+		const float x = 2.0f + (slot / columns) * AGENT_SPACING;
+		const float z = 1.0f + (slot % columns) * AGENT_SPACING;
+		const bool fromStart = i < half;
+		scenario->spawns.push_back(MakeVector(fromStart ? x : length - x, z));
+		scenario->targets.push_back(MakeVector(fromStart ? length - x : x, z));
+	}
+}
+
+static void BuildBottleneck(int agentCount, CrowdScenario* scenario)
+{
+	const int columns = (int)ceilf(sqrtf((float)agentCount));
+	const float room = columns * AGENT_SPACING + 4.0f;
+	const float doorMin = room * 0.5f - DOOR_WIDTH * 0.5f;
+	const float doorMax = room * 0.5f + DOOR_WIDTH * 0.5f;
+	scenario->geometry.addQuad(0.0f, 0.0f, 2.0f * room + 1.0f, room, 0.0f);
+	scenario->geometry.addBox(room, 0.0f, room + 1.0f, doorMin, 0.0f, WALL_HEIGHT);
+	scenario->geometry.addBox(room, doorMax, room + 1.0f, room, 0.0f, WALL_HEIGHT);
+
+	// Every agent keeps its place in the grid of the other room
+	for (int i = 0; i < agentCount; ++i)
+	{
+		const float x = 2.0f + (i / columns) * AGENT_SPACING;
+		const float z = 2.0f + (i % columns) * AGENT_SPACING;
+		scenario->spawns.push_back(MakeVector(x, z));
+		scenario->targets.push_back(MakeVector(x + room + 1.0f, z));
+	}
+}
+
+static void BuildSquare(int agentCount, CrowdScenario* scenario)
+{
+	// Twice the area the spawn grid needs, with pillars placed
+	// symmetrically about the centre
+	const float side = ceilf(sqrtf((float)agentCount) * AGENT_SPACING * 1.5f) + 20.0f;
+	const float centre = side * 0.5f;
+	scenario->geometry.addQuad(0.0f, 0.0f, side, side, 0.0f);
+	scenario->areaMax[0] = scenario->areaMax[1] = side;
+
+	const int pillarsPerSide = (int)((centre - PILLAR_SPACING * 0.5f) / PILLAR_SPACING);
+	for (int pz = -pillarsPerSide; pz <= pillarsPerSide; ++pz)
+	{
+		for (int px = -pillarsPerSide; px <= pillarsPerSide; ++px)
+		{
+			const float x = centre + px * PILLAR_SPACING;
+			const float z = centre + pz * PILLAR_SPACING;
+			const float bounds[4] = { x - PILLAR_SIZE * 0.5f, z - PILLAR_SIZE * 0.5f, 
+				x + PILLAR_SIZE * 0.5f, z + PILLAR_SIZE * 0.5f };
+			scenario->pillars.insert(scenario->pillars.end(), bounds, bounds + 4);
+			scenario->geometry.addBox(bounds[0], bounds[1], bounds[2], bounds[3], 0.0f, WALL_HEIGHT);
+		}
+	}
+
+	// Agents fill the grid row by row from one side, skipping the
+	// pillars. Their targets, mirrored through the centre, are clear of
+	// the pillars too, as those are symmetric.
+	const int columns = (int)((side - 4.0f) / AGENT_SPACING);
+	const float first = centre - (columns / 2) * AGENT_SPACING;
+	for (int i = 0; i < columns * columns && (int)scenario->spawns.size() < agentCount; ++i)
+	{
+		const float x = first + (i % columns) * AGENT_SPACING;
+		const float z = first + (i / columns) * AGENT_SPACING;
+		if (IsInPillar(*scenario, x, z))
+			continue;
+		scenario->spawns.push_back(MakeVector(x, z));
+		scenario->targets.push_back(MakeVector(side - x, side - z));
+	}
+}
+
+const char* getCrowdScenarioName(int type)
+{
+	return type >= 0 && type < SCENARIO_COUNT ? SCENARIO_NAMES[type] : "";
+}
+
+int findCrowdScenario(const char* name)
+{
+	for (int i = 0; i < SCENARIO_COUNT; ++i)
+	{
+		if (strcmp(name, SCENARIO_NAMES[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
+void buildCrowdScenario(int type, int agentCount, CrowdScenario* scenario)
+{
+	scenario->geometry.clear();
+	scenario->spawns.clear();
+	scenario->targets.clear();
+	scenario->pillars.clear();
+	scenario->wander = type == SCENARIO_WANDER;
+	scenario->areaMin[0] = scenario->areaMin[1] = 0.0f;
+	scenario->areaMax[0] = scenario->areaMax[1] = 0.0f;
+
+	switch (type)
+	{
+	case SCENARIO_CORRIDOR:
+		BuildCorridor(agentCount, scenario);
+		break;
+	case SCENARIO_BOTTLENECK:
+		BuildBottleneck(agentCount, scenario);
+		break;
+	case SCENARIO_PLAZA:
+	case SCENARIO_WANDER:
+		BuildSquare(agentCount, scenario);
+		break;
+	}
+
+	if (scenario->wander)
+	{
+		unsigned int seed = 1;
+		for (size_t i = 0; i < scenario->targets.size(); ++i)
+			scenario->targets[i] = pickWanderTarget(*scenario, &seed);
+	}
+}
+
+Vector3 pickWanderTarget(const CrowdScenario& scenario, unsigned int* seed)
+{
+	for (;;)
+	{
+		const float x = scenario.areaMin[0] + 2.0f + benchRandom(seed) * (scenario.areaMax[0] - scenario.areaMin[0] - 4.0f);
+		const float z = scenario.areaMin[1] + 2.0f + benchRandom(seed) * (scenario.areaMax[1] - scenario.areaMin[1] - 4.0f);
+		if (!IsInPillar(scenario, x, z))
+			return MakeVector(x, z);
+	}
+}
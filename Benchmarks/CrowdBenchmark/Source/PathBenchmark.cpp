@@ -0,0 +1,226 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <DetourCommon.h>
+#include <DetourNavMesh.h>
+#include <DetourNavMeshQuery.h>
+#include <DetourNode.h>
+
+#include "Navmesh.h"
+#include "PerfTimer.h"
+#include "BenchScenes.h"
+#include "PathBenchmark.h"
+
+// The size of the node pool of the crowd's path queue
+static const int PATH_NODE_POOL_SIZE = 4096;
+// The iterations the crowd gives its path queue in each update
+static const int SLICE_ITERATIONS = 100;
+static const int MAX_PATH = 256;
+
+static const int GRID_CELLS = 32;
+static const int CITY_BLOCKS = 16;
+
+static const char* PATHSCENE_NAMES[PATHSCENE_COUNT] = 
+{
+	"grid",
+	"city",
+};
+
+struct PathQuery
+{
+	dtPolyRef startRef;
+	dtPolyRef endRef;
+	float startPos[3];
+	float endPos[3];
+};
+
+const char* getPathSceneName(int type)
+{
+	return type >= 0 && type < PATHSCENE_COUNT ? PATHSCENE_NAMES[type] : "";
+}
+
+int findPathScene(const char* name)
+{
+	for (int i = 0; i < PATHSCENE_COUNT; ++i)
+	{
+		if (strcmp(name, PATHSCENE_NAMES[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static bool BuildSceneNavmesh(BenchGeometry& geometry, std::vector<unsigned char>* data)
+{
+	const float* bmin = geometry.getBoundsMin();
+	const float* bmax = geometry.getBoundsMax();
+	const int size = BuildNavmesh(
+		geometry.getVertexCount(), geometry.getVertices(), 
+		geometry.getIndexCount(), geometry.getIndices(), 
+		bmin[0], bmin[1] - 1.0f, bmin[2], bmax[0], bmax[1] + 1.0f, bmax[2], 
+		0.3f, 0.2f, 2.0f, 45.0f, 0.9f, 0.4f, 
+		12.0f, 1.3f, false, 8.0f, 20.0f, 6.0f, 1.0f, false, 
+		1000000);
+	if (size <= 0)
+		return false;
+
+	data->resize(size);
+	RetrieveNavmeshData(&(*data)[0]);
+	return true;
+}
+
+// Random pairs of points on the navmesh, the same for every run
+static void MakeQueries(const dtNavMeshQuery* query, const dtQueryFilter* filter, 
+	const float* bmin, const float* bmax, int count, std::vector<PathQuery>* queries)
+{
+	const float extents[3] = { 2.0f, 4.0f, 2.0f };
+	unsigned int seed = 11;
+	while ((int)queries->size() < count)
+	{
+		PathQuery q;
+		float points[2][3];
+		dtPolyRef refs[2];
+		bool found = true;
+		for (int i = 0; i < 2 && found; ++i)
+		{
+			const float p[3] = { 
+				bmin[0] + benchRandom(&seed) * (bmax[0] - bmin[0]), 
+				0.0f, 
+				bmin[2] + benchRandom(&seed) * (bmax[2] - bmin[2]) };
+			found = dtStatusSucceed(query->findNearestPoly(p, extents, filter, &refs[i], points[i])) 
+				&& refs[i] != 0;
+		}
+		if (!found)
+			continue;
+
+		q.startRef = refs[0];
+		q.endRef = refs[1];
+		dtVcopy(q.startPos, points[0]);
+		dtVcopy(q.endPos, points[1]);
+		queries->push_back(q);
+	}
+}
+
+bool runPathBenchmark(int type, int queryCount, BenchReport* report)
+{
+	BenchGeometry geometry;
+	if (type == PATHSCENE_GRID)
+		buildGridScene(GRID_CELLS, 3, &geometry);
+	else
+		buildCityScene(CITY_BLOCKS, 3, &geometry);
+
+	std::vector<unsigned char> navmeshData;
+	if (!BuildSceneNavmesh(geometry, &navmeshData))
+	{
+		fprintf(stderr, "%s: navmesh build failed\n", getPathSceneName(type));
+		return false;
+	}
+
+	dtNavMesh* navMesh = dtAllocNavMesh();
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	if (navMesh == NULL || query == NULL
+		|| dtStatusFailed(navMesh->init(&navmeshData[0], (int)navmeshData.size(), 0))
+		|| dtStatusFailed(query->init(navMesh, PATH_NODE_POOL_SIZE)))
+	{
+		fprintf(stderr, "%s: navmesh query init failed\n", getPathSceneName(type));
+		dtFreeNavMeshQuery(query);
+		dtFreeNavMesh(navMesh);
+		return false;
+	}
+
+	dtQueryFilter filter;
+	std::vector<PathQuery> queries;
+	MakeQueries(query, &filter, geometry.getBoundsMin(), geometry.getBoundsMax(), queryCount, &queries);
+
+	dtNodePool* nodePool = query->getNodePool();
+	dtPolyRef path[MAX_PATH];
+	int pathCount = 0;
+
+	// Whole searches. The nodes left in the pool are the polygons the
+	// search reached, which stands in for its expansions.
+	long long findNodes = 0;
+	long long findPathPolys = 0;
+	int partialPaths = 0;
+	TimeVal start = getPerfTime();
+	for (size_t i = 0; i < queries.size(); ++i)
+	{
+		const PathQuery& q = queries[i];
+		const dtStatus status = query->findPath(q.startRef, q.endRef, q.startPos, q.endPos, &filter, path, &pathCount, MAX_PATH);
+		findNodes += nodePool->getNodeCount();
+		findPathPolys += pathCount;
+		if (dtStatusDetail(status, DT_PARTIAL_RESULT))
+			++partialPaths;
+	}
+	const int findUsec = getPerfTimeUsec(getPerfTime() - start);
+
+	// The same searches as the path queue runs them, counting the hash
+	// table slots the node pool reads to find each node
+	nodePool->resetProbeStats();
+	long long slicedIterations = 0;
+	start = getPerfTime();
+	for (size_t i = 0; i < queries.size(); ++i)
+	{
+		const PathQuery& q = queries[i];
+		dtStatus status = query->initSlicedFindPath(q.startRef, q.endRef, q.startPos, q.endPos, &filter);
+		while (dtStatusInProgress(status))
+		{
+			int iterations = 0;
+			status = query->updateSlicedFindPath(SLICE_ITERATIONS, &iterations);
+			slicedIterations += iterations;
+		}
+		query->finalizeSlicedFindPath(path, &pathCount, MAX_PATH);
+	}
+	const int slicedUsec = getPerfTimeUsec(getPerfTime() - start);
+	int lookups = 0;
+	int probes = 0;
+	int maxProbe = 0;
+	nodePool->getProbeStats(&lookups, &probes, &maxProbe);
+
+	const dtMeshTile* tile = static_cast<const dtNavMesh*>(navMesh)->getTile(0);
+	const int count = (int)queries.size();
+	report->beginRow();
+	report->addText("scene", getPathSceneName(type));
+	report->addInt("polys", tile->header != NULL ? tile->header->polyCount : 0);
+	report->addInt("queries", count);
+	report->addInt("node_pool", PATH_NODE_POOL_SIZE);
+	report->addInt("node_pool_bytes", nodePool->getMemUsed());
+	report->addFloat("find_ms", findUsec / 1000.0);
+	report->addFloat("find_paths_per_sec", findUsec > 0 ? count * 1000000.0 / findUsec : 0.0);
+	report->addFloat("find_nodes_per_path", (double)findNodes / count);
+	report->addFloat("find_nodes_per_sec", findUsec > 0 ? findNodes * 1000000.0 / findUsec : 0.0);
+	report->addFloat("path_polys", (double)findPathPolys / count);
+	report->addInt("partial_paths", partialPaths);
+	report->addFloat("sliced_ms", slicedUsec / 1000.0);
+	report->addFloat("sliced_iterations_per_path", (double)slicedIterations / count);
+	report->addFloat("sliced_paths_per_sec", slicedUsec > 0 ? count * 1000000.0 / slicedUsec : 0.0);
+	report->addFloat("sliced_iterations_per_sec", slicedUsec > 0 ? slicedIterations * 1000000.0 / slicedUsec : 0.0);
+	report->addFloat("probes_per_lookup", lookups > 0 ? (double)probes / lookups : 0.0);
+	report->addInt("max_probe", maxProbe);
+	report->printRow(stdout);
+
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(navMesh);
+	return true;
+}
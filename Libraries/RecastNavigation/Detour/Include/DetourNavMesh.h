@@ -64,6 +64,9 @@ static const unsigned short DT_EXT_LINK = 0x8000;
 /// A value that indicates the entity does not link to anything.
 static const unsigned int DT_NULL_LINK = 0xffffffff;
 
+/// A value that indicates the polygon is not part of any connected component.
+static const unsigned short DT_NULL_COMPONENT = 0xffff;
+
 /// A flag that indicates that an off-mesh connection can be traversed in both directions. (Is bidirectional.)
 static const unsigned int DT_OFFMESH_CON_BIDIR = 1;
 
@@ -252,6 +255,12 @@ struct dtMeshTile
 	int dataSize;							///< Size of the tile data.
 	int flags;								///< Tile flags. (See: #dtTileFlags)
 	dtMeshTile* next;						///< The next free tile, or the next tile in the spatial grid.
+
+	/// The tile-local connected component of each polygon, or #DT_NULL_COMPONENT
+	/// if the polygon has no flags set. [Size: dtMeshHeader::polyCount]
+	unsigned short* polyComponents;
+	unsigned int componentBase;				///< Index of the tile's first component in the navigation mesh.
+	int componentCount;						///< The number of tile-local components.
 };
 
 /// Configuration parameters used to define multi-tile navigation meshes.
@@ -451,6 +460,23 @@ public:
 	
 	/// @}
 
+	/// @{
+	/// @name Connectivity
+
+	/// Gets the connected component of the specified polygon.
+	///  @param[in]	ref		The polygon reference.
+	/// @return The component id, or zero if the reference is invalid, the polygon
+	/// has no flags set, or the components are not available.
+	unsigned int getPolyComponent(dtPolyRef ref) const;
+
+	/// Returns false if no path can exist between the polygons, whatever the query filter.
+	///  @param[in]	startRef	The reference of the first polygon.
+	///  @param[in]	endRef		The reference of the second polygon.
+	/// @return False if both polygons have a component and the components differ.
+	bool isConnected(dtPolyRef startRef, dtPolyRef endRef) const;
+
+	/// @}
+
 	/// @{
 	/// @name Encoding and Decoding
 	/// These functions are generally meant for internal use only.
@@ -545,6 +571,21 @@ private:
 	/// Removes external links at specified side.
 	void unconnectExtLinks(dtMeshTile* tile, dtMeshTile* target);
 	
+	/// Labels the parts of a tile connected by its internal links.
+	void labelTileComponents(dtMeshTile* tile);
+	/// Joins the components of a tile with the components of the tiles it links to.
+	void unionTileComponents(const dtMeshTile* tile);
+	/// Makes room for @p count more components.
+	bool reserveComponents(int count);
+	/// Joins two components.
+	void unionComponents(unsigned int a, unsigned int b);
+	/// Points every component at its root, so lookups take a single read.
+	void flattenComponents();
+	/// Recomputes the components a tile belongs to after it was removed or its polygon flags changed.
+	void updateTileComponents(dtMeshTile* tile, bool removed);
+	/// Recomputes the component table from the tile labels and links.
+	void rebuildComponents();
+
 
 	// TODO: These methods are duplicates from dtNavMeshQuery, but are needed for off-mesh connection finding.
 	
@@ -572,6 +613,12 @@ private:
 	unsigned int m_saltBits;			///< Number of salt bits in the tile ID.
 	unsigned int m_tileBits;			///< Number of tile bits in the tile ID.
 	unsigned int m_polyBits;			///< Number of poly bits in the tile ID.
+
+	unsigned int* m_components;			///< Root of each tile-local component. [Size: #m_componentCount]
+	int m_componentCount;				///< Number of tile-local components in all tiles.
+	int m_componentCapacity;			///< Allocated size of #m_components.
+	int m_unusedComponentCount;			///< Entries of #m_components left behind by removed or relabelled tiles.
+	bool m_componentsValid;				///< False if labelling ran out of memory.
 };
 
 /// Allocates a navigation mesh object using the Detour allocator.
@@ -125,10 +125,11 @@ public:
 	~dtNavMeshQuery();
 	
 	/// Initializes the query object.
-	///  @param[in]		nav			Pointer to the dtNavMesh object to use for all queries.
-	///  @param[in]		maxNodes	Maximum number of search nodes. [Limits: 0 < value <= 65536]
+	///  @param[in]		nav				Pointer to the dtNavMesh object to use for all queries.
+	///  @param[in]		maxNodes		Maximum number of search nodes. [Limits: 0 < value <= 65536]
+	///  @param[in]		bidirectional	True to allocate the second node pool used by #findPathBidirectional.
 	/// @returns The status flags for the query.
-	dtStatus init(const dtNavMesh* nav, const int maxNodes);
+	dtStatus init(const dtNavMesh* nav, const int maxNodes, const bool bidirectional = false);
 	
 	/// @name Standard Pathfinding Functions
 	// /@{
@@ -148,6 +149,22 @@ public:
 					  const dtQueryFilter* filter,
 					  dtPolyRef* path, int* pathCount, const int maxPath) const;
 	
+	/// Finds a path from the start polygon to the end polygon, searching from both ends at once.
+	///  @param[in]		startRef	The refrence id of the start polygon.
+	///  @param[in]		endRef		The reference id of the end polygon.
+	///  @param[in]		startPos	A position within the start polygon. [(x, y, z)]
+	///  @param[in]		endPos		A position within the end polygon. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	path		An ordered list of polygon references representing the path. (Start to end.) 
+	///  							[(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons returned in the @p path array.
+	///  @param[in]		maxPath		The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	/// @returns The status flags for the query.
+	dtStatus findPathBidirectional(dtPolyRef startRef, dtPolyRef endRef,
+								   const float* startPos, const float* endPos,
+								   const dtQueryFilter* filter,
+								   dtPolyRef* path, int* pathCount, const int maxPath) const;
+	
 	/// Finds the straight path from the start to the end position within the polygon corridor.
 	///  @param[in]		startPos			Path start position. [(x, y, z)]
 	///  @param[in]		endPos				Path end position. [(x, y, z)]
@@ -389,6 +406,9 @@ public:
 	/// @returns The node pool.
 	class dtNodePool* getNodePool() const { return m_nodePool; }
 	
+	/// Returns true if the query was initialized for #findPathBidirectional.
+	bool isBidirectional() const { return m_backNodePool != 0; }
+	
 	/// Gets the navigation mesh the query object is using.
 	/// @return The navigation mesh the query object is using.
 	const dtNavMesh* getAttachedNavMesh() const { return m_nav; }
@@ -438,6 +458,8 @@ private:
 	class dtNodePool* m_tinyNodePool;	///< Pointer to small node pool.
 	class dtNodePool* m_nodePool;		///< Pointer to node pool.
 	class dtNodeQueue* m_openList;		///< Pointer to open list queue.
+	class dtNodePool* m_backNodePool;	///< Pointer to node pool of the backward search.
+	class dtNodeQueue* m_backOpenList;	///< Pointer to open list queue of the backward search.
 };
 
 /// Allocates a query object using the Detour allocator.
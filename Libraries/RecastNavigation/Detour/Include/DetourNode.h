@@ -38,9 +38,15 @@ struct dtNode
 	unsigned int pidx : 30;		///< Index to parent node.
 	unsigned int flags : 2;		///< Node flags 0/open/closed.
 	dtPolyRef id;				///< Polygon ref the node corresponds to.
+	int heapIdx;				///< Index of the node in the open list heap, valid while the node is open.
 };
 
 
+/// Maps polygon references to search nodes.
+///
+/// The nodes are looked up by open addressing with linear probing. The
+/// polygon references are kept in a key table apart from the nodes, so a
+/// lookup only reads the nodes it returns.
 class dtNodePool
 {
 public:
@@ -73,24 +79,41 @@ public:
 	{
 		return sizeof(*this) +
 			sizeof(dtNode)*m_maxNodes +
-			sizeof(dtNodeIndex)*m_maxNodes +
+			sizeof(dtPolyRef)*m_hashSize +
 			sizeof(dtNodeIndex)*m_hashSize;
 	}
 	
 	inline int getMaxNodes() const { return m_maxNodes; }
 	
 	inline int getHashSize() const { return m_hashSize; }
-	inline dtNodeIndex getFirst(int bucket) const { return m_first[bucket]; }
-	inline dtNodeIndex getNext(int i) const { return m_next[i]; }
+	inline int getNodeCount() const { return m_nodeCount; }
+	
+	/// Gets the lookup statistics since construction or the last reset.
+	///  @param[out]	lookups		The number of calls to #getNode and #findNode.
+	///  @param[out]	probes		The number of key table slots read by those calls.
+	///  @param[out]	maxProbe	The most slots read by a single call.
+	void getProbeStats(int* lookups, int* probes, int* maxProbe) const;
+	void resetProbeStats();
 	
 private:
 	
+	inline void recordProbes(int probes)
+	{
+		m_lookups++;
+		m_probes += probes;
+		if (probes > m_maxProbe)
+			m_maxProbe = probes;
+	}
+	
 	dtNode* m_nodes;
-	dtNodeIndex* m_first;
-	dtNodeIndex* m_next;
+	dtPolyRef* m_keys;			///< Polygon reference of each slot, zero if the slot is free.
+	dtNodeIndex* m_slots;		///< Node index of each slot.
 	const int m_maxNodes;
-	const int m_hashSize;
+	const int m_hashSize;		///< Size of the key table.
 	int m_nodeCount;
+	int m_lookups;
+	int m_probes;
+	int m_maxProbe;
 };
 
 class dtNodeQueue
@@ -115,6 +138,7 @@ public:
 		dtNode* result = m_heap[0];
 		m_size--;
 		trickleDown(0, m_heap[m_size]);
+		result->heapIdx = -1;
 		return result;
 	}
 	
@@ -124,16 +148,12 @@ public:
 		bubbleUp(m_size-1, node);
 	}
 	
+	/// Restores the heap order after the total cost of @p node decreased.
 	inline void modify(dtNode* node)
 	{
-		for (int i = 0; i < m_size; ++i)
-		{
-			if (m_heap[i] == node)
-			{
-				bubbleUp(i, node);
-				return;
-			}
-		}
+		const int i = node->heapIdx;
+		if (i >= 0 && i < m_size && m_heap[i] == node)
+			bubbleUp(i, node);
 	}
 	
 	inline bool empty() const { return m_size == 0; }
@@ -144,6 +164,7 @@ public:
 		sizeof(dtNode*)*(m_capacity+1);
 	}
 	
+	inline int getSize() const { return m_size; }
 	inline int getCapacity() const { return m_capacity; }
 	
 private:
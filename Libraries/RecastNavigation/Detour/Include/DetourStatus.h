@@ -35,6 +35,7 @@ static const unsigned int DT_INVALID_PARAM = 1 << 3;	// An input parameter was i
 static const unsigned int DT_BUFFER_TOO_SMALL = 1 << 4;	// Result buffer for the query was too small to store all results.
 static const unsigned int DT_OUT_OF_NODES = 1 << 5;		// Query ran out of nodes during search.
 static const unsigned int DT_PARTIAL_RESULT = 1 << 6;	// Query did not reach the end location, returning best guess. 
+static const unsigned int DT_UNREACHABLE = 1 << 7;		// The end location is not connected to the start location.
 
 
 // Returns true of status is success.
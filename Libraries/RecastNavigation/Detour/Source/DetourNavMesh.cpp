@@ -196,7 +196,12 @@ dtNavMesh::dtNavMesh() :
 	m_tiles(0),
 	m_saltBits(0),
 	m_tileBits(0),
-	m_polyBits(0)
+	m_polyBits(0),
+	m_components(0),
+	m_componentCount(0),
+	m_componentCapacity(0),
+	m_unusedComponentCount(0),
+	m_componentsValid(true)
 {
 	m_orig[0] = 0;
 	m_orig[1] = 0;
@@ -213,7 +218,9 @@ dtNavMesh::~dtNavMesh()
 			m_tiles[i].data = 0;
 			m_tiles[i].dataSize = 0;
 		}
+		dtFree(m_tiles[i].polyComponents);
 	}
+	dtFree(m_components);
 	dtFree(m_posLookup);
 	dtFree(m_tiles);
 }
@@ -907,6 +914,37 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 		}
 	}
 	
+	// Label the tile and join it with the components of its neighbours.
+	// Both sides are visited, since off-mesh links may be one way.
+	labelTileComponents(tile);
+	if (m_componentsValid && tile->polyComponents &&
+		reserveComponents(tile->componentCount))
+	{
+		tile->componentBase = (unsigned int)m_componentCount;
+		for (int i = 0; i < tile->componentCount; ++i)
+			m_components[m_componentCount+i] = (unsigned int)(m_componentCount+i);
+		m_componentCount += tile->componentCount;
+		
+		unionTileComponents(tile);
+		nneis = getTilesAt(header->x, header->y, neis, MAX_NEIS);
+		for (int j = 0; j < nneis; ++j)
+		{
+			if (neis[j] == tile) continue;
+			unionTileComponents(neis[j]);
+		}
+		for (int i = 0; i < 8; ++i)
+		{
+			nneis = getNeighbourTilesAt(header->x, header->y, i, neis, MAX_NEIS);
+			for (int j = 0; j < nneis; ++j)
+				unionTileComponents(neis[j]);
+		}
+		flattenComponents();
+	}
+	else
+	{
+		m_componentsValid = false;
+	}
+	
 	if (result)
 		*result = getTileRef(tile);
 	
@@ -1175,6 +1213,9 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	tile->detailTris = 0;
 	tile->bvTree = 0;
 	tile->offMeshCons = 0;
+	
+	// Removing a tile may split the components it was part of.
+	updateTileComponents(tile, true);
 
 	// Update salt, salt should never be zero.
 	tile->salt = (tile->salt+1) & ((1<<m_saltBits)-1);
@@ -1294,14 +1335,20 @@ dtStatus dtNavMesh::restoreTileState(dtMeshTile* tile, const unsigned char* data
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
 	// Restore per poly state.
+	bool passabilityChanged = false;
 	for (int i = 0; i < tile->header->polyCount; ++i)
 	{
 		dtPoly* p = &tile->polys[i];
 		const dtPolyState* s = &polyStates[i];
+		if ((p->flags == 0) != (s->flags == 0))
+			passabilityChanged = true;
 		p->flags = s->flags;
 		p->setArea(s->area);
 	}
 	
+	if (passabilityChanged)
+		updateTileComponents(tile, false);
+	
 	return DT_SUCCESS;
 }
 
@@ -1392,8 +1439,13 @@ dtStatus dtNavMesh::setPolyFlags(dtPolyRef ref, unsigned short flags)
 	dtPoly* poly = &tile->polys[ip];
 	
 	// Change flags.
+	const bool passabilityChanged = (poly->flags == 0) != (flags == 0);
 	poly->flags = flags;
 	
+	// Polygons without flags are not part of any component.
+	if (passabilityChanged)
+		updateTileComponents(tile, false);
+	
 	return DT_SUCCESS;
 }
 
@@ -1445,3 +1497,318 @@ dtStatus dtNavMesh::getPolyArea(dtPolyRef ref, unsigned char* resultArea) const
 	return DT_SUCCESS;
 }
 
+/// @par
+///
+/// Polygons that can be reached from each other over links share a
+/// component. Links are treated as two way and query filters are ignored,
+/// only polygons with no flags at all are left out. So a shared component
+/// does not mean that a path exists, but different components mean that
+/// no path can exist.
+///
+/// @see #isConnected
+unsigned int dtNavMesh::getPolyComponent(dtPolyRef ref) const
+{
+	if (!m_componentsValid) return 0;
+	if (!ref) return 0;
+	unsigned int salt, it, ip;
+	decodePolyId(ref, salt, it, ip);
+	if (it >= (unsigned int)m_maxTiles) return 0;
+	if (m_tiles[it].salt != salt || m_tiles[it].header == 0) return 0;
+	const dtMeshTile* tile = &m_tiles[it];
+	if (ip >= (unsigned int)tile->header->polyCount) return 0;
+	if (!tile->polyComponents) return 0;
+	const unsigned short c = tile->polyComponents[ip];
+	if (c == DT_NULL_COMPONENT) return 0;
+	return m_components[tile->componentBase + c] + 1;
+}
+
+/// @par
+///
+/// This is a constant time check that can be used to reject a path query
+/// before searching. If either polygon has no component the polygons are
+/// reported as connected, so the check never rejects a path that exists.
+bool dtNavMesh::isConnected(dtPolyRef startRef, dtPolyRef endRef) const
+{
+	const unsigned int a = getPolyComponent(startRef);
+	const unsigned int b = getPolyComponent(endRef);
+	if (!a || !b) return true;
+	return a == b;
+}
+
+void dtNavMesh::labelTileComponents(dtMeshTile* tile)
+{
+	const int polyCount = tile->header->polyCount;
+	tile->componentCount = 0;
+	
+	if (!tile->polyComponents)
+	{
+		tile->polyComponents = (unsigned short*)dtAlloc(sizeof(unsigned short)*dtMax(polyCount,1), DT_ALLOC_PERM);
+		if (!tile->polyComponents)
+			return;
+	}
+	memset(tile->polyComponents, 0xff, sizeof(unsigned short)*polyCount);
+	
+	int* stack = (int*)dtAlloc(sizeof(int)*dtMax(polyCount,1), DT_ALLOC_TEMP);
+	if (!stack)
+	{
+		dtFree(tile->polyComponents);
+		tile->polyComponents = 0;
+		return;
+	}
+	
+	const unsigned int tileIndex = (unsigned int)(tile - m_tiles);
+	
+	for (int i = 0; i < polyCount; ++i)
+	{
+		if (tile->polys[i].flags == 0 || tile->polyComponents[i] != DT_NULL_COMPONENT)
+			continue;
+		if (tile->componentCount >= (int)DT_NULL_COMPONENT)
+		{
+			// Too many components to label.
+			dtFree(tile->polyComponents);
+			tile->polyComponents = 0;
+			tile->componentCount = 0;
+			break;
+		}
+		
+		// Flood fill over the links inside the tile.
+		const unsigned short c = (unsigned short)tile->componentCount++;
+		tile->polyComponents[i] = c;
+		int nstack = 0;
+		stack[nstack++] = i;
+		while (nstack > 0)
+		{
+			const dtPoly* poly = &tile->polys[stack[--nstack]];
+			for (unsigned int j = poly->firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+			{
+				unsigned int salt, it, ip;
+				decodePolyId(tile->links[j].ref, salt, it, ip);
+				if (it != tileIndex) continue;
+				if (tile->polys[ip].flags == 0 || tile->polyComponents[ip] != DT_NULL_COMPONENT)
+					continue;
+				tile->polyComponents[ip] = c;
+				stack[nstack++] = (int)ip;
+			}
+		}
+	}
+	
+	dtFree(stack);
+}
+
+void dtNavMesh::unionTileComponents(const dtMeshTile* tile)
+{
+	if (!tile->polyComponents) return;
+	
+	const unsigned int tileIndex = (unsigned int)(tile - m_tiles);
+	
+	for (int i = 0; i < tile->header->polyCount; ++i)
+	{
+		const unsigned short c = tile->polyComponents[i];
+		if (c == DT_NULL_COMPONENT) continue;
+		const dtPoly* poly = &tile->polys[i];
+		for (unsigned int j = poly->firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+		{
+			unsigned int salt, it, ip;
+			decodePolyId(tile->links[j].ref, salt, it, ip);
+			if (it == tileIndex) continue;
+			const dtMeshTile* nei = &m_tiles[it];
+			if (!nei->polyComponents) continue;
+			const unsigned short nc = nei->polyComponents[ip];
+			if (nc == DT_NULL_COMPONENT) continue;
+			unionComponents(tile->componentBase + c, nei->componentBase + nc);
+		}
+	}
+}
+
+bool dtNavMesh::reserveComponents(int count)
+{
+	const int required = m_componentCount + count;
+	if (required <= m_componentCapacity)
+		return true;
+	
+	int capacity = dtMax(m_componentCapacity*2, 64);
+	while (capacity < required)
+		capacity *= 2;
+	
+	unsigned int* components = (unsigned int*)dtAlloc(sizeof(unsigned int)*capacity, DT_ALLOC_PERM);
+	if (!components)
+		return false;
+	if (m_componentCount)
+		memcpy(components, m_components, sizeof(unsigned int)*m_componentCount);
+	dtFree(m_components);
+	m_components = components;
+	m_componentCapacity = capacity;
+	return true;
+}
+
+void dtNavMesh::unionComponents(unsigned int a, unsigned int b)
+{
+	while (m_components[a] != a) a = m_components[a];
+	while (m_components[b] != b) b = m_components[b];
+	
+	// The root is always the lower index, which lets flattenComponents()
+	// resolve every component in one pass.
+	if (a < b)
+		m_components[b] = a;
+	else if (b < a)
+		m_components[a] = b;
+}
+
+void dtNavMesh::flattenComponents()
+{
+	for (int i = 0; i < m_componentCount; ++i)
+		m_components[i] = m_components[m_components[i]];
+}
+
+/// @par
+///
+/// Union-find cannot split a component, so the components the tile was part
+/// of are reset and joined again from the links of the tiles they cover.
+/// Components elsewhere in the navigation mesh are left as they are. The
+/// tile's old entries in the component table are left unused, and the table
+/// is compacted once more than half of it is unused.
+void dtNavMesh::updateTileComponents(dtMeshTile* tile, bool removed)
+{
+	if (!m_componentsValid || !tile->polyComponents)
+	{
+		if (removed)
+		{
+			dtFree(tile->polyComponents);
+			tile->polyComponents = 0;
+			tile->componentCount = 0;
+		}
+		else
+		{
+			labelTileComponents(tile);
+		}
+		rebuildComponents();
+		return;
+	}
+	
+	const int oldCount = m_componentCount;
+	const int maxCount = oldCount + (removed ? 0 : tile->header->polyCount);
+	
+	// Bit 1 marks the roots of the tile's components, bit 2 the components that are reset.
+	unsigned char* marks = (unsigned char*)dtAlloc(sizeof(unsigned char)*dtMax(maxCount,1), DT_ALLOC_TEMP);
+	if (!marks)
+	{
+		m_componentsValid = false;
+		return;
+	}
+	memset(marks, 0, sizeof(unsigned char)*maxCount);
+	
+	for (int i = 0; i < tile->componentCount; ++i)
+		marks[m_components[tile->componentBase + i]] |= 1;
+	m_unusedComponentCount += tile->componentCount;
+	
+	if (removed)
+	{
+		dtFree(tile->polyComponents);
+		tile->polyComponents = 0;
+		tile->componentBase = 0;
+		tile->componentCount = 0;
+	}
+	else
+	{
+		labelTileComponents(tile);
+		if (!tile->polyComponents || !reserveComponents(tile->componentCount))
+		{
+			dtFree(marks);
+			m_componentsValid = false;
+			return;
+		}
+		tile->componentBase = (unsigned int)m_componentCount;
+		for (int i = 0; i < tile->componentCount; ++i)
+			m_components[m_componentCount+i] = (unsigned int)(m_componentCount+i);
+		m_componentCount += tile->componentCount;
+	}
+	
+	// Reset the affected components. The table is flat, so the parent is the root.
+	for (int i = 0; i < oldCount; ++i)
+	{
+		if (marks[m_components[i]] & 1)
+			marks[i] |= 2;
+	}
+	for (int i = 0; i < oldCount; ++i)
+	{
+		if (marks[i] & 2)
+			m_components[i] = (unsigned int)i;
+	}
+	
+	// Join them again over the links of the tiles that hold them.
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* t = &m_tiles[i];
+		if (!t->header || !t->polyComponents) continue;
+		bool affected = t == tile;
+		for (int j = 0; j < t->componentCount && !affected; ++j)
+			affected = (marks[t->componentBase + j] & 2) != 0;
+		if (affected)
+			unionTileComponents(t);
+	}
+	
+	// Off-mesh links from neighbours may lead into the relabelled tile.
+	if (!removed)
+	{
+		static const int MAX_NEIS = 32;
+		dtMeshTile* neis[MAX_NEIS];
+		int nneis = getTilesAt(tile->header->x, tile->header->y, neis, MAX_NEIS);
+		for (int j = 0; j < nneis; ++j)
+		{
+			if (neis[j] == tile) continue;
+			unionTileComponents(neis[j]);
+		}
+		for (int i = 0; i < 8; ++i)
+		{
+			nneis = getNeighbourTilesAt(tile->header->x, tile->header->y, i, neis, MAX_NEIS);
+			for (int j = 0; j < nneis; ++j)
+				unionTileComponents(neis[j]);
+		}
+	}
+	
+	dtFree(marks);
+	
+	if (m_unusedComponentCount > m_componentCount/2)
+		rebuildComponents();
+	else
+		flattenComponents();
+}
+
+void dtNavMesh::rebuildComponents()
+{
+	m_componentCount = 0;
+	m_unusedComponentCount = 0;
+	m_componentsValid = true;
+	
+	int total = 0;
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		dtMeshTile* tile = &m_tiles[i];
+		if (!tile->header) continue;
+		if (!tile->polyComponents)
+			labelTileComponents(tile);
+		if (!tile->polyComponents)
+		{
+			m_componentsValid = false;
+			return;
+		}
+		tile->componentBase = (unsigned int)total;
+		total += tile->componentCount;
+	}
+	
+	if (!reserveComponents(total))
+	{
+		m_componentsValid = false;
+		return;
+	}
+	m_componentCount = total;
+	for (int i = 0; i < m_componentCount; ++i)
+		m_components[i] = (unsigned int)i;
+	
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		if (!m_tiles[i].header) continue;
+		unionTileComponents(&m_tiles[i]);
+	}
+	flattenComponents();
+}
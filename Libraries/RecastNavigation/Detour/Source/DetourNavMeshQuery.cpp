@@ -139,7 +139,9 @@ dtNavMeshQuery::dtNavMeshQuery() :
 	m_nav(0),
 	m_tinyNodePool(0),
 	m_nodePool(0),
-	m_openList(0)
+	m_openList(0),
+	m_backNodePool(0),
+	m_backOpenList(0)
 {
 	memset(&m_query, 0, sizeof(dtQueryData));
 }
@@ -152,9 +154,15 @@ dtNavMeshQuery::~dtNavMeshQuery()
 		m_nodePool->~dtNodePool();
 	if (m_openList)
 		m_openList->~dtNodeQueue();
+	if (m_backNodePool)
+		m_backNodePool->~dtNodePool();
+	if (m_backOpenList)
+		m_backOpenList->~dtNodeQueue();
 	dtFree(m_tinyNodePool);
 	dtFree(m_nodePool);
 	dtFree(m_openList);
+	dtFree(m_backNodePool);
+	dtFree(m_backOpenList);
 }
 
 /// @par 
@@ -163,7 +171,11 @@ dtNavMeshQuery::~dtNavMeshQuery()
 /// functions are used.
 ///
 /// This function can be used multiple times.
-dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
+///
+/// The backward search of #findPathBidirectional needs a second node pool
+/// and open list of @p maxNodes, which are only allocated when 
+/// @p bidirectional is set. Initializing without it frees them again.
+dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes, const bool bidirectional)
 {
 	m_nav = nav;
 	
@@ -213,6 +225,57 @@ dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 		m_openList->clear();
 	}
 	
+	if (!bidirectional)
+	{
+		if (m_backNodePool)
+		{
+			m_backNodePool->~dtNodePool();
+			dtFree(m_backNodePool);
+			m_backNodePool = 0;
+		}
+		if (m_backOpenList)
+		{
+			m_backOpenList->~dtNodeQueue();
+			dtFree(m_backOpenList);
+			m_backOpenList = 0;
+		}
+		return DT_SUCCESS;
+	}
+	
+	if (!m_backNodePool || m_backNodePool->getMaxNodes() < maxNodes)
+	{
+		if (m_backNodePool)
+		{
+			m_backNodePool->~dtNodePool();
+			dtFree(m_backNodePool);
+			m_backNodePool = 0;
+		}
+		m_backNodePool = new (dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM)) dtNodePool(maxNodes, dtNextPow2(maxNodes/4));
+		if (!m_backNodePool)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	else
+	{
+		m_backNodePool->clear();
+	}
+	
+	if (!m_backOpenList || m_backOpenList->getCapacity() < maxNodes)
+	{
+		if (m_backOpenList)
+		{
+			m_backOpenList->~dtNodeQueue();
+			dtFree(m_backOpenList);
+			m_backOpenList = 0;
+		}
+		m_backOpenList = new (dtAlloc(sizeof(dtNodeQueue), DT_ALLOC_PERM)) dtNodeQueue(maxNodes);
+		if (!m_backOpenList)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	else
+	{
+		m_backOpenList->clear();
+	}
+	
 	return DT_SUCCESS;
 }
 
@@ -668,6 +731,9 @@ dtStatus dtNavMeshQuery::queryPolygons(const float* center, const float* extents
 /// The start and end positions are used to calculate traversal costs. 
 /// (The y-values impact the result.)
 ///
+/// If the polygons are not connected at all (see dtNavMesh::isConnected),
+/// the query fails with #DT_UNREACHABLE without searching.
+///
 dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 								  const float* startPos, const float* endPos,
 								  const dtQueryFilter* filter,
@@ -696,6 +762,9 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 		return DT_SUCCESS;
 	}
 	
+	if (!m_nav->isConnected(startRef, endRef))
+		return DT_FAILURE | DT_UNREACHABLE;
+	
 	m_nodePool->clear();
 	m_openList->clear();
 	
@@ -878,6 +947,296 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 	return status;
 }
 
+static bool hasLinkTo(const dtMeshTile* tile, const dtPoly* poly, dtPolyRef ref)
+{
+	for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+	{
+		if (tile->links[i].ref == ref)
+			return true;
+	}
+	return false;
+}
+
+/// @par
+///
+/// Runs one A* search from the start polygon and one from the end polygon,
+/// each step expanding the side with the smaller open list. The search stops
+/// at the first polygon where the two searches meet, using the cheapest
+/// meeting found while expanding that node. Like #findPath the result is
+/// not guaranteed to be the shortest path, and it can differ slightly from
+/// the one #findPath returns.
+///
+/// The backward search uses the nodes of a second node pool, so each side
+/// is limited to the node count given to #init. The query must have been
+/// initialized with bidirectional set, otherwise #DT_INVALID_PARAM is
+/// returned.
+///
+/// If the searches do not meet, the path leads to the polygon the forward
+/// search got closest to the end polygon, and #DT_PARTIAL_RESULT is set.
+///
+/// If the path array is to small to hold the full result, it will be filled as 
+/// far as possible from the start polygon toward the end polygon.
+///
+dtStatus dtNavMeshQuery::findPathBidirectional(dtPolyRef startRef, dtPolyRef endRef,
+											   const float* startPos, const float* endPos,
+											   const dtQueryFilter* filter,
+											   dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	dtAssert(m_nav);
+	dtAssert(m_nodePool);
+	dtAssert(m_openList);
+	
+	*pathCount = 0;
+	
+	if (!m_backNodePool || !m_backOpenList)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	if (!startRef || !endRef)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	if (!maxPath)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	// Validate input
+	if (!m_nav->isValidPolyRef(startRef) || !m_nav->isValidPolyRef(endRef))
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	if (startRef == endRef)
+	{
+		path[0] = startRef;
+		*pathCount = 1;
+		return DT_SUCCESS;
+	}
+	
+	if (!m_nav->isConnected(startRef, endRef))
+		return DT_FAILURE | DT_UNREACHABLE;
+	
+	m_nodePool->clear();
+	m_openList->clear();
+	m_backNodePool->clear();
+	m_backOpenList->clear();
+	
+	dtNode* startNode = m_nodePool->getNode(startRef);
+	dtVcopy(startNode->pos, startPos);
+	startNode->pidx = 0;
+	startNode->cost = 0;
+	startNode->total = dtVdist(startPos, endPos) * H_SCALE;
+	startNode->id = startRef;
+	startNode->flags = DT_NODE_OPEN;
+	m_openList->push(startNode);
+	
+	dtNode* endNode = m_backNodePool->getNode(endRef);
+	dtVcopy(endNode->pos, endPos);
+	endNode->pidx = 0;
+	endNode->cost = 0;
+	endNode->total = dtVdist(startPos, endPos) * H_SCALE;
+	endNode->id = endRef;
+	endNode->flags = DT_NODE_OPEN;
+	m_backOpenList->push(endNode);
+	
+	dtNode* lastBestNode = startNode;
+	float lastBestNodeCost = startNode->total;
+	
+	dtNode* meetNode = 0;
+	dtNode* meetBackNode = 0;
+	float meetCost = FLT_MAX;
+	
+	dtStatus status = DT_SUCCESS;
+	
+	while (!m_openList->empty() || !m_backOpenList->empty())
+	{
+		// The searches have met.
+		if (meetNode)
+			break;
+		
+		// Expand the side with fewer open nodes.
+		bool forward;
+		if (m_openList->empty())
+			forward = false;
+		else if (m_backOpenList->empty())
+			forward = true;
+		else
+			forward = m_openList->getSize() <= m_backOpenList->getSize();
+		
+		dtNodePool* nodePool = forward ? m_nodePool : m_backNodePool;
+		dtNodeQueue* openList = forward ? m_openList : m_backOpenList;
+		dtNodePool* otherNodePool = forward ? m_backNodePool : m_nodePool;
+		const float* goalPos = forward ? endPos : startPos;
+		
+		// Remove node from open list and put it in closed list.
+		dtNode* bestNode = openList->pop();
+		bestNode->flags &= ~DT_NODE_OPEN;
+		bestNode->flags |= DT_NODE_CLOSED;
+		
+		// Get current poly and tile.
+		// The API input has been cheked already, skip checking internal data.
+		const dtPolyRef bestRef = bestNode->id;
+		const dtMeshTile* bestTile = 0;
+		const dtPoly* bestPoly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
+		
+		// Get parent poly and tile. For the backward search the parent is
+		// the next polygon toward the end.
+		dtPolyRef parentRef = 0;
+		const dtMeshTile* parentTile = 0;
+		const dtPoly* parentPoly = 0;
+		if (bestNode->pidx)
+			parentRef = nodePool->getNodeAtIdx(bestNode->pidx)->id;
+		if (parentRef)
+			m_nav->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
+		
+		for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
+		{
+			dtPolyRef neighbourRef = bestTile->links[i].ref;
+			
+			// Skip invalid ids and do not expand back to where we came from.
+			if (!neighbourRef || neighbourRef == parentRef)
+				continue;
+			
+			// Get neighbour poly and tile.
+			// The API input has been cheked already, skip checking internal data.
+			const dtMeshTile* neighbourTile = 0;
+			const dtPoly* neighbourPoly = 0;
+			m_nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+			
+			if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+				continue;
+			
+			// The backward search walks links in reverse, which is only
+			// allowed if the link goes both ways (one way off-mesh links).
+			if (!forward && !hasLinkTo(neighbourTile, neighbourPoly, bestRef))
+				continue;
+			
+			dtNode* neighbourNode = nodePool->getNode(neighbourRef);
+			if (!neighbourNode)
+			{
+				status |= DT_OUT_OF_NODES;
+				continue;
+			}
+			
+			// If the node is visited the first time, calculate node position.
+			if (neighbourNode->flags == 0)
+			{
+				getEdgeMidPoint(bestRef, bestPoly, bestTile,
+								neighbourRef, neighbourPoly, neighbourTile,
+								neighbourNode->pos);
+			}
+			
+			// Calculate cost and heuristic.
+			float curCost;
+			if (forward)
+			{
+				curCost = filter->getCost(bestNode->pos, neighbourNode->pos,
+										  parentRef, parentTile, parentPoly,
+										  bestRef, bestTile, bestPoly,
+										  neighbourRef, neighbourTile, neighbourPoly);
+			}
+			else
+			{
+				curCost = filter->getCost(neighbourNode->pos, bestNode->pos,
+										  neighbourRef, neighbourTile, neighbourPoly,
+										  bestRef, bestTile, bestPoly,
+										  parentRef, parentTile, parentPoly);
+			}
+			const float cost = bestNode->cost + curCost;
+			const float heuristic = dtVdist(neighbourNode->pos, goalPos)*H_SCALE;
+			const float total = cost + heuristic;
+			
+			// The node is already in open list and the new result is worse, skip.
+			if ((neighbourNode->flags & DT_NODE_OPEN) && total >= neighbourNode->total)
+				continue;
+			// The node is already visited and process, and the new result is worse, skip.
+			if ((neighbourNode->flags & DT_NODE_CLOSED) && total >= neighbourNode->total)
+				continue;
+			
+			// Add or update the node.
+			neighbourNode->pidx = nodePool->getNodeIdx(bestNode);
+			neighbourNode->id = neighbourRef;
+			neighbourNode->flags &= ~DT_NODE_CLOSED;
+			neighbourNode->cost = cost;
+			neighbourNode->total = total;
+			
+			if (neighbourNode->flags & DT_NODE_OPEN)
+			{
+				// Already in open, update node location.
+				openList->modify(neighbourNode);
+			}
+			else
+			{
+				// Put the node in open list.
+				neighbourNode->flags |= DT_NODE_OPEN;
+				openList->push(neighbourNode);
+			}
+			
+			// Update nearest node to target so far.
+			if (forward && heuristic < lastBestNodeCost)
+			{
+				lastBestNodeCost = heuristic;
+				lastBestNode = neighbourNode;
+			}
+			
+			// If the other search has visited the polygon too, the two
+			// halves join into a full path across it.
+			dtNode* otherNode = otherNodePool->findNode(neighbourRef);
+			if (otherNode && otherNode->flags)
+			{
+				dtNode* fwdNode = forward ? neighbourNode : otherNode;
+				dtNode* backNode = forward ? otherNode : neighbourNode;
+				const float acrossCost = filter->getCost(fwdNode->pos, backNode->pos,
+														 0, 0, 0,
+														 neighbourRef, neighbourTile, neighbourPoly,
+														 0, 0, 0);
+				const float pathCost = fwdNode->cost + acrossCost + backNode->cost;
+				if (pathCost < meetCost)
+				{
+					meetCost = pathCost;
+					meetNode = fwdNode;
+					meetBackNode = backNode;
+				}
+			}
+		}
+	}
+	
+	dtNode* lastNode = meetNode;
+	if (!lastNode)
+	{
+		lastNode = lastBestNode;
+		status |= DT_PARTIAL_RESULT;
+	}
+	
+	// Count the polygons of both halves.
+	int forwardCount = 0;
+	for (dtNode* node = lastNode; node; node = m_nodePool->getNodeAtIdx(node->pidx))
+		forwardCount++;
+	int backwardCount = 0;
+	if (meetBackNode)
+	{
+		for (dtNode* node = m_backNodePool->getNodeAtIdx(meetBackNode->pidx); node; node = m_backNodePool->getNodeAtIdx(node->pidx))
+			backwardCount++;
+	}
+	
+	// Store path, the forward half is stored in reverse.
+	int n = forwardCount;
+	for (dtNode* node = lastNode; node; node = m_nodePool->getNodeAtIdx(node->pidx))
+	{
+		--n;
+		if (n < maxPath)
+			path[n] = node->id;
+	}
+	n = forwardCount;
+	if (meetBackNode)
+	{
+		for (dtNode* node = m_backNodePool->getNodeAtIdx(meetBackNode->pidx); node && n < maxPath; node = m_backNodePool->getNodeAtIdx(node->pidx))
+			path[n++] = node->id;
+	}
+	
+	if (forwardCount + backwardCount > maxPath)
+		status |= DT_BUFFER_TOO_SMALL;
+	*pathCount = dtMin(forwardCount + backwardCount, maxPath);
+	
+	return status;
+}
+
 /// @par
 ///
 /// @warning Calling any non-slice methods before calling finalizeSlicedFindPath() 
@@ -916,6 +1275,12 @@ dtStatus dtNavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef
 		return DT_SUCCESS;
 	}
 	
+	if (!m_nav->isConnected(startRef, endRef))
+	{
+		m_query.status = DT_FAILURE | DT_UNREACHABLE;
+		return m_query.status;
+	}
+	
 	m_nodePool->clear();
 	m_openList->clear();
 	
@@ -34,87 +34,130 @@ inline unsigned int dtHashRef(dtPolyRef a)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
+
+/// @par
+///
+/// The key table has @p hashSize slots, but at least twice as many as there
+/// are nodes, which keeps the probe sequences short.
 dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 	m_nodes(0),
-	m_first(0),
-	m_next(0),
+	m_keys(0),
+	m_slots(0),
 	m_maxNodes(maxNodes),
-	m_hashSize(hashSize),
-	m_nodeCount(0)
+	m_hashSize(dtMax(hashSize, (int)dtNextPow2((unsigned int)maxNodes*2))),
+	m_nodeCount(0),
+	m_lookups(0),
+	m_probes(0),
+	m_maxProbe(0)
 {
 	dtAssert(dtNextPow2(m_hashSize) == (unsigned int)m_hashSize);
 	dtAssert(m_maxNodes > 0);
 
 	m_nodes = (dtNode*)dtAlloc(sizeof(dtNode)*m_maxNodes, DT_ALLOC_PERM);
-	m_next = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*m_maxNodes, DT_ALLOC_PERM);
-	m_first = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*hashSize, DT_ALLOC_PERM);
+	m_keys = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_hashSize, DT_ALLOC_PERM);
+	m_slots = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*m_hashSize, DT_ALLOC_PERM);
 
 	dtAssert(m_nodes);
-	dtAssert(m_next);
-	dtAssert(m_first);
+	dtAssert(m_keys);
+	dtAssert(m_slots);
 
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
-	memset(m_next, 0xff, sizeof(dtNodeIndex)*m_maxNodes);
+	memset(m_keys, 0, sizeof(dtPolyRef)*m_hashSize);
 }
 
 dtNodePool::~dtNodePool()
 {
 	dtFree(m_nodes);
-	dtFree(m_next);
-	dtFree(m_first);
+	dtFree(m_keys);
+	dtFree(m_slots);
 }
 
+/// @par
+///
+/// Only the slots of the used nodes are freed. They are freed newest first,
+/// so every key is still reachable from its home slot when it is removed.
 void dtNodePool::clear()
 {
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
+	const unsigned int mask = (unsigned int)m_hashSize-1;
+	for (int i = m_nodeCount-1; i >= 0; --i)
+	{
+		const dtPolyRef id = m_nodes[i].id;
+		unsigned int slot = dtHashRef(id) & mask;
+		while (m_keys[slot] != id)
+			slot = (slot+1) & mask;
+		m_keys[slot] = 0;
+	}
 	m_nodeCount = 0;
 }
 
 dtNode* dtNodePool::findNode(dtPolyRef id)
 {
-	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
-	while (i != DT_NULL_IDX)
+	if (!id) return 0;
+	const unsigned int mask = (unsigned int)m_hashSize-1;
+	unsigned int slot = dtHashRef(id) & mask;
+	int probes = 1;
+	while (m_keys[slot] && m_keys[slot] != id)
 	{
-		if (m_nodes[i].id == id)
-			return &m_nodes[i];
-		i = m_next[i];
+		slot = (slot+1) & mask;
+		probes++;
 	}
-	return 0;
+	recordProbes(probes);
+	
+	if (!m_keys[slot])
+		return 0;
+	return &m_nodes[m_slots[slot]];
 }
 
 dtNode* dtNodePool::getNode(dtPolyRef id)
 {
-	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
-	dtNode* node = 0;
-	while (i != DT_NULL_IDX)
+	if (!id) return 0;
+	const unsigned int mask = (unsigned int)m_hashSize-1;
+	unsigned int slot = dtHashRef(id) & mask;
+	int probes = 1;
+	while (m_keys[slot] && m_keys[slot] != id)
 	{
-		if (m_nodes[i].id == id)
-			return &m_nodes[i];
-		i = m_next[i];
+		slot = (slot+1) & mask;
+		probes++;
 	}
+	recordProbes(probes);
+	
+	if (m_keys[slot])
+		return &m_nodes[m_slots[slot]];
 	
 	if (m_nodeCount >= m_maxNodes)
 		return 0;
 	
-	i = (dtNodeIndex)m_nodeCount;
+	dtNodeIndex i = (dtNodeIndex)m_nodeCount;
 	m_nodeCount++;
 	
 	// Init node
-	node = &m_nodes[i];
+	dtNode* node = &m_nodes[i];
 	node->pidx = 0;
 	node->cost = 0;
 	node->total = 0;
 	node->id = id;
 	node->flags = 0;
+	node->heapIdx = -1;
 	
-	m_next[i] = m_first[bucket];
-	m_first[bucket] = i;
+	m_keys[slot] = id;
+	m_slots[slot] = i;
 	
 	return node;
 }
 
+void dtNodePool::getProbeStats(int* lookups, int* probes, int* maxProbe) const
+{
+	if (lookups) *lookups = m_lookups;
+	if (probes) *probes = m_probes;
+	if (maxProbe) *maxProbe = m_maxProbe;
+}
+
+void dtNodePool::resetProbeStats()
+{
+	m_lookups = 0;
+	m_probes = 0;
+	m_maxProbe = 0;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////
 dtNodeQueue::dtNodeQueue(int n) :
@@ -140,10 +183,12 @@ void dtNodeQueue::bubbleUp(int i, dtNode* node)
 	while ((i > 0) && (m_heap[parent]->total > node->total))
 	{
 		m_heap[i] = m_heap[parent];
+		m_heap[i]->heapIdx = i;
 		i = parent;
 		parent = (i-1)/2;
 	}
 	m_heap[i] = node;
+	node->heapIdx = i;
 }
 
 void dtNodeQueue::trickleDown(int i, dtNode* node)
@@ -157,6 +202,7 @@ void dtNodeQueue::trickleDown(int i, dtNode* node)
 			child++;
 		}
 		m_heap[i] = m_heap[child];
+		m_heap[i]->heapIdx = i;
 		i = child;
 		child = (i*2)+1;
 	}
@@ -19,6 +19,7 @@
 #ifndef DETOURCROWD_H
 #define DETOURCROWD_H
 
+#include "DetourCrowdConfig.h"
 #include "DetourNavMeshQuery.h"
 #include "DetourObstacleAvoidance.h"
 #include "DetourLocalBoundary.h"
@@ -27,16 +28,16 @@
 #include "DetourPathQueue.h"
 
 /// The maximum number of neighbors that a crowd agent can take into account
-/// for steering decisions.
+/// for steering decisions. (See: #DT_CROWD_MAX_NEIGHBOURS)
 /// @ingroup crowd
-static const int DT_CROWDAGENT_MAX_NEIGHBOURS = 6;
+static const int DT_CROWDAGENT_MAX_NEIGHBOURS = DT_CROWD_MAX_NEIGHBOURS;
 
 /// The maximum number of corners a crowd agent will look ahead in the path.
 /// This value is used for sizing the crowd agent corner buffers.
 /// Due to the behavior of the crowd manager, the actual number of useful
-/// corners will be one less than this number.
+/// corners will be one less than this number. (See: #DT_CROWD_MAX_CORNERS)
 /// @ingroup crowd
-static const int DT_CROWDAGENT_MAX_CORNERS = 4;
+static const int DT_CROWDAGENT_MAX_CORNERS = DT_CROWD_MAX_CORNERS;
 
 /// The maximum number of crowd avoidance configurations supported by the
 /// crowd manager.
@@ -45,6 +46,60 @@ static const int DT_CROWDAGENT_MAX_CORNERS = 4;
 ///		 dtCrowdAgentParams::obstacleAvoidanceType
 static const int DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS = 8;
 
+/// The maximum number of query filter types supported by the crowd manager.
+/// @ingroup crowd
+/// @see dtQueryFilter, dtCrowd::getFilter(), dtCrowd::getEditableFilter(),
+///		 dtCrowdAgentParams::queryFilterType
+static const int DT_CROWD_MAX_QUERY_FILTER_TYPE = 16;
+
+/// A magic number used to detect the compatibility of crowd states.
+/// @ingroup crowd
+static const int DT_CROWD_STATE_MAGIC = 'D'<<24 | 'C'<<16 | 'S'<<8 | 'T';
+
+/// A version number used to detect the compatibility of crowd states.
+/// @ingroup crowd
+static const int DT_CROWD_STATE_VERSION = 5;
+
+/// The phases of dtCrowd::update() that are timed.
+/// @ingroup crowd
+/// @see dtCrowd::setClock(), dtCrowd::getPhaseTime()
+enum dtCrowdUpdatePhase
+{
+	DT_CROWD_PHASE_PATH_VALIDITY,	///< Checking the path corridors for invalid polygons.
+	DT_CROWD_PHASE_MOVE_REQUESTS,	///< Move requests and the path queue.
+	DT_CROWD_PHASE_TOPOLOGY,		///< Path topology optimization.
+	DT_CROWD_PHASE_PROXIMITY,		///< Proximity grid, local boundaries and neighbour queries.
+	DT_CROWD_PHASE_STEERING,		///< Corners, off-mesh connection triggers and steering.
+	DT_CROWD_PHASE_AVOIDANCE,		///< Velocity planning.
+	DT_CROWD_PHASE_COLLISION,		///< Integration and collision handling.
+	DT_CROWD_PHASE_MOVE,			///< Moving the corridors and off-mesh connection animations.
+	DT_CROWD_MAX_PHASES,
+};
+
+/// Counts of the work done in the last dtCrowd::update().
+/// @ingroup crowd
+/// @see dtCrowd::getUpdateCounters()
+struct dtCrowdUpdateCounters
+{
+	int activeAgents;			///< The agents in the crowd.
+	int steppedAgents;			///< The agents stepped in the update. (See: dtCrowdAgentParams::updateInterval)
+	int replans;				///< The invalid paths that were requested again.
+	int pathIterations;			///< The search iterations used by the path queue.
+	int nodeLookups;			///< The node pool lookups of the path queue searches.
+	int nodeProbes;				///< The hash table slots read by those lookups.
+	int maxNodeProbe;			///< The most slots read by a single lookup.
+	int topologyOptimizations;	///< The corridors whose topology was optimized.
+	int boundaryUpdates;		///< The local boundaries that were updated.
+	int neighbours;				///< The sum of the neighbour counts of the stepped agents.
+	int velocitySamples;		///< The velocities sampled by obstacle avoidance.
+	int collisions;				///< The overlapping agent pairs pushed apart, over all iterations.
+};
+
+/// A clock for timing the crowd update.
+/// @return The current time, in ticks of any fixed length.
+/// @ingroup crowd
+typedef long long (*dtCrowdClockFunc)();
+
 /// Provides neighbor data for agents managed by the crowd.
 /// @ingroup crowd
 /// @see dtCrowdAgent::neis, dtCrowd
@@ -88,6 +143,13 @@ struct dtCrowdAgentParams
 	/// [Limits: 0 <= value <= #DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS]
 	unsigned char obstacleAvoidanceType;	
 
+	/// The index of the query filter used by this agent.
+	/// [Limits: 0 <= value < #DT_CROWD_MAX_QUERY_FILTER_TYPE]
+	unsigned char queryFilterType;
+
+	/// The number of crowd updates between steering updates of the agent. [Limit: >= 1]
+	unsigned char updateInterval;
+
 	/// User defined data attached to the agent.
 	void* userData;
 };
@@ -102,6 +164,9 @@ struct dtCrowdAgent
 	/// The type of mesh polygon the agent is traversing. (See: #CrowdAgentState)
 	unsigned char state;
 
+	/// 1 if the next update checks the whole path corridor, as a tile it runs through has changed.
+	unsigned char fullPathValidation;
+
 	/// The path corridor the agent is using.
 	dtPathCorridor corridor;
 
@@ -123,6 +188,9 @@ struct dtCrowdAgent
 	/// The desired speed.
 	float desiredSpeed;
 
+	/// The time since the agent was last stepped. (See: dtCrowdAgentParams::updateInterval)
+	float pendingTime;
+
 	float npos[3];		///< The current agent position. [(x, y, z)]
 	float disp[3];
 	float dvel[3];		///< The desired velocity of the agent. [(x, y, z)]
@@ -189,16 +257,25 @@ class dtCrowd
 	dtObstacleAvoidanceQuery* m_obstacleQuery;
 	
 	dtProximityGrid* m_grid;
+	dtWallSegmentCache* m_wallCache;
 	
 	dtPolyRef* m_pathResult;
 	int m_maxPathResult;
 	
 	float m_ext[3];
-	dtQueryFilter m_filter;
+	dtQueryFilter m_filters[DT_CROWD_MAX_QUERY_FILTER_TYPE];
 	
 	float m_maxAgentRadius;
 
-	int m_velocitySampleCount;
+	dtCrowdUpdateCounters m_counters;
+	unsigned int m_updateCount;
+	int m_updateSlices;
+	int m_maxPathIterations;
+
+	dtCrowdClockFunc m_clock;
+	long long m_phaseTimes[DT_CROWD_MAX_PHASES];
+
+	bool m_fullPathValidation;
 
 	enum MoveRequestState
 	{
@@ -210,7 +287,7 @@ class dtCrowd
 		MR_TARGET_ADJUST,
 	};
 	
-	static const int MAX_TEMP_PATH = 32;
+	static const int MAX_TEMP_PATH = DT_CROWD_MAX_TEMP_PATH;
 
 	struct MoveRequest
 	{
@@ -239,6 +316,11 @@ class dtCrowd
 
 	bool requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos);
 
+	void endPhase(const int phase, long long& start);
+
+	int writeState(unsigned char* data) const;
+	bool readState(const unsigned char* data, const int dataSize, const bool apply);
+
 	void purge();
 	
 public:
@@ -306,6 +388,12 @@ public:
 	/// @return True if the request was successfully submitted.
 	bool adjustMoveTarget(const int idx, dtPolyRef ref, const float* pos);
 
+	/// Gets the agents whose move requests are not yet resolved.
+	///  @param[out]	idx		The agent indices. [Size: >= @p maxIdx]
+	///  @param[in]		maxIdx	The maximum number of indices to return.
+	/// @return The number of indices returned.
+	int getPendingMoveTargets(int* idx, const int maxIdx) const;
+
 	/// Gets the active agents int the agent pool.
 	///  @param[out]	agents		An array of agent pointers. [(#dtCrowdAgent *) * maxAgents]
 	///  @param[in]		maxAgents	The size of the crowd agent array.
@@ -316,14 +404,91 @@ public:
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
 	void update(const float dt, dtCrowdAgentDebugInfo* debug);
-	
-	/// Gets the filter used by the crowd.
-	/// @return The filter used by the crowd.
-	const dtQueryFilter* getFilter() const { return &m_filter; }
 
-	/// Gets the filter used by the crowd.
-	/// @return The filter used by the crowd.
-	dtQueryFilter* getEditableFilter() { return &m_filter; }
+	/// Makes the next #update() validate every polygon in each agent's path corridor,
+	/// instead of only the first few. Use after navigation mesh tiles have been rebuilt,
+	/// so that agents replan around the change before they reach it. Also invalidates
+	/// the wall segment cache.
+	void requestFullPathValidation() { m_fullPathValidation = true; invalidateWallCache(); }
+
+	/// Empties the wall segment cache and makes every agent update its local boundary.
+	/// Use after polygon flags have changed.
+	void invalidateWallCache() { if (m_wallCache) m_wallCache->invalidate(); }
+
+	/// Makes the next #update() validate the whole path corridor of the agents whose corridors
+	/// run through the tiles at a location, and refreshes the wall segments around them.
+	/// Use instead of #requestFullPathValidation() after the tiles there have been rebuilt.
+	///  @param[in]		tx		The x-location of the rebuilt tiles.
+	///  @param[in]		ty		The y-location of the rebuilt tiles.
+	void requestTilePathValidation(const int tx, const int ty);
+
+	/// Gets the cache of polygon wall segments used for the local boundaries.
+	/// @return The wall segment cache.
+	const dtWallSegmentCache* getWallCache() const { return m_wallCache; }
+
+	/// Sets the number of slices the agents are split into for the expensive phases of #update().
+	///  @param[in]		slices	The number of slices. [Limit: >= 1]
+	void setUpdateSlices(const int slices) { m_updateSlices = slices > 1 ? slices : 1; }
+
+	/// Gets the number of slices the agents are split into for the expensive phases of #update().
+	/// @return The number of slices.
+	int getUpdateSlices() const { return m_updateSlices; }
+
+	/// Sets the number of pathfinder iterations the path queue may use in each #update().
+	///  @param[in]		maxIters	The maximum number of iterations. [Limit: >= 1]
+	void setMaxPathIterations(const int maxIters) { m_maxPathIterations = maxIters > 1 ? maxIters : 1; }
+
+	/// Gets the number of pathfinder iterations the path queue may use in each #update().
+	/// @return The maximum number of iterations.
+	int getMaxPathIterations() const { return m_maxPathIterations; }
+
+	/// Sets the clock used to time the phases of #update().
+	///  @param[in]		clock	The clock, or null to stop timing.
+	void setClock(dtCrowdClockFunc clock) { m_clock = clock; }
+
+	/// Gets the time the specified phase took in the last #update().
+	///  @param[in]		phase	The phase. [Limits: 0 <= value < #DT_CROWD_MAX_PHASES]
+	/// @return The time in ticks of the clock, or zero if no clock is set.
+	long long getPhaseTime(const int phase) const { return (phase >= 0 && phase < DT_CROWD_MAX_PHASES) ? m_phaseTimes[phase] : 0; }
+	
+	/// @{
+	/// @name State Management
+	/// These functions save and load the simulation state of the agents. They do not
+	/// cover the crowd configuration. (Filters, avoidance settings, etc.)
+
+	/// Gets the size of the buffer required by #storeState to store the current state.
+	/// @return The size of the buffer required to store the state.
+	int getStateSize() const;
+
+	/// Stores the state of all active agents and their move requests in the specified buffer.
+	///  @param[out]	data			The buffer to store the state in.
+	///  @param[in]		maxDataSize		The size of the data buffer. [Limit: >= #getStateSize]
+	/// @return The status flags for the operation.
+	dtStatus storeState(unsigned char* data, const int maxDataSize) const;
+
+	/// Restores the state of the agents. Agents that are not in the state are removed.
+	///  @param[in]		data			The state. (Obtained from #storeState.)
+	///  @param[in]		maxDataSize		The size of the state within the data buffer.
+	/// @return The status flags for the operation.
+	dtStatus restoreState(const unsigned char* data, const int maxDataSize);
+
+	/// @}
+	
+	/// Gets the specified query filter.
+	///  @param[in]		i	The index of the filter. [Limits: 0 <= value < #DT_CROWD_MAX_QUERY_FILTER_TYPE]
+	/// @return The requested filter.
+	const dtQueryFilter* getFilter(const int i) const { return (i >= 0 && i < DT_CROWD_MAX_QUERY_FILTER_TYPE) ? &m_filters[i] : 0; }
+
+	/// Gets the specified query filter for editing. Invalidates the wall segment cache.
+	///  @param[in]		i	The index of the filter. [Limits: 0 <= value < #DT_CROWD_MAX_QUERY_FILTER_TYPE]
+	/// @return The requested filter.
+	dtQueryFilter* getEditableFilter(const int i)
+	{
+		if (i < 0 || i >= DT_CROWD_MAX_QUERY_FILTER_TYPE)
+			return 0;
+		invalidateWallCache();
+		return &m_filters[i];
+	}
 
 	/// Gets the search extents [(x, y, z)] used by the crowd for query operations. 
 	/// @return The search extents used by the crowd. [(x, y, z)]
@@ -331,7 +496,11 @@ public:
 	
 	/// Gets the velocity sample count.
 	/// @return The velocity sample count.
-	inline int getVelocitySampleCount() const { return m_velocitySampleCount; }
+	inline int getVelocitySampleCount() const { return m_counters.velocitySamples; }
+
+	/// Gets the counts of the work done in the last #update().
+	/// @return The counters.
+	const dtCrowdUpdateCounters& getUpdateCounters() const { return m_counters; }
 	
 	/// Gets the crowd's proximity grid.
 	/// @return The crowd's proximity grid.
@@ -405,7 +574,6 @@ distance planning and provide the crowd manager with intermediate targets.
 
 Other significant limitations:
 
-- All agents using the crowd manager will use the same #dtQueryFilter.
 - Crowd management is relatively expensive. The maximum agents under crowd 
   management at any one time is between 20 and 30.  A good place to start
   is a maximum of 25 agents for 0.5ms per frame.
@@ -425,6 +593,48 @@ is the index of the #dtObstacleAvoidanceParams within the crowd.
 @see dtObstacleAvoidanceParams, dtCrowd::setObstacleAvoidanceParams(), 
 	 dtCrowd::getObstacleAvoidanceParams()
 
+@var dtCrowdAgentParams::queryFilterType
+@par
+
+#dtCrowd keeps a small table of query filters so that agents of different
+types can use different area costs and polygon flags. This value is the
+index of the agent's filter in that table. Every query the crowd makes for
+the agent, including its path requests, uses this filter.
+
+@see dtQueryFilter, dtCrowd::getFilter(), dtCrowd::getEditableFilter()
+
+@fn void dtCrowd::setUpdateSlices(const int slices)
+@par
+
+With more than one slice, each #update() refreshes the local boundaries, the neighbour 
+lists and the avoidance velocities of only one slice of the agents, taking the slices 
+in turn. The other agents reuse their last results: their neighbour lists drop the 
+agents that have since been removed, and their last avoidance velocity is kept but 
+slowed down to the desired speed. A local boundary is still refreshed out of turn once 
+the agent has moved the full collision query range away from it.
+
+The phase times from #getPhaseTime() can be used to pick the number of slices that 
+keeps the update within a budget.
+
+@fn void dtCrowd::setMaxPathIterations(const int maxIters)
+@par
+
+Path searches that run out of iterations continue in the next update, so by default 
+the update a path arrives in depends on the other searches in the queue. With enough 
+iterations for every search to finish, a path always arrives in the update after its 
+request was made, at the cost of a longer update when many agents request paths at once. 
+The slice an agent is in and the update a path arrives in are both restored by 
+#restoreState(), which makes the crowd replay the same way from a stored state.
+
+@var dtCrowdAgentParams::updateInterval
+@par
+
+Agents that need less accuracy, such as agents far from the camera, can be stepped 
+less often. An agent with an interval of @e n is steered, integrated and moved along 
+its corridor once every @e n calls to dtCrowd::update(), over the time that passed 
+since its last step. In between it still takes part in the neighbour queries of other 
+agents. Path validity is checked every update regardless of the interval.
+
 @var dtCrowdAgentParams::collisionQueryRange
 @par
 
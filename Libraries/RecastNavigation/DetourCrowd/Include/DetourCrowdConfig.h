@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifndef DETOURCROWDCONFIG_H
+#define DETOURCROWDCONFIG_H
+
+// Compile-time limits of the crowd. The defaults suit a few hundred agents.
+//
+// Define DT_CROWD_DENSE to take more neighbours, walls and corners into
+// account in packed crowds, or DT_CROWD_LIGHTWEIGHT for smaller agents
+// in sparse ones. Any single limit can also be defined on its own. The
+// same definitions must be used for the crowd library and everything
+// that includes its headers, as they change the size of dtCrowdAgent.
+
+#if defined(DT_CROWD_DENSE)
+
+#ifndef DT_CROWD_MAX_NEIGHBOURS
+#define DT_CROWD_MAX_NEIGHBOURS 16
+#endif
+#ifndef DT_CROWD_MAX_CORNERS
+#define DT_CROWD_MAX_CORNERS 4
+#endif
+#ifndef DT_CROWD_MAX_LOCAL_SEGS
+#define DT_CROWD_MAX_LOCAL_SEGS 16
+#endif
+#ifndef DT_CROWD_MAX_LOCAL_POLYS
+#define DT_CROWD_MAX_LOCAL_POLYS 32
+#endif
+#ifndef DT_CROWD_MAX_GRID_QUERY
+#define DT_CROWD_MAX_GRID_QUERY 64
+#endif
+#ifndef DT_CROWD_MAX_TEMP_PATH
+#define DT_CROWD_MAX_TEMP_PATH 64
+#endif
+
+#elif defined(DT_CROWD_LIGHTWEIGHT)
+
+#ifndef DT_CROWD_MAX_NEIGHBOURS
+#define DT_CROWD_MAX_NEIGHBOURS 4
+#endif
+#ifndef DT_CROWD_MAX_CORNERS
+#define DT_CROWD_MAX_CORNERS 3
+#endif
+#ifndef DT_CROWD_MAX_LOCAL_SEGS
+#define DT_CROWD_MAX_LOCAL_SEGS 4
+#endif
+#ifndef DT_CROWD_MAX_LOCAL_POLYS
+#define DT_CROWD_MAX_LOCAL_POLYS 8
+#endif
+#ifndef DT_CROWD_MAX_GRID_QUERY
+#define DT_CROWD_MAX_GRID_QUERY 16
+#endif
+#ifndef DT_CROWD_MAX_TEMP_PATH
+#define DT_CROWD_MAX_TEMP_PATH 16
+#endif
+
+#endif
+
+/// The maximum number of neighbours an agent steers around. [Limit: >= 1]
+#ifndef DT_CROWD_MAX_NEIGHBOURS
+#define DT_CROWD_MAX_NEIGHBOURS 6
+#endif
+
+/// The number of path corners an agent looks ahead, plus one. [Limit: >= 2]
+#ifndef DT_CROWD_MAX_CORNERS
+#define DT_CROWD_MAX_CORNERS 4
+#endif
+
+/// The maximum number of wall segments in an agent's local boundary. [Limit: >= 1]
+#ifndef DT_CROWD_MAX_LOCAL_SEGS
+#define DT_CROWD_MAX_LOCAL_SEGS 8
+#endif
+
+/// The maximum number of polygons searched for an agent's local boundary. [Limit: >= 1]
+#ifndef DT_CROWD_MAX_LOCAL_POLYS
+#define DT_CROWD_MAX_LOCAL_POLYS 16
+#endif
+
+/// The maximum number of agents taken from the proximity grid when looking for 
+/// neighbours, before the nearest #DT_CROWD_MAX_NEIGHBOURS are picked. [Limit: >= 1]
+#ifndef DT_CROWD_MAX_GRID_QUERY
+#define DT_CROWD_MAX_GRID_QUERY 32
+#endif
+
+/// The maximum length of the path kept for a target that is moved while its path
+/// is being searched for. [Limit: >= 1]
+#ifndef DT_CROWD_MAX_TEMP_PATH
+#define DT_CROWD_MAX_TEMP_PATH 32
+#endif
+
+#endif // DETOURCROWDCONFIG_H
@@ -19,13 +19,15 @@
 #ifndef DETOURLOCALBOUNDARY_H
 #define DETOURLOCALBOUNDARY_H
 
+#include "DetourCrowdConfig.h"
 #include "DetourNavMeshQuery.h"
+#include "DetourWallSegmentCache.h"
 
 
 class dtLocalBoundary
 {
-	static const int MAX_LOCAL_SEGS = 8;
-	static const int MAX_LOCAL_POLYS = 16;
+	static const int MAX_LOCAL_SEGS = DT_CROWD_MAX_LOCAL_SEGS;
+	static const int MAX_LOCAL_POLYS = DT_CROWD_MAX_LOCAL_POLYS;
 	
 	struct Segment
 	{
@@ -39,6 +41,8 @@ class dtLocalBoundary
 	
 	dtPolyRef m_polys[MAX_LOCAL_POLYS];
 	int m_npolys;
+	
+	unsigned int m_generation;	///< Generation of the wall segment cache the segments came from.
 
 	void addSegment(const float dist, const float* seg);
 	
@@ -49,13 +53,26 @@ public:
 	void reset();
 	
 	void update(dtPolyRef ref, const float* pos, const float collisionQueryRange,
-				dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+				dtNavMeshQuery* navquery, const dtQueryFilter* filter,
+				dtWallSegmentCache* cache = 0);
 	
 	bool isValid(dtNavMeshQuery* navquery, const dtQueryFilter* filter);
 	
+	/// Checks the boundary against the cache it was last updated from, without querying 
+	/// the polygons. The boundary is valid until the cache is invalidated.
+	inline bool isValid(const dtWallSegmentCache* cache) const { return m_npolys > 0 && m_generation == cache->getGeneration(); }
+	
+	/// Marks the boundary as up to date with the current generation of the cache.
+	inline void setCacheGeneration(const dtWallSegmentCache* cache) { m_generation = cache->getGeneration(); }
+	
 	inline const float* getCenter() const { return m_center; }
 	inline int getSegmentCount() const { return m_nsegs; }
 	inline const float* getSegment(int i) const { return m_segs[i].s; }
+	inline int getPolyCount() const { return m_npolys; }
+	inline dtPolyRef getPoly(int i) const { return m_polys[i]; }
+	
+	/// The maximum number of segments in a boundary.
+	static int getMaxSegments() { return MAX_LOCAL_SEGS; }
 };
 
 #endif // DETOURLOCALBOUNDARY_H
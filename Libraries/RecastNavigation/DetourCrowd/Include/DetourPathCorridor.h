@@ -105,6 +105,14 @@ public:
 	///  @param[in]		npath		The number of polygons in the path.
 	void setCorridor(const float* target, const dtPolyRef* polys, const int npath);
 	
+	/// Loads a complete corridor, including the current position. (E.g. from a stored crowd state.)
+	///  @param[in]		pos			The position within the first polygon of the path. [(x, y, z)]
+	///  @param[in]		target		The target location within the last polygon of the path. [(x, y, z)]
+	///  @param[in]		path		The path corridor. [(polyRef) * @p npath]
+	///  @param[in]		npath		The number of polygons in the path. [Limits: 0 <= value <= #getMaxPath()]
+	/// @return True if the path fit in the corridor.
+	bool restore(const float* pos, const float* target, const dtPolyRef* path, const int npath);
+	
 	/// Gets the current position within the corridor. (In the first polygon.)
 	/// @return The current position within the corridor.
 	inline const float* getPos() const { return m_pos; }
@@ -128,6 +136,10 @@ public:
 	/// The number of polygons in the current corridor path.
 	/// @return The number of polygons in the current corridor path.
 	inline int getPathCount() const { return m_npath; } 	
+
+	/// The maximum number of polygons the corridor can hold.
+	/// @return The maximum number of polygons the corridor can hold.
+	inline int getMaxPath() const { return m_maxPath; }
 };
 
 int dtMergeCorridorStartMoved(dtPolyRef* path, const int npath, const int maxPath,
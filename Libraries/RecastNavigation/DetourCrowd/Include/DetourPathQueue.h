@@ -40,7 +40,7 @@ class dtPathQueue
 		/// State.
 		dtStatus status;
 		int keepAlive;
-		const dtQueryFilter* filter; ///< TODO: This is potentially dangerous!
+		const dtQueryFilter* filter; ///< Not copied. Must outlive the request.
 	};
 	
 	static const int MAX_QUEUE = 8;
@@ -58,7 +58,9 @@ public:
 	
 	bool init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav);
 	
-	void update(const int maxIters);
+	/// Runs the queued searches for up to @p maxIters iterations in total.
+	/// @return The number of iterations used.
+	int update(const int maxIters);
 	
 	dtPathQueueRef request(dtPolyRef startRef, dtPolyRef endRef,
 						   const float* startPos, const float* endPos, 
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifndef DETOURWALLSEGMENTCACHE_H
+#define DETOURWALLSEGMENTCACHE_H
+
+#include "DetourNavMeshQuery.h"
+
+/// Caches the wall segments of polygons for the local boundaries of the crowd agents.
+/// @ingroup crowd
+class dtWallSegmentCache
+{
+	struct Entry
+	{
+		dtPolyRef ref;
+		const dtQueryFilter* filter;
+		int firstSeg;
+		int nsegs;
+		int next;
+	};
+	Entry* m_entries;
+	int m_maxEntries;
+	int m_nentries;
+	
+	int* m_buckets;
+	int m_bucketsSize;
+	
+	float* m_segs;
+	int m_maxSegs;
+	int m_nsegs;
+	
+	unsigned int m_generation;
+	int m_hitCount;
+	int m_missCount;
+	
+	void flush();
+	
+public:
+	dtWallSegmentCache();
+	~dtWallSegmentCache();
+	
+	/// Initializes the cache.
+	///  @param[in]		maxPolys	The maximum number of polygons to cache. [Limit: > 0]
+	///  @param[in]		maxSegs		The maximum number of segments to cache. [Limit: > 0]
+	/// @return True if the initialization succeeded.
+	bool init(const int maxPolys, const int maxSegs);
+	
+	/// Empties the cache and starts a new generation. Call after the navigation mesh
+	/// or the query filters have changed.
+	void invalidate();
+	
+	/// Drops the entries of the polygons in a block of tiles, and of polygons whose tile
+	/// has been removed. The generation does not change.
+	///  @param[in]		nav		The navigation mesh the polygons belong to.
+	///  @param[in]		minx	The lowest x-location of the tiles.
+	///  @param[in]		miny	The lowest y-location of the tiles.
+	///  @param[in]		maxx	The highest x-location of the tiles.
+	///  @param[in]		maxy	The highest y-location of the tiles.
+	void invalidateTiles(const dtNavMesh* nav, const int minx, const int miny, const int maxx, const int maxy);
+	
+	/// Gets the wall segments of a polygon, querying and caching them if they are not
+	/// in the cache yet.
+	///  @param[in]		ref			The reference of the polygon.
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[in]		navquery	The query to use on a cache miss.
+	///  @param[out]	segs		The segments. Valid until the next call. [(ax, ay, az, bx, by, bz) * segmentCount]
+	/// @return The number of segments.
+	int getWallSegments(dtPolyRef ref, const dtQueryFilter* filter,
+						const dtNavMeshQuery* navquery, const float** segs);
+	
+	/// Gets the generation of the cache, which changes with every #invalidate().
+	inline unsigned int getGeneration() const { return m_generation; }
+	
+	inline int getHitCount() const { return m_hitCount; }
+	inline int getMissCount() const { return m_missCount; }
+	void resetStats() { m_hitCount = 0; m_missCount = 0; }
+};
+
+/// Checks if a polygon is in a block of tiles. A polygon whose tile has been removed is
+/// counted as in the block, as the location it had is not known anymore.
+///  @param[in]		nav		The navigation mesh the polygon belongs to.
+///  @param[in]		ref		The reference of the polygon. It may be stale.
+///  @param[in]		minx	The lowest x-location of the tiles.
+///  @param[in]		miny	The lowest y-location of the tiles.
+///  @param[in]		maxx	The highest x-location of the tiles.
+///  @param[in]		maxy	The highest y-location of the tiles.
+/// @return True if the polygon's tile is in the block, or has been removed.
+bool dtPolyInTiles(const dtNavMesh* nav, dtPolyRef ref, const int minx, const int miny, const int maxx, const int maxy);
+
+dtWallSegmentCache* dtAllocWallSegmentCache();
+void dtFreeWallSegmentCache(dtWallSegmentCache* ptr);
+
+#endif // DETOURWALLSEGMENTCACHE_H
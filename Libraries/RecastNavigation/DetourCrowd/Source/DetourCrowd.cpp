@@ -25,6 +25,7 @@
 #include "DetourCrowd.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
+#include "DetourNode.h"
 #include "DetourObstacleAvoidance.h"
 #include "DetourCommon.h"
 #include "DetourAssert.h"
@@ -190,11 +191,11 @@ static int addNeighbour(const int idx, const float dist,
 
 static int getNeighbours(const float* pos, const float height, const float range,
 						 const dtCrowdAgent* skip, dtCrowdNeighbour* result, const int maxResult,
-						 dtCrowdAgent** agents, const int /*nagents*/, dtProximityGrid* grid)
+						 const dtCrowdAgent* agents, dtProximityGrid* grid)
 {
 	int n = 0;
 	
-	static const int MAX_NEIS = 32;
+	static const int MAX_NEIS = DT_CROWD_MAX_GRID_QUERY;
 	unsigned short ids[MAX_NEIS];
 	int nids = grid->queryItems(pos[0]-range, pos[2]-range,
 								pos[0]+range, pos[2]+range,
@@ -202,7 +203,7 @@ static int getNeighbours(const float* pos, const float height, const float range
 	
 	for (int i = 0; i < nids; ++i)
 	{
-		const dtCrowdAgent* ag = agents[ids[i]];
+		const dtCrowdAgent* ag = &agents[ids[i]];
 		
 		if (ag == skip) continue;
 		
@@ -266,14 +267,21 @@ dtCrowd::dtCrowd() :
 	m_agentAnims(0),
 	m_obstacleQuery(0),
 	m_grid(0),
+	m_wallCache(0),
 	m_pathResult(0),
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
-	m_velocitySampleCount(0),
+	m_updateCount(0),
+	m_updateSlices(1),
+	m_maxPathIterations(MAX_ITERS_PER_UPDATE),
+	m_clock(0),
+	m_fullPathValidation(false),
 	m_moveRequests(0),
 	m_moveRequestCount(0),
 	m_navquery(0)
 {
+	memset(&m_counters, 0, sizeof(m_counters));
+	memset(m_phaseTimes, 0, sizeof(m_phaseTimes));
 }
 
 dtCrowd::~dtCrowd()
@@ -304,6 +312,9 @@ void dtCrowd::purge()
 	
 	dtFreeProximityGrid(m_grid);
 	m_grid = 0;
+	
+	dtFreeWallSegmentCache(m_wallCache);
+	m_wallCache = 0;
 
 	dtFreeObstacleAvoidanceQuery(m_obstacleQuery);
 	m_obstacleQuery = 0;
@@ -330,10 +341,16 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	if (!m_grid->init(m_maxAgents*4, maxAgentRadius*3))
 		return false;
 	
+	m_wallCache = dtAllocWallSegmentCache();
+	if (!m_wallCache)
+		return false;
+	if (!m_wallCache->init(dtMax(256, m_maxAgents*4), dtMax(256, m_maxAgents*4)*8))
+		return false;
+	
 	m_obstacleQuery = dtAllocObstacleAvoidanceQuery();
 	if (!m_obstacleQuery)
 		return false;
-	if (!m_obstacleQuery->init(6, 8))
+	if (!m_obstacleQuery->init(DT_CROWDAGENT_MAX_NEIGHBOURS, dtLocalBoundary::getMaxSegments()))
 		return false;
 
 	// Init obstacle query params.
@@ -463,10 +480,11 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 	// Find nearest position on navmesh and place the agent there.
 	float nearest[3];
 	dtPolyRef ref;
-	m_navquery->findNearestPoly(pos, m_ext, &m_filter, &ref, nearest);
+	m_navquery->findNearestPoly(pos, m_ext, &m_filters[params->queryFilterType], &ref, nearest);
 	
 	ag->corridor.reset(ref, nearest);
 	ag->boundary.reset();
+	ag->fullPathValidation = 0;
 
 	updateAgentParameters(idx, params);
 	
@@ -479,8 +497,11 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 	dtVcopy(ag->npos, nearest);
 	
 	ag->desiredSpeed = 0;
+	ag->pendingTime = 0;
 	ag->t = 0;
-	ag->var = (rand() % 10) / 9.0f;
+	// Derived from the slot rather than rand() so that every peer of a
+	// replicated crowd gets the same value.
+	ag->var = ((idx * 7) % 10) / 9.0f;
 
 	if (ref)
 		ag->state = DT_CROWDAGENT_STATE_WALKING;
@@ -523,6 +544,19 @@ const dtCrowd::MoveRequest* dtCrowd::getActiveMoveTarget(const int idx) const
 	return req;
 }
 
+/// @par
+///
+/// A request stays pending while its path is searched, which may take
+/// several updates when the path queue is busy, and is resolved once the
+/// agent's corridor has been set or the request has failed.
+int dtCrowd::getPendingMoveTargets(int* idx, const int maxIdx) const
+{
+	int n = 0;
+	for (int i = 0; i < m_moveRequestCount && n < maxIdx; ++i)
+		idx[n++] = m_moveRequests[i].idx;
+	return n;
+}
+
 bool dtCrowd::requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos)
 {
 	if (idx < 0 || idx > m_maxAgents)
@@ -668,6 +702,325 @@ int dtCrowd::getActiveAgents(dtCrowdAgent** agents, const int maxAgents)
 }
 
 
+struct dtCrowdStateHeader
+{
+	int magic;
+	int version;
+	int maxAgents;
+	int agentSize;
+	int agentCount;
+	int moveRequestCount;
+	int fullPathValidation;
+	unsigned int updateCount;
+};
+
+// Appends to the state, or only counts its size when data is null.
+static void dtWriteState(unsigned char* data, int& size, const void* v, const int n)
+{
+	if (data)
+		memcpy(data + size, v, n);
+	size += n;
+}
+
+// Reads from the state, or only skips when v is null.
+static bool dtReadState(const unsigned char* data, const int dataSize, int& pos, void* v, const int n)
+{
+	if (n < 0 || pos + n > dataSize)
+		return false;
+	if (v)
+		memcpy(v, data + pos, n);
+	pos += n;
+	return true;
+}
+
+int dtCrowd::writeState(unsigned char* data) const
+{
+	int size = 0;
+	
+	dtCrowdStateHeader header;
+	header.magic = DT_CROWD_STATE_MAGIC;
+	header.version = DT_CROWD_STATE_VERSION;
+	header.maxAgents = m_maxAgents;
+	header.agentSize = sizeof(dtCrowdAgent);
+	header.agentCount = 0;
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		if (m_agents[i].active)
+			header.agentCount++;
+	}
+	header.moveRequestCount = m_moveRequestCount;
+	header.fullPathValidation = m_fullPathValidation ? 1 : 0;
+	header.updateCount = m_updateCount;
+	dtWriteState(data, size, &header, sizeof(header));
+	
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		const dtCrowdAgent* ag = &m_agents[i];
+		if (!ag->active)
+			continue;
+		
+		// Counts and small fields are stored as ints to keep the record aligned.
+		const int state = ag->state;
+		const int fullPathValidation = ag->fullPathValidation;
+		const int npath = ag->corridor.getPathCount();
+		dtWriteState(data, size, &i, sizeof(int));
+		dtWriteState(data, size, &state, sizeof(int));
+		dtWriteState(data, size, &fullPathValidation, sizeof(int));
+		dtWriteState(data, size, &ag->t, sizeof(float));
+		dtWriteState(data, size, &ag->var, sizeof(float));
+		dtWriteState(data, size, &ag->topologyOptTime, sizeof(float));
+		dtWriteState(data, size, &ag->nneis, sizeof(int));
+		dtWriteState(data, size, ag->neis, sizeof(dtCrowdNeighbour)*ag->nneis);
+		dtWriteState(data, size, &ag->desiredSpeed, sizeof(float));
+		dtWriteState(data, size, &ag->pendingTime, sizeof(float));
+		dtWriteState(data, size, ag->npos, sizeof(float)*3);
+		dtWriteState(data, size, ag->disp, sizeof(float)*3);
+		dtWriteState(data, size, ag->dvel, sizeof(float)*3);
+		dtWriteState(data, size, ag->nvel, sizeof(float)*3);
+		dtWriteState(data, size, ag->vel, sizeof(float)*3);
+		dtWriteState(data, size, &ag->params, sizeof(dtCrowdAgentParams));
+		dtWriteState(data, size, &ag->ncorners, sizeof(int));
+		dtWriteState(data, size, ag->cornerVerts, sizeof(float)*3*ag->ncorners);
+		dtWriteState(data, size, ag->cornerFlags, sizeof(unsigned char)*DT_CROWDAGENT_MAX_CORNERS);
+		dtWriteState(data, size, ag->cornerPolys, sizeof(dtPolyRef)*ag->ncorners);
+		dtWriteState(data, size, ag->corridor.getPos(), sizeof(float)*3);
+		dtWriteState(data, size, ag->corridor.getTarget(), sizeof(float)*3);
+		dtWriteState(data, size, &npath, sizeof(int));
+		dtWriteState(data, size, ag->corridor.getPath(), sizeof(dtPolyRef)*npath);
+		// The local boundary has no pointers, so it is stored as is.
+		dtWriteState(data, size, &ag->boundary, sizeof(dtLocalBoundary));
+		dtWriteState(data, size, &m_agentAnims[i], sizeof(dtCrowdAgentAnimation));
+	}
+	
+	dtWriteState(data, size, m_moveRequests, sizeof(MoveRequest)*m_moveRequestCount);
+	
+	return size;
+}
+
+bool dtCrowd::readState(const unsigned char* data, const int dataSize, const bool apply)
+{
+	int pos = 0;
+	
+	dtCrowdStateHeader header;
+	if (!dtReadState(data, dataSize, pos, &header, sizeof(header)))
+		return false;
+	if (header.agentCount < 0 || header.agentCount > m_maxAgents ||
+		header.moveRequestCount < 0 || header.moveRequestCount > m_maxAgents)
+		return false;
+	
+	if (apply)
+	{
+		for (int i = 0; i < m_maxAgents; ++i)
+			m_agents[i].active = 0;
+	}
+	
+	// The active agent list is only used during update, so it marks the agents in the state
+	// here, for checking the move requests against.
+	memset(m_activeAgents, 0, sizeof(dtCrowdAgent*)*m_maxAgents);
+	
+	for (int n = 0; n < header.agentCount; ++n)
+	{
+		int idx = -1;
+		if (!dtReadState(data, dataSize, pos, &idx, sizeof(int)) || idx < 0 || idx >= m_maxAgents)
+			return false;
+		if (m_activeAgents[idx])
+			return false;
+		m_activeAgents[idx] = &m_agents[idx];
+		
+		// Validation only reads the counts and skips the rest.
+		dtCrowdAgent* ag = &m_agents[idx];
+		int state = 0, fullPathValidation = 0;
+		int nneis = 0, ncorners = 0, npath = 0;
+		float cpos[3], ctarget[3];
+		bool ok = true;
+		ok = ok && dtReadState(data, dataSize, pos, &state, sizeof(int));
+		ok = ok && dtReadState(data, dataSize, pos, &fullPathValidation, sizeof(int));
+		ok = ok && dtReadState(data, dataSize, pos, apply ? &ag->t : 0, sizeof(float));
+		ok = ok && dtReadState(data, dataSize, pos, apply ? &ag->var : 0, sizeof(float));
+		ok = ok && dtReadState(data, dataSize, pos, apply ? &ag->topologyOptTime : 0, sizeof(float));
+		ok = ok && dtReadState(data, dataSize, pos, &nneis, sizeof(int));
+		ok = ok && nneis >= 0 && nneis <= DT_CROWDAGENT_MAX_NEIGHBOURS;
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->neis : 0, sizeof(dtCrowdNeighbour)*nneis);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? &ag->desiredSpeed : 0, sizeof(float));
+		ok = ok && dtReadState(data, dataSize, pos, apply ? &ag->pendingTime : 0, sizeof(float));
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->npos : 0, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->disp : 0, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->dvel : 0, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->nvel : 0, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->vel : 0, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? &ag->params : 0, sizeof(dtCrowdAgentParams));
+		ok = ok && dtReadState(data, dataSize, pos, &ncorners, sizeof(int));
+		ok = ok && ncorners >= 0 && ncorners <= DT_CROWDAGENT_MAX_CORNERS;
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->cornerVerts : 0, sizeof(float)*3*ncorners);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->cornerFlags : 0, sizeof(unsigned char)*DT_CROWDAGENT_MAX_CORNERS);
+		ok = ok && dtReadState(data, dataSize, pos, apply ? ag->cornerPolys : 0, sizeof(dtPolyRef)*ncorners);
+		ok = ok && dtReadState(data, dataSize, pos, cpos, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, ctarget, sizeof(float)*3);
+		ok = ok && dtReadState(data, dataSize, pos, &npath, sizeof(int));
+		ok = ok && npath >= 0 && npath <= ag->corridor.getMaxPath();
+		if (!ok)
+			return false;
+		
+		const dtPolyRef* path = (const dtPolyRef*)(data + pos);
+		if (!dtReadState(data, dataSize, pos, 0, sizeof(dtPolyRef)*npath))
+			return false;
+		if (!dtReadState(data, dataSize, pos, apply ? &ag->boundary : 0, sizeof(dtLocalBoundary)))
+			return false;
+		if (!dtReadState(data, dataSize, pos, apply ? &m_agentAnims[idx] : 0, sizeof(dtCrowdAgentAnimation)))
+			return false;
+		
+		if (apply)
+		{
+			ag->active = 1;
+			ag->state = (unsigned char)state;
+			ag->fullPathValidation = (unsigned char)(fullPathValidation != 0);
+			ag->nneis = nneis;
+			ag->ncorners = ncorners;
+			ag->corridor.restore(cpos, ctarget, path, npath);
+		}
+	}
+	
+	// Each request must be for a different agent in the state, as the update indexes the
+	// agents and the adjusted path with them.
+	const MoveRequest* reqs = (const MoveRequest*)(data + pos);
+	if (!dtReadState(data, dataSize, pos, 0, sizeof(MoveRequest)*header.moveRequestCount))
+		return false;
+	for (int i = 0; i < header.moveRequestCount; ++i)
+	{
+		MoveRequest req;
+		memcpy(&req, &reqs[i], sizeof(MoveRequest));
+		if (req.idx < 0 || req.idx >= m_maxAgents || !m_activeAgents[req.idx])
+			return false;
+		if (req.ntemp < 0 || req.ntemp > MAX_TEMP_PATH)
+			return false;
+		m_activeAgents[req.idx] = 0;
+	}
+	if (apply)
+		memcpy(m_moveRequests, reqs, sizeof(MoveRequest)*header.moveRequestCount);
+	
+	if (apply)
+	{
+		m_moveRequestCount = header.moveRequestCount;
+		m_fullPathValidation = header.fullPathValidation != 0;
+		m_updateCount = header.updateCount;
+		
+		// Path queue searches are not part of the state, so pending requests start over.
+		for (int i = 0; i < m_moveRequestCount; ++i)
+		{
+			MoveRequest* req = &m_moveRequests[i];
+			if (req->state == MR_TARGET_WAITING_FOR_PATH)
+			{
+				req->state = MR_TARGET_REQUESTING;
+				req->pathqRef = DT_PATHQ_INVALID;
+			}
+		}
+	}
+	
+	return true;
+}
+
+int dtCrowd::getStateSize() const
+{
+	return writeState(0);
+}
+
+/// @par
+///
+/// The state holds the agents' positions, velocities, path corridors, local boundaries,
+/// neighbours and pending move requests, but not the crowd configuration. It is only valid
+/// for a crowd with the same maximum agent count, and the polygon references in it are
+/// only valid until the navigation mesh tiles they belong to change.
+/// @see #getStateSize, #restoreState
+dtStatus dtCrowd::storeState(unsigned char* data, const int maxDataSize) const
+{
+	if (!data)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	if (maxDataSize < getStateSize())
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+	writeState(data);
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// The whole state is validated before any agent is changed, so a failed restore leaves
+/// the crowd as it was. Path requests that were still being searched for when the state
+/// was stored are requested again. A state stored by a crowd built with different
+/// limits (See: DetourCrowdConfig.h) is rejected. The local boundaries are restored as they were stored
+/// and are not updated until the agents move away from them, so the navigation mesh
+/// must be in the state it was in when the crowd state was stored.
+/// @see #storeState
+dtStatus dtCrowd::restoreState(const unsigned char* data, const int maxDataSize)
+{
+	if (!data || maxDataSize < (int)sizeof(dtCrowdStateHeader))
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	dtCrowdStateHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != DT_CROWD_STATE_MAGIC)
+		return DT_FAILURE | DT_WRONG_MAGIC;
+	if (header.version != DT_CROWD_STATE_VERSION)
+		return DT_FAILURE | DT_WRONG_VERSION;
+	if (header.maxAgents != m_maxAgents || header.agentSize != (int)sizeof(dtCrowdAgent))
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	if (!readState(data, maxDataSize, false))
+		return DT_FAILURE | DT_INVALID_PARAM;
+	readState(data, maxDataSize, true);
+	
+	// The stored boundaries are as good as the ones the cache would give now.
+	m_wallCache->invalidate();
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		if (m_agents[i].active)
+			m_agents[i].boundary.setCacheGeneration(m_wallCache);
+	}
+	
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// Only the agents whose path corridors run through the tiles have their whole corridor
+/// checked, and only the boundaries and cached wall segments of the polygons in the tiles
+/// and their neighbours are refreshed, which keeps the cost of a small change small.
+/// @see #requestFullPathValidation
+void dtCrowd::requestTilePathValidation(const int tx, const int ty)
+{
+	const dtNavMesh* nav = m_navquery->getAttachedNavMesh();
+	
+	// The neighbours of the tiles have gained or lost portals into them.
+	if (m_wallCache)
+		m_wallCache->invalidateTiles(nav, tx-1, ty-1, tx+1, ty+1);
+	
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		dtCrowdAgent* ag = &m_agents[i];
+		if (!ag->active)
+			continue;
+		
+		const dtPolyRef* path = ag->corridor.getPath();
+		const int npath = ag->corridor.getPathCount();
+		for (int j = 0; j < npath; ++j)
+		{
+			if (dtPolyInTiles(nav, path[j], tx, ty, tx, ty))
+			{
+				ag->fullPathValidation = 1;
+				break;
+			}
+		}
+		
+		for (int j = 0; j < ag->boundary.getPolyCount(); ++j)
+		{
+			if (dtPolyInTiles(nav, ag->boundary.getPoly(j), tx-1, ty-1, tx+1, ty+1))
+			{
+				ag->boundary.reset();
+				break;
+			}
+		}
+	}
+}
+
 void dtCrowd::updateMoveRequest(const float /*dt*/)
 {
 	// Fire off new requests.
@@ -686,7 +1039,7 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 			if (req->state == MR_TARGET_ADJUST)
 			{
 				// Adjust existing path.
-				ag->corridor.moveTargetPosition(req->apos, m_navquery, &m_filter);
+				ag->corridor.moveTargetPosition(req->apos, m_navquery, &m_filters[ag->params.queryFilterType]);
 				req->state = MR_TARGET_VALID;
 			}
 			else
@@ -696,7 +1049,7 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				static const int MAX_VISITED = 16;
 				dtPolyRef visited[MAX_VISITED];
 				int nvisited = 0;
-				m_navquery->moveAlongSurface(req->temp[req->ntemp-1], req->pos, req->apos, &m_filter,
+				m_navquery->moveAlongSurface(req->temp[req->ntemp-1], req->pos, req->apos, &m_filters[ag->params.queryFilterType],
 											 result, visited, &nvisited, MAX_VISITED);
 				req->ntemp = dtMergeCorridorEndMoved(req->temp, req->ntemp, MAX_TEMP_PATH, visited, nvisited);
 				dtVcopy(req->pos, result);
@@ -716,13 +1069,13 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				float agentPos[3];
 				dtVcopy(agentPos, ag->npos);
 				dtPolyRef agentRef = ag->corridor.getFirstPoly();
-				if (!m_navquery->isValidPolyRef(agentRef, &m_filter))
+				if (!m_navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
 				{
 					// Current location is not valid, try to reposition.
 					// TODO: this can snap agents, how to handle that?
 					float nearest[3];
 					agentRef = 0;
-					m_navquery->findNearestPoly(ag->npos, m_ext, &m_filter, &agentRef, nearest);
+					m_navquery->findNearestPoly(ag->npos, m_ext, &m_filters[ag->params.queryFilterType], &agentRef, nearest);
 					dtVcopy(agentPos, nearest);
 				}
 				if (!agentRef)
@@ -745,7 +1098,7 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				dtPolyRef reqRef = ag->corridor.getLastPoly();
 				float reqPos[3];
 				dtVcopy(reqPos, ag->corridor.getTarget());
-				req->pathqRef = m_pathq.request(reqRef, req->ref, reqPos, req->pos, &m_filter);
+				req->pathqRef = m_pathq.request(reqRef, req->ref, reqPos, req->pos, &m_filters[ag->params.queryFilterType]);
 				if (req->pathqRef != DT_PATHQ_INVALID)
 				{
 					req->state = MR_TARGET_WAITING_FOR_PATH;
@@ -766,7 +1119,7 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				reqPath[0] = path[0];
 				int reqPathCount = 1;
 				
-				req->pathqRef = m_pathq.request(reqPath[reqPathCount-1], req->ref, reqPos, req->pos, &m_filter);
+				req->pathqRef = m_pathq.request(reqPath[reqPathCount-1], req->ref, reqPos, req->pos, &m_filters[ag->params.queryFilterType]);
 				if (req->pathqRef != DT_PATHQ_INVALID)
 				{
 					ag->corridor.setCorridor(reqPos, reqPath, reqPathCount);
@@ -778,7 +1131,14 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 
 	
 	// Update requests.
-	m_pathq.update(MAX_ITERS_PER_UPDATE);
+	dtNodePool* pathNodes = m_pathq.getNavQuery()->getNodePool();
+	pathNodes->resetProbeStats();
+	m_counters.pathIterations += m_pathq.update(m_maxPathIterations);
+	int lookups, probes, maxProbe;
+	pathNodes->getProbeStats(&lookups, &probes, &maxProbe);
+	m_counters.nodeLookups += lookups;
+	m_counters.nodeProbes += probes;
+	m_counters.maxNodeProbe = dtMax(m_counters.maxNodeProbe, maxProbe);
 
 	// Process path results.
 	for (int i = 0; i < m_moveRequestCount; ++i)
@@ -792,6 +1152,9 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 			dtStatus status = m_pathq.getRequestStatus(req->pathqRef);
 			if (dtStatusFailed(status))
 			{
+				// Free the queue slot now instead of waiting for it to expire.
+				int nres = 0;
+				m_pathq.getPathResult(req->pathqRef, m_pathResult, &nres, m_maxPathResult);
 				req->pathqRef = DT_PATHQ_INVALID;
 				req->state = MR_TARGET_FAILED;
 			}
@@ -962,8 +1325,9 @@ void dtCrowd::updateTopologyOptimization(dtCrowdAgent** agents, const int nagent
 	for (int i = 0; i < nqueue; ++i)
 	{
 		dtCrowdAgent* ag = queue[i];
-		ag->corridor.optimizePathTopology(m_navquery, &m_filter);
+		ag->corridor.optimizePathTopology(m_navquery, &m_filters[ag->params.queryFilterType]);
 		ag->topologyOptTime = 0;
+		m_counters.topologyOptimizations++;
 	}
 
 }
@@ -980,7 +1344,10 @@ void dtCrowd::checkPathValidty(dtCrowdAgent** agents, const int nagents, const f
 			continue;
 		
 		// Skip if the corridor is valid
-		if (ag->corridor.isValid(CHECK_LOOKAHEAD, m_navquery, &m_filter))
+		const bool fullPath = m_fullPathValidation || ag->fullPathValidation;
+		ag->fullPathValidation = 0;
+		const int lookAhead = fullPath ? ag->corridor.getPathCount() : CHECK_LOOKAHEAD;
+		if (ag->corridor.isValid(lookAhead, m_navquery, &m_filters[ag->params.queryFilterType]))
 			continue;
 
 		// The current path is bad, try to recover.
@@ -1015,13 +1382,13 @@ void dtCrowd::checkPathValidty(dtCrowdAgent** agents, const int nagents, const f
 		}
 		
 		// First check that the current location is valid.
-		if (!m_navquery->isValidPolyRef(agentRef, &m_filter))
+		if (!m_navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
 		{
 			// Current location is not valid, try to reposition.
 			// TODO: this can snap agents, how to handle that?
 			float nearest[3];
 			agentRef = 0;
-			m_navquery->findNearestPoly(ag->npos, m_ext, &m_filter, &agentRef, nearest);
+			m_navquery->findNearestPoly(ag->npos, m_ext, &m_filters[ag->params.queryFilterType], &agentRef, nearest);
 			dtVcopy(agentPos, nearest);
 		}
 
@@ -1036,18 +1403,18 @@ void dtCrowd::checkPathValidty(dtCrowdAgent** agents, const int nagents, const f
 		
 		// TODO: make temp path by raycasting towards current velocity.
 		
-		ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filter);
+		ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filters[ag->params.queryFilterType]);
 		ag->boundary.reset();
 		dtVcopy(ag->npos, agentPos);
 		
 		
 		// Check that target is still reachable.
-		if (!m_navquery->isValidPolyRef(targetRef, &m_filter))
+		if (!m_navquery->isValidPolyRef(targetRef, &m_filters[ag->params.queryFilterType]))
 		{
 			// Current target is not valid, try to reposition.
 			float nearest[3];
 			targetRef = 0;
-			m_navquery->findNearestPoly(targetPos, m_ext, &m_filter, &targetRef, nearest);
+			m_navquery->findNearestPoly(targetPos, m_ext, &m_filters[ag->params.queryFilterType], &targetRef, nearest);
 			dtVcopy(targetPos, nearest);
 		}
 		
@@ -1059,13 +1426,27 @@ void dtCrowd::checkPathValidty(dtCrowdAgent** agents, const int nagents, const f
 		}
 		
 		// Try to replan path to goal.
-		requestMoveTargetReplan(idx, targetRef, targetPos);
+		if (requestMoveTargetReplan(idx, targetRef, targetPos))
+			m_counters.replans++;
 	}
+
+	m_fullPathValidation = false;
 }
 	
+void dtCrowd::endPhase(const int phase, long long& start)
+{
+	if (!m_clock)
+		return;
+	const long long now = m_clock();
+	m_phaseTimes[phase] += now - start;
+	start = now;
+}
+
 void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 {
-	m_velocitySampleCount = 0;
+	memset(&m_counters, 0, sizeof(m_counters));
+	memset(m_phaseTimes, 0, sizeof(m_phaseTimes));
+	long long phaseStart = m_clock ? m_clock() : 0;
 	
 	const int debugIdx = debug ? debug->idx : -1;
 	
@@ -1074,12 +1455,36 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 	
 	// Check that all agents still have valid paths.
 	checkPathValidty(agents, nagents, dt);
+	endPhase(DT_CROWD_PHASE_PATH_VALIDITY, phaseStart);
 	
 	// Update async move request and path finder.
 	updateMoveRequest(dt);
+	endPhase(DT_CROWD_PHASE_MOVE_REQUESTS, phaseStart);
+	
+	// The slice of agents whose boundaries, neighbours and avoidance are refreshed.
+	const int slice = (int)(m_updateCount % (unsigned int)m_updateSlices);
+	
+	// Move the agents that are stepped this update to the front of the list.
+	// The others stay in the list so that they are still seen as neighbours.
+	int nstep = 0;
+	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		ag->pendingTime += dt;
+		const int interval = ag->params.updateInterval > 1 ? ag->params.updateInterval : 1;
+		if ((m_updateCount + (unsigned int)getAgentIndex(ag)) % (unsigned int)interval == 0)
+		{
+			dtSwap(agents[i], agents[nstep]);
+			nstep++;
+		}
+	}
+	m_updateCount++;
+	m_counters.activeAgents = nagents;
+	m_counters.steppedAgents = nstep;
 
 	// Optimize path topology.
-	updateTopologyOptimization(agents, nagents, dt);
+	updateTopologyOptimization(agents, nstep, dt);
+	endPhase(DT_CROWD_PHASE_TOPOLOGY, phaseStart);
 	
 	// Register agents to proximity grid.
 	m_grid->clear();
@@ -1093,34 +1498,42 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		{
 			const float* p = ag->npos;
 			const float r = ag->params.radius;
-			m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
+			m_grid->addItem((unsigned short)getAgentIndex(ag), p[0]-r, p[2]-r, p[0]+r, p[2]+r);
 		}
 	}
 	
 	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
+		const bool refresh = getAgentIndex(ag) % m_updateSlices == slice;
 
 		// Update the collision boundary after certain distance has been passed or
-		// if it has become invalid.
-		const float updateThr = ag->params.collisionQueryRange*0.25f;
+		// if it has become invalid. Outside of its slice only a boundary that has
+		// been left behind altogether is updated.
+		const float updateThr = ag->params.collisionQueryRange * (refresh ? 0.25f : 1.0f);
 		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filter))
+			(refresh && !ag->boundary.isValid(m_wallCache)))
 		{
 			ag->boundary.update(ag->corridor.getFirstPoly(), 
 								ag->npos, 
 								ag->params.collisionQueryRange,
 								m_navquery, 
-								&m_filter);
+								&m_filters[ag->params.queryFilterType],
+								m_wallCache);
+			m_counters.boundaryUpdates++;
 		}
 		// Query neighbour agents
-		if (ag->params.updateFlags & (
+		if (!(ag->params.updateFlags & (
 				DT_CROWD_OBSTACLE_AVOIDANCE | 
 				DT_CROWD_SEPARATION | 
-				DT_CROWD_COLLISION_RESOLUTION))
+				DT_CROWD_COLLISION_RESOLUTION)))
+		{
+			ag->nneis = 0;
+		}
+		else if (refresh)
 		{
 			ag->nneis = getNeighbours(ag->npos, 
 									  ag->params.height, 
@@ -1128,18 +1541,26 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 									  ag, 
 									  ag->neis, 
 									  DT_CROWDAGENT_MAX_NEIGHBOURS,
-									  agents, 
-									  nagents, 
+									  m_agents, 
 									  m_grid);
 		}
 		else
 		{
-			ag->nneis = 0;
+			// Keep the last neighbours that are still in the crowd.
+			int n = 0;
+			for (int j = 0; j < ag->nneis; ++j)
+			{
+				if (m_agents[ag->neis[j].idx].active)
+					ag->neis[n++] = ag->neis[j];
+			}
+			ag->nneis = n;
 		}
+		m_counters.neighbours += ag->nneis;
 	}
+	endPhase(DT_CROWD_PHASE_PROXIMITY, phaseStart);
 	
 	// Find next corner to steer to.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
@@ -1148,17 +1569,17 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		
 		// Find corners for steering
 		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filter);
+												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
 		
 		// Check to see if the corner after the next corner is directly visible,
 		// and short cut to there.
 		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
 		{
 			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filter);
+			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
 			
 			// Copy data for debug purposes.
-			if (debugIdx == i)
+			if (debugIdx == getAgentIndex(ag))
 			{
 				dtVcopy(debug->optStart, ag->corridor.getPos());
 				dtVcopy(debug->optEnd, target);
@@ -1167,7 +1588,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		else
 		{
 			// Copy data for debug purposes.
-			if (debugIdx == i)
+			if (debugIdx == getAgentIndex(ag))
 			{
 				dtVset(debug->optStart, 0,0,0);
 				dtVset(debug->optEnd, 0,0,0);
@@ -1176,7 +1597,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 	}
 	
 	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
@@ -1216,7 +1637,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 	}
 		
 	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 
@@ -1285,22 +1706,34 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		dtVcopy(ag->dvel, dvel);
 	}
 	
+	endPhase(DT_CROWD_PHASE_STEERING, phaseStart);
+	
 	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
 		
-		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
+		if ((ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE) &&
+			getAgentIndex(ag) % m_updateSlices != slice)
+		{
+			// Outside of its slice, keep the last safe velocity but do not let
+			// it go faster than the desired velocity.
+			const float speedSqr = dtVlenSqr(ag->nvel);
+			const float desiredSqr = dtVlenSqr(ag->dvel);
+			if (speedSqr > desiredSqr)
+				dtVscale(ag->nvel, ag->nvel, sqrtf(desiredSqr/speedSqr));
+		}
+		else if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
 		{
 			m_obstacleQuery->reset();
 			
 			// Add neighbours as obstacles.
 			for (int j = 0; j < ag->nneis; ++j)
 			{
-				const dtCrowdAgent* nei = agents[ag->neis[j].idx];
+				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
 				float mult;
 				if (ag->params.updateFlags & DT_CROWD_AGENT_PRIORITIES)
 				{
@@ -1327,7 +1760,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			}
 
 			dtObstacleAvoidanceDebugData* vod = 0;
-			if (debugIdx == i) 
+			if (debugIdx == getAgentIndex(ag))
 				vod = debug->vod;
 			
 			// Sample new safe velocity.
@@ -1346,7 +1779,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
 														 ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
-			m_velocitySampleCount += ns;
+			m_counters.velocitySamples += ns;
 		}
 		else
 		{
@@ -1354,14 +1787,15 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			dtVcopy(ag->nvel, ag->dvel);
 		}
 	}
+	endPhase(DT_CROWD_PHASE_AVOIDANCE, phaseStart);
 
 	// Integrate.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
-		integrate(ag, dt);
+		integrate(ag, ag->pendingTime);
 	}
 	
 	// Handle collisions.
@@ -1369,7 +1803,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 	
 	for (int iter = 0; iter < 4; ++iter)
 	{
-		for (int i = 0; i < nagents; ++i)
+		for (int i = 0; i < nstep; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
 			const int idx0 = getAgentIndex(ag);
@@ -1386,7 +1820,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 
 			for (int j = 0; j < ag->nneis; ++j)
 			{
-				const dtCrowdAgent* nei = agents[ag->neis[j].idx];
+				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
 				const int idx1 = getAgentIndex(nei);
 
 				float diff[3];
@@ -1426,6 +1860,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		
 				
 				w += 1.0f;
+				m_counters.collisions++;
 			}
 			
 			if (w > 0.0001f)
@@ -1435,7 +1870,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			}
 		}
 		
-		for (int i = 0; i < nagents; ++i)
+		for (int i = 0; i < nstep; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
 			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
@@ -1445,25 +1880,30 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		}
 	}
 	
-	for (int i = 0; i < nagents; ++i)
+	endPhase(DT_CROWD_PHASE_COLLISION, phaseStart);
+	
+	for (int i = 0; i < nstep; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
 		
 		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filter);
+		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
 		// Get valid constrained position back.
 		dtVcopy(ag->npos, ag->corridor.getPos());
 	}
 	
+	for (int i = 0; i < nstep; ++i)
+		agents[i]->pendingTime = 0;
+	
 	// Update agents using off-mesh connection.
 	for (int i = 0; i < m_maxAgents; ++i)
 	{
 		dtCrowdAgentAnimation* anim = &m_agentAnims[i];
 		if (!anim->active)
 			continue;
-		dtCrowdAgent* ag = agents[i];
+		dtCrowdAgent* ag = &m_agents[i];
 
 		anim->t += dt;
 		if (anim->t > anim->tmax)
@@ -1493,7 +1933,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		dtVset(ag->vel, 0,0,0);
 		dtVset(ag->dvel, 0,0,0);
 	}
-	
+	endPhase(DT_CROWD_PHASE_MOVE, phaseStart);
 }
 
 
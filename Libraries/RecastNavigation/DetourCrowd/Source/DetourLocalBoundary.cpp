@@ -26,7 +26,8 @@
 
 dtLocalBoundary::dtLocalBoundary() :
 	m_nsegs(0),
-	m_npolys(0)
+	m_npolys(0),
+	m_generation(0)
 {
 	dtVset(m_center, FLT_MAX,FLT_MAX,FLT_MAX);
 }
@@ -82,7 +83,8 @@ void dtLocalBoundary::addSegment(const float dist, const float* s)
 }
 
 void dtLocalBoundary::update(dtPolyRef ref, const float* pos, const float collisionQueryRange,
-							 dtNavMeshQuery* navquery, const dtQueryFilter* filter)
+							 dtNavMeshQuery* navquery, const dtQueryFilter* filter,
+							 dtWallSegmentCache* cache)
 {
 	static const int MAX_SEGS_PER_POLY = DT_VERTS_PER_POLYGON*3;
 	
@@ -95,6 +97,8 @@ void dtLocalBoundary::update(dtPolyRef ref, const float* pos, const float collis
 	}
 	
 	dtVcopy(m_center, pos);
+	if (cache)
+		m_generation = cache->getGeneration();
 	
 	// First query non-overlapping polygons.
 	navquery->findLocalNeighbourhood(ref, pos, collisionQueryRange,
@@ -102,11 +106,15 @@ void dtLocalBoundary::update(dtPolyRef ref, const float* pos, const float collis
 	
 	// Secondly, store all polygon edges.
 	m_nsegs = 0;
-	float segs[MAX_SEGS_PER_POLY*6];
+	float buf[MAX_SEGS_PER_POLY*6];
+	const float* segs = buf;
 	int nsegs = 0;
 	for (int j = 0; j < m_npolys; ++j)
 	{
-		navquery->getPolyWallSegments(m_polys[j], filter, segs, 0, &nsegs, MAX_SEGS_PER_POLY);
+		if (cache)
+			nsegs = cache->getWallSegments(m_polys[j], filter, navquery, &segs);
+		else
+			navquery->getPolyWallSegments(m_polys[j], filter, buf, 0, &nsegs, MAX_SEGS_PER_POLY);
 		for (int k = 0; k < nsegs; ++k)
 		{
 			const float* s = &segs[k*6];
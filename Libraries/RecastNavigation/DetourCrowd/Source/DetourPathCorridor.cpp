@@ -510,6 +510,20 @@ void dtPathCorridor::setCorridor(const float* target, const dtPolyRef* path, con
 	m_npath = npath;
 }
 
+bool dtPathCorridor::restore(const float* pos, const float* target, const dtPolyRef* path, const int npath)
+{
+	dtAssert(m_path);
+	
+	if (npath < 0 || npath > m_maxPath)
+		return false;
+	
+	dtVcopy(m_pos, pos);
+	dtVcopy(m_target, target);
+	memcpy(m_path, path, sizeof(dtPolyRef)*npath);
+	m_npath = npath;
+	return true;
+}
+
 bool dtPathCorridor::trimInvalidPath(dtPolyRef safeRef, const float* safePos,
 									 dtNavMeshQuery* navquery, const dtQueryFilter* filter)
 {
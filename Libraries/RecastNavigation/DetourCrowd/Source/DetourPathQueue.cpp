@@ -74,7 +74,7 @@ bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, dtNa
 	return true;
 }
 
-void dtPathQueue::update(const int maxIters)
+int dtPathQueue::update(const int maxIters)
 {
 	static const int MAX_KEEP_ALIVE = 2; // in update ticks.
 
@@ -130,6 +130,8 @@ void dtPathQueue::update(const int maxIters)
 
 		m_queueHead++;
 	}
+	
+	return dtMax(maxIters - iterCount, 0);
 }
 
 dtPathQueueRef dtPathQueue::request(dtPolyRef startRef, dtPolyRef endRef,
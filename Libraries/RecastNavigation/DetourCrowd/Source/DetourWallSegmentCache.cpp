@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#include <string.h>
+#include <new>
+#include "DetourWallSegmentCache.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+
+
+dtWallSegmentCache* dtAllocWallSegmentCache()
+{
+	void* mem = dtAlloc(sizeof(dtWallSegmentCache), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtWallSegmentCache;
+}
+
+void dtFreeWallSegmentCache(dtWallSegmentCache* ptr)
+{
+	if (!ptr) return;
+	ptr->~dtWallSegmentCache();
+	dtFree(ptr);
+}
+
+
+inline unsigned int hashRef(dtPolyRef a)
+{
+	a += ~(a<<15);
+	a ^=  (a>>10);
+	a +=  (a<<3);
+	a ^=  (a>>6);
+	a += ~(a<<11);
+	a ^=  (a>>16);
+	return (unsigned int)a;
+}
+
+
+dtWallSegmentCache::dtWallSegmentCache() :
+	m_entries(0),
+	m_maxEntries(0),
+	m_nentries(0),
+	m_buckets(0),
+	m_bucketsSize(0),
+	m_segs(0),
+	m_maxSegs(0),
+	m_nsegs(0),
+	m_generation(0),
+	m_hitCount(0),
+	m_missCount(0)
+{
+}
+
+dtWallSegmentCache::~dtWallSegmentCache()
+{
+	dtFree(m_entries);
+	dtFree(m_buckets);
+	dtFree(m_segs);
+}
+
+bool dtWallSegmentCache::init(const int maxPolys, const int maxSegs)
+{
+	dtAssert(maxPolys > 0);
+	dtAssert(maxSegs > 0);
+	
+	dtFree(m_entries);
+	dtFree(m_buckets);
+	dtFree(m_segs);
+	
+	m_maxEntries = maxPolys;
+	m_entries = (Entry*)dtAlloc(sizeof(Entry)*m_maxEntries, DT_ALLOC_PERM);
+	if (!m_entries)
+		return false;
+	
+	m_bucketsSize = dtNextPow2(maxPolys);
+	m_buckets = (int*)dtAlloc(sizeof(int)*m_bucketsSize, DT_ALLOC_PERM);
+	if (!m_buckets)
+		return false;
+	
+	m_maxSegs = maxSegs;
+	m_segs = (float*)dtAlloc(sizeof(float)*6*m_maxSegs, DT_ALLOC_PERM);
+	if (!m_segs)
+		return false;
+	
+	invalidate();
+	resetStats();
+	
+	return true;
+}
+
+void dtWallSegmentCache::flush()
+{
+	memset(m_buckets, 0xff, sizeof(int)*m_bucketsSize);
+	m_nentries = 0;
+	m_nsegs = 0;
+}
+
+void dtWallSegmentCache::invalidate()
+{
+	flush();
+	m_generation++;
+}
+
+bool dtPolyInTiles(const dtNavMesh* nav, dtPolyRef ref, const int minx, const int miny, const int maxx, const int maxy)
+{
+	unsigned int salt, it, ip;
+	nav->decodePolyId(ref, salt, it, ip);
+	if ((int)it >= nav->getMaxTiles())
+		return false;
+	const dtMeshTile* tile = nav->getTile((int)it);
+	if (!tile->header)
+		return true;
+	return tile->header->x >= minx && tile->header->x <= maxx &&
+		   tile->header->y >= miny && tile->header->y <= maxy;
+}
+
+/// @par
+///
+/// Use after the tiles at a location have been rebuilt, with the block of tiles around
+/// it, as the polygons next to the rebuilt tiles gain or lose portals into them. The
+/// dropped entries keep their space until the cache is emptied.
+void dtWallSegmentCache::invalidateTiles(const dtNavMesh* nav, const int minx, const int miny,
+										 const int maxx, const int maxy)
+{
+	for (int i = 0; i < m_nentries; ++i)
+	{
+		Entry& entry = m_entries[i];
+		if (entry.ref && dtPolyInTiles(nav, entry.ref, minx, miny, maxx, maxy))
+			entry.ref = 0;
+	}
+}
+
+/// @par
+///
+/// The segments of a polygon depend on the filter, as the edges to neighbours that 
+/// do not pass it are walls too. Entries are kept per polygon and filter object.
+///
+/// Polygon references change when a tile is replaced, so an entry can not be returned 
+/// for a rebuilt polygon. The entries of its neighbours in other tiles are dropped by
+/// #invalidateTiles(), and the entries of polygons whose flags have changed only by
+/// #invalidate().
+///
+/// When the cache is full it is emptied, but its generation does not change.
+int dtWallSegmentCache::getWallSegments(dtPolyRef ref, const dtQueryFilter* filter,
+										const dtNavMeshQuery* navquery, const float** segs)
+{
+	static const int MAX_SEGS_PER_POLY = DT_VERTS_PER_POLYGON*3;
+	
+	const int bucket = (int)(hashRef(ref) & (m_bucketsSize-1));
+	for (int i = m_buckets[bucket]; i != -1; i = m_entries[i].next)
+	{
+		const Entry& entry = m_entries[i];
+		if (entry.ref == ref && entry.filter == filter)
+		{
+			m_hitCount++;
+			*segs = &m_segs[entry.firstSeg*6];
+			return entry.nsegs;
+		}
+	}
+	m_missCount++;
+	
+	float tmp[MAX_SEGS_PER_POLY*6];
+	int nsegs = 0;
+	if (dtStatusFailed(navquery->getPolyWallSegments(ref, filter, tmp, 0, &nsegs, MAX_SEGS_PER_POLY)))
+	{
+		*segs = 0;
+		return 0;
+	}
+	
+	if (m_nentries >= m_maxEntries || m_nsegs+nsegs > m_maxSegs)
+	{
+		// Start over rather than track which entries are still in use.
+		flush();
+		if (nsegs > m_maxSegs)
+			nsegs = m_maxSegs;
+	}
+	
+	Entry& entry = m_entries[m_nentries];
+	entry.ref = ref;
+	entry.filter = filter;
+	entry.firstSeg = m_nsegs;
+	entry.nsegs = nsegs;
+	entry.next = m_buckets[bucket];
+	m_buckets[bucket] = m_nentries;
+	m_nentries++;
+	
+	memcpy(&m_segs[m_nsegs*6], tmp, sizeof(float)*6*nsegs);
+	m_nsegs += nsegs;
+	
+	*segs = &m_segs[entry.firstSeg*6];
+	return nsegs;
+}
@@ -100,7 +100,13 @@ public:
 	dtStatus queryTiles(const float* bmin, const float* bmax,
 						dtCompressedTileRef* results, int* resultCount, const int maxResults) const;
 	
-	dtStatus update(const float /*dt*/, class dtNavMesh* navmesh);
+	/// Processes pending obstacle requests and rebuilds at most one touched tile.
+	///  @param[in]		dt			The time step size. (Unused.)
+	///  @param[in]		navmesh		The navigation mesh receiving the rebuilt tiles.
+	///  @param[out]	upToDate	True if no requests or tile rebuilds remain queued. [opt]
+	///  @param[out]	rebuiltTile	The tile that was rebuilt, or 0 if none was. [opt]
+	dtStatus update(const float /*dt*/, class dtNavMesh* navmesh, bool* upToDate = 0,
+					dtCompressedTileRef* rebuiltTile = 0);
 	
 	dtStatus buildNavMeshTilesAt(const int tx, const int ty, class dtNavMesh* navmesh);
 	
@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURTILECACHECOMPRESSOR_H
+#define DETOURTILECACHECOMPRESSOR_H
+
+#include "DetourTileCacheBuilder.h"
+
+/// Identifies the built-in tile cache compressors.
+/// @see dtAllocTileCacheCompressor
+enum dtTileCacheCompressorType
+{
+	DT_TILECACHE_COMPRESSOR_NONE = 0,	///< Stores the layer grids as-is.
+	DT_TILECACHE_COMPRESSOR_LZ = 1,		///< Fast general purpose LZ77 byte compressor.
+	DT_TILECACHE_COMPRESSOR_RLE = 2,	///< Run-length encoder tuned for layer grids.
+};
+
+/// Copies the layer data without compressing it.
+struct dtTileCacheNullCompressor : public dtTileCacheCompressor
+{
+	virtual int maxCompressedSize(const int bufferSize);
+	virtual dtStatus compress(const unsigned char* buffer, const int bufferSize,
+							  unsigned char* compressed, const int maxCompressedSize, int* compressedSize);
+	virtual dtStatus decompress(const unsigned char* compressed, const int compressedSize,
+								unsigned char* buffer, const int maxBufferSize, int* bufferSize);
+};
+
+/// A fast LZ77 compressor with a 64k window.
+/// Matches are found through a single-entry hash of 4 byte sequences, so
+/// compression is a single linear pass, and decompression is a sequence of
+/// literal and match copies without any entropy decoding.
+struct dtTileCacheLZCompressor : public dtTileCacheCompressor
+{
+	virtual int maxCompressedSize(const int bufferSize);
+	virtual dtStatus compress(const unsigned char* buffer, const int bufferSize,
+							  unsigned char* compressed, const int maxCompressedSize, int* compressedSize);
+	virtual dtStatus decompress(const unsigned char* compressed, const int compressedSize,
+								unsigned char* buffer, const int maxBufferSize, int* bufferSize);
+};
+
+/// A dictionary-less run-length encoder for #dtTileCacheLayer grids.
+/// The layer buffer is the height, area and connection grids back to back.
+/// Heights are delta coded along rows first, which turns flat and gently
+/// sloped ground into runs of a single value, like the area and connection grids.
+struct dtTileCacheRLECompressor : public dtTileCacheCompressor
+{
+	virtual int maxCompressedSize(const int bufferSize);
+	virtual dtStatus compress(const unsigned char* buffer, const int bufferSize,
+							  unsigned char* compressed, const int maxCompressedSize, int* compressedSize);
+	virtual dtStatus decompress(const unsigned char* compressed, const int compressedSize,
+								unsigned char* buffer, const int maxBufferSize, int* bufferSize);
+};
+
+/// Allocates one of the built-in compressors using the Detour allocator.
+///  @param[in]		type	The compressor to allocate. (See: #dtTileCacheCompressorType)
+/// @return The compressor, or null if the type is unknown or allocation failed.
+dtTileCacheCompressor* dtAllocTileCacheCompressor(const int type);
+
+/// Frees a compressor allocated with #dtAllocTileCacheCompressor.
+void dtFreeTileCacheCompressor(dtTileCacheCompressor* comp);
+
+#endif // DETOURTILECACHECOMPRESSOR_H
@@ -435,8 +435,12 @@ dtStatus dtTileCache::queryTiles(const float* bmin, const float* bmax,
 	return DT_SUCCESS;
 }
 
-dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh)
+dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh, bool* upToDate,
+							 dtCompressedTileRef* rebuiltTile)
 {
+	if (rebuiltTile)
+		*rebuiltTile = 0;
+	
 	if (m_nupdate == 0)
 	{
 		// Process requests.
@@ -500,6 +504,8 @@ dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh)
 		// Build mesh
 		const dtCompressedTileRef ref = m_update[0];
 		dtStatus status = buildNavMeshTile(ref, navmesh);
+		if (rebuiltTile)
+			*rebuiltTile = ref;
 		m_nupdate--;
 		if (m_nupdate > 0)
 			memmove(m_update, m_update+1, m_nupdate*sizeof(dtCompressedTileRef));
@@ -543,10 +549,16 @@ dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh)
 			}
 		}
 			
+		if (upToDate)
+			*upToDate = m_nupdate == 0 && m_nreqs == 0;
+
 		if (dtStatusFailed(status))
 			return status;
 	}
 	
+	if (upToDate)
+		*upToDate = m_nupdate == 0 && m_nreqs == 0;
+
 	return DT_SUCCESS;
 }
 
@@ -624,6 +636,9 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	if (dtStatusFailed(status))
 		return status;
 	
+	// Remove existing tile, so that an emptied tile does not linger in the navmesh.
+	navmesh->removeTile(navmesh->getTileRefAt(tile->header->tx,tile->header->ty,tile->header->tlayer),0,0);
+
 	// Early out if the mesh tile is empty.
 	if (!bc.lmesh->npolys)
 		return DT_SUCCESS;
@@ -707,7 +722,6 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	
 	if (navData)
 	{
-		navmesh->removeTile(navmesh->getTileRefAt(tile->header->tx,tile->header->ty,tile->header->tlayer),0,0);
 		// Let the navmesh own the data.
 		dtStatus status = navmesh->addTile(navData,navDataSize,DT_TILE_FREE_DATA,0,0);
 		if (dtStatusFailed(status))
@@ -0,0 +1,400 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include "DetourTileCacheCompressor.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
+#include <string.h>
+#include <new>
+
+
+dtTileCacheCompressor* dtAllocTileCacheCompressor(const int type)
+{
+	void* mem = 0;
+	switch (type)
+	{
+	case DT_TILECACHE_COMPRESSOR_NONE:
+		mem = dtAlloc(sizeof(dtTileCacheNullCompressor), DT_ALLOC_PERM);
+		return mem ? new(mem) dtTileCacheNullCompressor : 0;
+	case DT_TILECACHE_COMPRESSOR_LZ:
+		mem = dtAlloc(sizeof(dtTileCacheLZCompressor), DT_ALLOC_PERM);
+		return mem ? new(mem) dtTileCacheLZCompressor : 0;
+	case DT_TILECACHE_COMPRESSOR_RLE:
+		mem = dtAlloc(sizeof(dtTileCacheRLECompressor), DT_ALLOC_PERM);
+		return mem ? new(mem) dtTileCacheRLECompressor : 0;
+	}
+	return 0;
+}
+
+void dtFreeTileCacheCompressor(dtTileCacheCompressor* comp)
+{
+	// The built-in compressors are stateless and trivially destructible.
+	if (!comp) return;
+	dtFree(comp);
+}
+
+
+int dtTileCacheNullCompressor::maxCompressedSize(const int bufferSize)
+{
+	return bufferSize;
+}
+
+dtStatus dtTileCacheNullCompressor::compress(const unsigned char* buffer, const int bufferSize,
+											 unsigned char* compressed, const int maxCompressedSize, int* compressedSize)
+{
+	if (bufferSize > maxCompressedSize)
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+	memcpy(compressed, buffer, bufferSize);
+	*compressedSize = bufferSize;
+	return DT_SUCCESS;
+}
+
+dtStatus dtTileCacheNullCompressor::decompress(const unsigned char* compressed, const int compressedSize,
+											   unsigned char* buffer, const int maxBufferSize, int* bufferSize)
+{
+	if (compressedSize > maxBufferSize)
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+	memcpy(buffer, compressed, compressedSize);
+	*bufferSize = compressedSize;
+	return DT_SUCCESS;
+}
+
+
+// LZ stream format
+//
+// The stream is a list of sequences. Each sequence starts with a token byte,
+// the high nibble is the literal count and the low nibble is the match length
+// minus LZ_MIN_MATCH. A nibble of 15 is followed by extra length bytes which
+// are summed, a byte less than 255 ends the length. Then come the literals,
+// a 2 byte little endian match offset and the extra match length bytes.
+// The last sequence only contains literals.
+
+static const int LZ_MIN_MATCH = 4;
+static const int LZ_LAST_LITERALS = 5;
+static const int LZ_MAX_OFFSET = 0xffff;
+static const int LZ_HASH_BITS = 12;
+static const int LZ_HASH_SIZE = 1 << LZ_HASH_BITS;
+
+inline unsigned int lzRead32(const unsigned char* p)
+{
+	unsigned int v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline int lzHash(const unsigned int v)
+{
+	return (int)((v * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+static unsigned char* lzWriteLength(unsigned char* op, int len)
+{
+	while (len >= 255)
+	{
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char)len;
+	return op;
+}
+
+static unsigned char* lzWriteSequence(unsigned char* op, const unsigned char* literals, const int nliterals,
+									  const int offset, const int matchLength)
+{
+	const int ml = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+	unsigned char* token = op++;
+	*token = (unsigned char)((dtMin(nliterals, 15) << 4) | dtMin(ml, 15));
+	if (nliterals >= 15)
+		op = lzWriteLength(op, nliterals - 15);
+	memcpy(op, literals, nliterals);
+	op += nliterals;
+	if (matchLength)
+	{
+		*op++ = (unsigned char)(offset & 0xff);
+		*op++ = (unsigned char)(offset >> 8);
+		if (ml >= 15)
+			op = lzWriteLength(op, ml - 15);
+	}
+	return op;
+}
+
+int dtTileCacheLZCompressor::maxCompressedSize(const int bufferSize)
+{
+	// Worst case is a single literal run.
+	return bufferSize + bufferSize/255 + 16;
+}
+
+dtStatus dtTileCacheLZCompressor::compress(const unsigned char* buffer, const int bufferSize,
+										   unsigned char* compressed, const int maxCompressedSize, int* compressedSize)
+{
+	if (maxCompressedSize < this->maxCompressedSize(bufferSize))
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+	int table[LZ_HASH_SIZE];
+	for (int i = 0; i < LZ_HASH_SIZE; ++i)
+		table[i] = -1;
+	
+	unsigned char* op = compressed;
+	int anchor = 0;
+	int ip = 0;
+	const int matchLimit = bufferSize - LZ_LAST_LITERALS;
+	
+	while (ip + LZ_MIN_MATCH <= matchLimit)
+	{
+		const unsigned int seq = lzRead32(buffer + ip);
+		const int h = lzHash(seq);
+		const int ref = table[h];
+		table[h] = ip;
+		
+		if (ref < 0 || ip - ref > LZ_MAX_OFFSET || lzRead32(buffer + ref) != seq)
+		{
+			ip++;
+			continue;
+		}
+		
+		int len = LZ_MIN_MATCH;
+		while (ip + len < matchLimit && buffer[ref + len] == buffer[ip + len])
+			len++;
+		
+		op = lzWriteSequence(op, buffer + anchor, ip - anchor, ip - ref, len);
+		ip += len;
+		anchor = ip;
+	}
+	
+	op = lzWriteSequence(op, buffer + anchor, bufferSize - anchor, 0, 0);
+	*compressedSize = (int)(op - compressed);
+	
+	return DT_SUCCESS;
+}
+
+dtStatus dtTileCacheLZCompressor::decompress(const unsigned char* compressed, const int compressedSize,
+											 unsigned char* buffer, const int maxBufferSize, int* bufferSize)
+{
+	const unsigned char* ip = compressed;
+	const unsigned char* iend = compressed + compressedSize;
+	unsigned char* op = buffer;
+	unsigned char* oend = buffer + maxBufferSize;
+	
+	while (ip < iend)
+	{
+		const int token = *ip++;
+		
+		// Literals
+		int nliterals = token >> 4;
+		if (nliterals == 15)
+		{
+			int b = 255;
+			while (b == 255 && ip < iend)
+			{
+				b = *ip++;
+				nliterals += b;
+			}
+		}
+		if (nliterals > iend - ip || nliterals > oend - op)
+			return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+		memcpy(op, ip, nliterals);
+		ip += nliterals;
+		op += nliterals;
+		
+		// The last sequence has no match.
+		if (ip == iend)
+			break;
+		
+		// Match
+		if (iend - ip < 2)
+			return DT_FAILURE;
+		const int offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		int len = (token & 0xf);
+		if (len == 15)
+		{
+			int b = 255;
+			while (b == 255 && ip < iend)
+			{
+				b = *ip++;
+				len += b;
+			}
+		}
+		len += LZ_MIN_MATCH;
+		if (offset == 0 || offset > op - buffer)
+			return DT_FAILURE;
+		if (len > oend - op)
+			return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+		
+		// Matches may overlap the output, so copy forwards byte by byte
+		// unless the source is far enough behind.
+		const unsigned char* match = op - offset;
+		if (offset >= len)
+		{
+			memcpy(op, match, len);
+			op += len;
+		}
+		else
+		{
+			for (int i = 0; i < len; ++i)
+				*op++ = match[i];
+		}
+	}
+	
+	*bufferSize = (int)(op - buffer);
+	
+	return DT_SUCCESS;
+}
+
+
+// RLE stream format
+//
+// One mode byte, RLE_MODE_PLAIN or RLE_MODE_LAYER, followed by packets.
+// A control byte c < 128 is followed by c+1 literal bytes, a control byte
+// c >= 128 is followed by one byte repeated c-126 times.
+// In layer mode the first third of the buffer (the height grid) is delta
+// coded before run-length encoding.
+
+static const unsigned char RLE_MODE_PLAIN = 0;
+static const unsigned char RLE_MODE_LAYER = 1;
+static const int RLE_MAX_LITERALS = 128;
+static const int RLE_MIN_RUN = 3;
+static const int RLE_MAX_RUN = 129;
+
+// Reads the delta coded view of the buffer without modifying it.
+inline unsigned char rleDeltaByte(const unsigned char* buffer, const int i, const int deltaSize)
+{
+	if (i >= deltaSize || i == 0)
+		return buffer[i];
+	return (unsigned char)(buffer[i] - buffer[i-1]);
+}
+
+int dtTileCacheRLECompressor::maxCompressedSize(const int bufferSize)
+{
+	// Worst case is all literals, one control byte per RLE_MAX_LITERALS.
+	return 1 + bufferSize + (bufferSize + RLE_MAX_LITERALS-1) / RLE_MAX_LITERALS;
+}
+
+dtStatus dtTileCacheRLECompressor::compress(const unsigned char* buffer, const int bufferSize,
+											unsigned char* compressed, const int maxCompressedSize, int* compressedSize)
+{
+	if (maxCompressedSize < this->maxCompressedSize(bufferSize))
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+	const bool layer = bufferSize > 0 && (bufferSize % 3) == 0;
+	const int deltaSize = layer ? bufferSize / 3 : 0;
+	
+	unsigned char* op = compressed;
+	*op++ = layer ? RLE_MODE_LAYER : RLE_MODE_PLAIN;
+	
+	int i = 0;
+	int litStart = 0;
+	while (i < bufferSize)
+	{
+		// Measure the run starting at i.
+		const unsigned char v = rleDeltaByte(buffer, i, deltaSize);
+		int run = 1;
+		while (i + run < bufferSize && run < RLE_MAX_RUN &&
+			   rleDeltaByte(buffer, i + run, deltaSize) == v)
+			run++;
+		
+		if (run < RLE_MIN_RUN)
+		{
+			i++;
+			if (i - litStart == RLE_MAX_LITERALS)
+			{
+				*op++ = (unsigned char)(RLE_MAX_LITERALS - 1);
+				for (int j = litStart; j < i; ++j)
+					*op++ = rleDeltaByte(buffer, j, deltaSize);
+				litStart = i;
+			}
+			continue;
+		}
+		
+		// Flush pending literals before the run.
+		if (litStart < i)
+		{
+			*op++ = (unsigned char)(i - litStart - 1);
+			for (int j = litStart; j < i; ++j)
+				*op++ = rleDeltaByte(buffer, j, deltaSize);
+		}
+		
+		*op++ = (unsigned char)(run + 126);
+		*op++ = v;
+		i += run;
+		litStart = i;
+	}
+	
+	if (litStart < bufferSize)
+	{
+		*op++ = (unsigned char)(bufferSize - litStart - 1);
+		for (int j = litStart; j < bufferSize; ++j)
+			*op++ = rleDeltaByte(buffer, j, deltaSize);
+	}
+	
+	*compressedSize = (int)(op - compressed);
+	
+	return DT_SUCCESS;
+}
+
+dtStatus dtTileCacheRLECompressor::decompress(const unsigned char* compressed, const int compressedSize,
+											  unsigned char* buffer, const int maxBufferSize, int* bufferSize)
+{
+	if (compressedSize < 1)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	const unsigned char* ip = compressed;
+	const unsigned char* iend = compressed + compressedSize;
+	unsigned char* op = buffer;
+	unsigned char* oend = buffer + maxBufferSize;
+	
+	const unsigned char mode = *ip++;
+	if (mode != RLE_MODE_PLAIN && mode != RLE_MODE_LAYER)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	while (ip < iend)
+	{
+		const int c = *ip++;
+		if (c < RLE_MAX_LITERALS)
+		{
+			const int n = c + 1;
+			if (n > iend - ip || n > oend - op)
+				return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+			memcpy(op, ip, n);
+			ip += n;
+			op += n;
+		}
+		else
+		{
+			const int n = c - 126;
+			if (ip >= iend || n > oend - op)
+				return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+			memset(op, *ip++, n);
+			op += n;
+		}
+	}
+	
+	const int size = (int)(op - buffer);
+	
+	if (mode == RLE_MODE_LAYER)
+	{
+		// Undo the height delta coding.
+		const int deltaSize = size / 3;
+		for (int i = 1; i < deltaSize; ++i)
+			buffer[i] = (unsigned char)(buffer[i] + buffer[i-1]);
+	}
+	
+	*bufferSize = size;
+	
+	return DT_SUCCESS;
+}
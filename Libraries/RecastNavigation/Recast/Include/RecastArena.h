@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef RECASTARENA_H
+#define RECASTARENA_H
+
+#include "RecastAlloc.h"
+
+/// A resettable bump allocator for the temporary memory of Recast build stages.
+/// 
+/// Allocations are carved from large blocks and only released when the
+/// arena is reset, except that freeing the most recent allocation gives its
+/// memory back immediately. Reset keeps the blocks, so repeated builds of
+/// similar size stop touching the system allocator.
+/// @see rcArenaScope, rcArenaInstall
+class rcArena
+{
+public:
+	/// Constructs an empty arena.
+	///  @param[in]		blockSize	The minimum size, in bytes, of each block requested from the system.
+	rcArena(int blockSize = 1024*1024);
+	~rcArena();
+
+	/// Allocates a memory block from the arena.
+	///  @param[in]		size	The size, in bytes, of memory to allocate.
+	///  @return A pointer to the allocated memory, or null if the allocation failed.
+	void* alloc(int size);
+
+	/// Releases a memory block if it was the most recent allocation.
+	/// Other blocks are reclaimed by #reset.
+	///  @param[in]		ptr		A pointer to a memory block previously allocated by #alloc.
+	void free(void* ptr);
+
+	/// Returns true if @p ptr points into one of the arena's blocks.
+	bool owns(const void* ptr) const;
+
+	/// Makes all memory available again. Fragmented blocks are merged into
+	/// a single block large enough for the peak usage seen so far.
+	void reset();
+
+	/// Releases all blocks back to the system.
+	void purge();
+
+	/// The peak number of bytes in use since construction or #resetHighWaterMark.
+	inline int getHighWaterMark() const { return m_highWaterMark; }
+
+	/// Restarts the peak tracking from the current usage.
+	inline void resetHighWaterMark() { m_highWaterMark = m_used; }
+
+	/// The number of bytes currently in use, including alignment padding.
+	inline int getUsed() const { return m_used; }
+
+	/// The total size, in bytes, of the blocks owned by the arena.
+	inline int getCapacity() const { return m_capacity; }
+
+	/// The number of blocks requested from the system since construction.
+	inline int getSystemAllocCount() const { return m_systemAllocs; }
+
+private:
+	struct Block
+	{
+		Block* next;
+		int size;
+		int used;
+	};
+
+	Block* m_blocks;
+	Block* m_current;
+	int m_blockSize;
+	int m_used;
+	int m_highWaterMark;
+	int m_capacity;
+	int m_systemAllocs;
+
+	Block* allocBlock(int size);
+	static unsigned char* getBlockData(Block* block);
+
+	rcArena(const rcArena&);
+	rcArena& operator=(const rcArena&);
+};
+
+/// Routes #RC_ALLOC_TEMP allocations made on the calling thread to an arena
+/// for the lifetime of the scope. The arena is reset when the scope ends.
+/// @note #rcArenaInstall must have been called first, and the scope must
+/// cover the whole of any Recast call made inside it.
+class rcArenaScope
+{
+	rcArena* m_arena;
+	rcArena* m_prev;
+	rcArenaScope(const rcArenaScope&);
+	rcArenaScope& operator=(const rcArenaScope&);
+public:
+	explicit rcArenaScope(rcArena* arena);
+	~rcArenaScope();
+};
+
+/// Sets the Recast allocation functions to ones that honour #rcArenaScope.
+/// Allocations outside of a scope, and all #RC_ALLOC_PERM allocations, still
+/// go to malloc. Call once before starting any builds that use an arena, and
+/// before allocating anything that will be freed through #rcArenaFree.
+void rcArenaInstall();
+
+/// The allocation function installed by #rcArenaInstall, for custom
+/// allocators that want to layer on top of the arena.
+///  @param[in]		size	The size, in bytes, of memory to allocate.
+///  @param[in]		hint	A hint to the allocator on how long the memory is expected to be in use.
+///  @return A pointer to the allocated memory, or null if the allocation failed.
+void* rcArenaAlloc(int size, rcAllocHint hint);
+
+/// The free function installed by #rcArenaInstall. Arena memory is only
+/// released when it belongs to the calling thread's current scope, and is
+/// otherwise left for its arena to reclaim. It is never passed to free.
+///  @param[in]		ptr		A pointer to a memory block previously allocated by #rcArenaAlloc.
+void rcArenaFree(void* ptr);
+
+#endif // RECASTARENA_H
@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <stdlib.h>
+#include "RecastAlloc.h"
+#include "RecastArena.h"
+#include "RecastAssert.h"
+
+#if defined(_MSC_VER)
+#define RC_ARENA_THREAD_LOCAL __declspec(thread)
+#else
+#define RC_ARENA_THREAD_LOCAL __thread
+#endif
+
+static const int RC_ARENA_ALIGN = 16;
+
+inline int rcArenaAlign(int size) { return (size + RC_ARENA_ALIGN-1) & ~(RC_ARENA_ALIGN-1); }
+
+// Each allocation is preceded by RC_ARENA_ALIGN bytes holding its total size,
+// so the most recent one can be popped on free, and a tag. The malloc
+// fallback of rcArenaAlloc writes the same header with a different tag, so
+// rcArenaFree can tell arena memory apart even when it is freed outside the
+// scope it was allocated in.
+static const int RC_ARENA_TAG = 'A'<<24 | 'R'<<16 | 'E'<<8 | 'N';
+static const int RC_HEAP_TAG = 'H'<<24 | 'E'<<16 | 'A'<<8 | 'P';
+
+static RC_ARENA_THREAD_LOCAL rcArena* s_threadArena = 0;
+
+rcArena::rcArena(int blockSize) :
+	m_blocks(0),
+	m_current(0),
+	m_blockSize(blockSize > 0 ? blockSize : 1024*1024),
+	m_used(0),
+	m_highWaterMark(0),
+	m_capacity(0),
+	m_systemAllocs(0)
+{
+}
+
+rcArena::~rcArena()
+{
+	purge();
+}
+
+unsigned char* rcArena::getBlockData(Block* block)
+{
+	return (unsigned char*)block + rcArenaAlign(sizeof(Block));
+}
+
+rcArena::Block* rcArena::allocBlock(int size)
+{
+	Block* block = (Block*)::malloc(rcArenaAlign(sizeof(Block)) + size);
+	if (!block)
+		return 0;
+	block->next = 0;
+	block->size = size;
+	block->used = 0;
+	m_capacity += size;
+	m_systemAllocs++;
+	return block;
+}
+
+void* rcArena::alloc(int size)
+{
+	if (size < 0)
+		return 0;
+	const int need = rcArenaAlign(size) + RC_ARENA_ALIGN;
+
+	// Move on to the next free block, or add one, when the current one is full.
+	if (!m_current || m_current->used + need > m_current->size)
+	{
+		Block* next = m_current ? m_current->next : m_blocks;
+		if (!next || need > next->size)
+		{
+			Block* block = allocBlock(need > m_blockSize ? need : m_blockSize);
+			if (!block)
+				return 0;
+			if (m_current)
+			{
+				block->next = m_current->next;
+				m_current->next = block;
+			}
+			else
+			{
+				block->next = m_blocks;
+				m_blocks = block;
+			}
+			next = block;
+		}
+		m_current = next;
+	}
+
+	unsigned char* mem = getBlockData(m_current) + m_current->used;
+	((int*)mem)[0] = need;
+	((int*)mem)[1] = RC_ARENA_TAG;
+	m_current->used += need;
+	m_used += need;
+	if (m_used > m_highWaterMark)
+		m_highWaterMark = m_used;
+
+	return mem + RC_ARENA_ALIGN;
+}
+
+void rcArena::free(void* ptr)
+{
+	if (!ptr || !m_current)
+		return;
+	unsigned char* mem = (unsigned char*)ptr - RC_ARENA_ALIGN;
+	const int need = ((int*)mem)[0];
+	if (mem + need == getBlockData(m_current) + m_current->used)
+	{
+		m_current->used -= need;
+		m_used -= need;
+	}
+}
+
+bool rcArena::owns(const void* ptr) const
+{
+	const unsigned char* p = (const unsigned char*)ptr;
+	for (Block* block = m_blocks; block; block = block->next)
+	{
+		const unsigned char* data = getBlockData(block);
+		if (p >= data && p < data + block->size)
+			return true;
+	}
+	return false;
+}
+
+void rcArena::reset()
+{
+	// Merge fragmented blocks so the next build of the same size fits in one.
+	if (m_blocks && m_blocks->next)
+	{
+		const int size = m_highWaterMark > m_blockSize ? m_highWaterMark : m_blockSize;
+		purge();
+		m_blocks = allocBlock(size);
+	}
+	for (Block* block = m_blocks; block; block = block->next)
+		block->used = 0;
+	m_current = m_blocks;
+	m_used = 0;
+}
+
+void rcArena::purge()
+{
+	Block* block = m_blocks;
+	while (block)
+	{
+		Block* next = block->next;
+		::free(block);
+		block = next;
+	}
+	m_blocks = 0;
+	m_current = 0;
+	m_used = 0;
+	m_capacity = 0;
+}
+
+rcArenaScope::rcArenaScope(rcArena* arena) :
+	m_arena(arena),
+	m_prev(s_threadArena)
+{
+	s_threadArena = arena;
+}
+
+rcArenaScope::~rcArenaScope()
+{
+	rcAssert(s_threadArena == m_arena);
+	s_threadArena = m_prev;
+	if (m_arena)
+		m_arena->reset();
+}
+
+void* rcArenaAlloc(int size, rcAllocHint hint)
+{
+	if (hint == RC_ALLOC_TEMP && s_threadArena)
+	{
+		void* ptr = s_threadArena->alloc(size);
+		if (ptr)
+			return ptr;
+	}
+	if (size < 0)
+		return 0;
+	unsigned char* mem = (unsigned char*)malloc(RC_ARENA_ALIGN + size);
+	if (!mem)
+		return 0;
+	((int*)mem)[0] = size;
+	((int*)mem)[1] = RC_HEAP_TAG;
+	return mem + RC_ARENA_ALIGN;
+}
+
+void rcArenaFree(void* ptr)
+{
+	if (!ptr)
+		return;
+	unsigned char* mem = (unsigned char*)ptr - RC_ARENA_ALIGN;
+	if (((int*)mem)[1] == RC_HEAP_TAG)
+	{
+		free(mem);
+		return;
+	}
+	rcAssert(((int*)mem)[1] == RC_ARENA_TAG);
+
+	// Arena memory freed after its scope ended is left to the arena, which
+	// reclaims it on its next reset.
+	if (s_threadArena && s_threadArena->owns(ptr))
+		s_threadArena->free(ptr);
+}
+
+/// @par
+///
+/// The arena functions fall back to malloc when no #rcArenaScope is active
+/// on the calling thread, so it is safe to install them once and leave them.
+void rcArenaInstall()
+{
+	rcAllocSetCustom(rcArenaAlloc, rcArenaFree);
+}
@@ -964,7 +964,9 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 		ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'src' (%d).", chf.spanCount);
 		return false;
 	}
-	unsigned short* dst = (unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount, RC_ALLOC_TEMP);
+	// The blurred distances are kept in the heightfield, so they must not
+	// come from temporary memory.
+	unsigned short* dst = (unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount, RC_ALLOC_PERM);
 	if (!dst)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'dst' (%d).", chf.spanCount);
@@ -984,17 +986,16 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 	ctx->startTimer(RC_TIMER_BUILD_DISTANCEFIELD_BLUR);
 	
 	// Blur
-	if (boxBlur(chf, 1, src, dst) != src)
-		rcSwap(src, dst);
+	boxBlur(chf, 1, src, dst);
 	
 	// Store distance.
-	chf.dist = src;
+	chf.dist = dst;
 	
 	ctx->stopTimer(RC_TIMER_BUILD_DISTANCEFIELD_BLUR);
 
 	ctx->stopTimer(RC_TIMER_BUILD_DISTANCEFIELD);
 	
-	rcFree(dst);
+	rcFree(src);
 	
 	return true;
 }
@@ -0,0 +1,138 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BUILDCONTEXT_H
+#define BUILDCONTEXT_H
+
+#include <Recast.h>
+
+#include "PerfTimer.h"
+
+// Summary of the last build, laid out for marshalling. Times are in
+// microseconds and memory in bytes, both indexed by rcTimerLabel. A
+// stage that did not run has a time of -1 and a peak of 0.
+struct BuildReport
+{
+	int stageUsec[RC_MAX_TIMERS];
+	int stagePeakBytes[RC_MAX_TIMERS];	// Peak Recast memory allocated while the stage ran
+	int peakBytes;				// Peak Recast memory in use over the whole build
+	int allocCount;				// Recast allocations made during the build
+	int logCount;
+
+	// Size of the output, 0 where the build does not produce it
+	int tileCount;
+	int polyCount;
+	int vertCount;
+	int detailTriCount;
+	int dataSize;				// Bytes of navmesh or tile cache data
+};
+
+// Recast context that keeps real stage timings, the peak memory of each
+// stage and the log of a build. Memory is measured in the Recast
+// allocation hooks, so installAllocHooks must be used in place of
+// rcArenaInstall. Only allocations made on the thread of an active
+// BuildContextScope are counted.
+class BuildContext : public rcContext
+{
+public:
+	BuildContext();
+
+	void getReport(BuildReport* report) const;
+	// Records the size of the output for the report.
+	void setOutputStats(int tiles, int polys, int verts, int detailTris, int bytes);
+	// Adds the stage times, memory and log of a worker's build. Times and
+	// peaks are summed over the workers, so with workers running at once
+	// the peaks are an upper bound. The total time is left as it is.
+	void merge(const BuildContext& worker);
+
+	int getLogCount() const { return numMessages; }
+	// Copies the text of message i and returns its rcLogCategory, or -1
+	// if there is no such message.
+	int getLogMessage(int i, char* buffer, int bufferSize) const;
+
+	// Installs the arena allocation hooks with the memory tracking on top.
+	static void installAllocHooks();
+
+protected:
+	virtual void doResetLog();
+	virtual void doLog(const rcLogCategory category, const char* msg, const int len);
+	virtual void doResetTimers();
+	virtual void doStartTimer(const rcTimerLabel label);
+	virtual void doStopTimer(const rcTimerLabel label);
+	virtual int doGetAccumulatedTime(const rcTimerLabel label) const;
+
+private:
+	friend class BuildContextScope;
+
+	static const int MAX_MESSAGES = 256;
+	static const int TEXT_POOL_SIZE = 16384;
+
+	TimeVal startTime[RC_MAX_TIMERS];
+	TimeVal accTime[RC_MAX_TIMERS];		// -1 until the stage first stops
+
+	// Memory is tracked for the stages whose timers are running, relative
+	// to the bytes in use when each one started.
+	int stageBase[RC_MAX_TIMERS];
+	int stagePeak[RC_MAX_TIMERS];
+	int running[RC_MAX_TIMERS];
+	int numRunning;
+	int liveBytes;
+	int peakBytes;
+	int allocCount;
+
+	unsigned char categories[MAX_MESSAGES];
+	const char* messages[MAX_MESSAGES];
+	int numMessages;
+	char textPool[TEXT_POOL_SIZE];
+	int textPoolSize;
+
+	int tileCount;
+	int polyCount;
+	int vertCount;
+	int detailTriCount;
+	int dataSize;
+
+	void resetMemory();
+	void trackAlloc(int size);
+	void trackFree(int size);
+
+	static void* allocFunc(int size, rcAllocHint hint);
+	static void freeFunc(void* ptr);
+};
+
+// Resets a context for a new build, times the build as RC_TIMER_TOTAL and
+// counts the Recast allocations of the calling thread while it lives.
+class BuildContextScope
+{
+public:
+	explicit BuildContextScope(BuildContext* ctx);
+	~BuildContextScope();
+
+private:
+	BuildContext* ctx;
+	BuildContext* prev;
+
+	BuildContextScope(const BuildContextScope&);
+	BuildContextScope& operator=(const BuildContextScope&);
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHUNKYTRIMESH_H
+#define CHUNKYTRIMESH_H
+
+#include <vector>
+
+static const int CHUNKYTRIMESH_TRIS_PER_CHUNK = 256;
+
+// Spatial index over a triangle mesh, after the chunky trimesh in the
+// Recast demo. Triangles are sorted into chunks of at most trisPerChunk
+// triangles under an xz bounding volume tree, so a tile build only
+// rasterizes the chunks overlapping it instead of every triangle.
+class ChunkyTriMesh
+{
+public:
+	ChunkyTriMesh();
+
+	bool build(const float* vertices, const int* indices, int ntris, int trisPerChunk);
+	void clear();
+
+	// Appends the ids of the chunks whose xz bounds overlap the rectangle.
+	void getChunksOverlappingRect(const float* bmin, const float* bmax, std::vector<int>& chunks) const;
+
+	const int* getChunkIndices(int chunk) const { return &indices[nodes[chunk].i*3]; }
+	int getChunkTriCount(int chunk) const { return nodes[chunk].n; }
+	int getMaxTrisPerChunk() const { return maxTrisPerChunk; }
+
+private:
+	// Leaves have i >= 0, the first triangle of the chunk, and n
+	// triangles. Interior nodes store the negated escape offset in i.
+	struct Node
+	{
+		float bmin[2];
+		float bmax[2];
+		int i;
+		int n;
+	};
+
+	struct BoundsItem
+	{
+		float bmin[2];
+		float bmax[2];
+		int i;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<int> indices;
+	int maxTrisPerChunk;
+
+	void subdivide(std::vector<BoundsItem>& items, int imin, int imax, int trisPerChunk, const int* srcIndices);
+};
+
+#endif
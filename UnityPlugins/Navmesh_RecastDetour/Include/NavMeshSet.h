@@ -0,0 +1,54 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAVMESHSET_H
+#define NAVMESHSET_H
+
+#include <DetourNavMesh.h>
+
+// Layout of the blob produced by NavmeshBuilderBuild and consumed by
+// SteeringManager::initNavMeshSet and SteeringManager::updateNavMeshTiles:
+//
+//   NavMeshSetHeader
+//   (NavMeshTileHeader, tile data[dataSize]) * numTiles
+//
+// A tile with a dataSize of zero has no walkable area and is removed.
+
+static const int NAVMESHSET_MAGIC = 'M'<<24 | 'S'<<16 | 'E'<<8 | 'T';
+static const int NAVMESHSET_VERSION = 1;
+
+struct NavMeshSetHeader
+{
+	int magic;
+	int version;
+	int numTiles;
+	dtNavMeshParams params;
+};
+
+struct NavMeshTileHeader
+{
+	int tileX;
+	int tileY;
+	int dataSize;
+};
+
+#endif
@@ -24,9 +24,15 @@
 #define NAVMESH_H
 
 #include <Recast.h>
+#include <RecastArena.h>
 #include <DetourNavMesh.h>
 #include <DetourNavMeshQuery.h>
 
+#include "BuildContext.h"
+
+extern unsigned char* g_navData;
+extern int g_navDataSize;
+
 extern float* providedVertices;
 extern int* providedIndices;
 extern int numProvidedVertices;
@@ -39,12 +45,25 @@ extern rcContourSet* cset;
 extern rcPolyMesh* pmesh;
 extern rcPolyMeshDetail* dmesh;
 
+// Scratch memory for the Recast temporaries of BuildNavmesh and BuildTileCache.
+extern rcArena g_buildArena;
+// Timings, memory and log of the last BuildNavmesh, BuildTileCache or
+// NavmeshBuilderBuild.
+extern BuildContext g_buildContext;
+
+void FreeIntermediateData();
+
+class NavmeshBuilder;
+
 #define EXPORT extern "C" __declspec(dllexport)
 
 EXPORT dtNavMesh* DebugInitNavmesh(unsigned char* data, int dataSize);
 EXPORT void DebugDestroyNavmesh(dtNavMesh* nm);
 
 EXPORT void RetrieveNavmeshData(unsigned char* buffer);
+EXPORT void GetBuildArenaStats(int* highWaterMark, int* capacity, int* systemAllocs);
+EXPORT void GetBuildReport(BuildReport* report);
+EXPORT int GetBuildLogMessage(int index, char* buffer, int bufferSize);
 EXPORT int BuildNavmesh(
 	int numVertices,
 	float* vertices,
@@ -71,5 +90,65 @@ EXPORT int BuildNavmesh(
 	float detailSampleMaxError,
 	bool keepIntermediate,
 	int oneMillion);
+EXPORT int BuildTileCache(
+	int numVertices,
+	float* vertices,
+	int numIndices,
+	int* indices,
+	float minX,
+	float minY,
+	float minZ,
+	float maxX,
+	float maxY,
+	float maxZ,
+	float cellSize,
+	float cellHeight,
+	float walkableHeight,
+	float walkableSlopeAngle,
+	float walkableClimb,
+	float walkableRadius,
+	float maxSimplificationError,
+	int tileSize,
+	int maxObstacles,
+	int compressor,
+	int oneMillion);
+
+EXPORT NavmeshBuilder* CreateNavmeshBuilder(
+	float minX,
+	float minY,
+	float minZ,
+	float maxX,
+	float maxY,
+	float maxZ,
+	float cellSize,
+	float cellHeight,
+	float walkableHeight,
+	float walkableSlopeAngle,
+	float walkableClimb,
+	float walkableRadius,
+	float maxEdgeLen,
+	float maxSimplificationError,
+	bool monotonePartitioning,
+	float minRegionArea,
+	float mergeRegionArea,
+	float detailSampleDist,
+	float detailSampleMaxError,
+	int tileSize,
+	int oneMillion);
+EXPORT void DestroyNavmeshBuilder(NavmeshBuilder* builder);
+EXPORT void NavmeshBuilderSetMesh(
+	NavmeshBuilder* builder,
+	int meshId,
+	int numVertices,
+	float* vertices,
+	int numIndices,
+	int* indices);
+EXPORT void NavmeshBuilderRemoveMesh(NavmeshBuilder* builder, int meshId);
+EXPORT int NavmeshBuilderBuild(NavmeshBuilder* builder);
+EXPORT void NavmeshBuilderGetArenaStats(
+	NavmeshBuilder* builder, 
+	int* highWaterMark, 
+	int* capacity, 
+	int* systemAllocs);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAVMESHBUILDER_H
+#define NAVMESHBUILDER_H
+
+#include <Recast.h>
+#include <RecastArena.h>
+#include <DetourNavMesh.h>
+#include <map>
+#include <vector>
+
+#include "BuildContext.h"
+#include "ChunkyTriMesh.h"
+
+// Keeps the input geometry of a tiled navmesh between builds so that
+// edits only rebuild the tiles they touch. Geometry is added as meshes
+// with a caller chosen id. Adding, replacing or removing a mesh marks
+// the tiles under its old and new bounds dirty, and build() rebuilds
+// just those tiles. Each mesh keeps a ChunkyTriMesh so a tile only
+// rasterizes the triangles near it.
+class NavmeshBuilder
+{
+public:
+	NavmeshBuilder();
+	~NavmeshBuilder();
+
+	// cfg holds the usual Recast settings in voxel units, with tileSize
+	// set and bmin/bmax covering every mesh that will be added.
+	bool init(const rcConfig& cfg, bool monotonePartitioning, 
+		float walkableHeight, float walkableRadius, float walkableClimb);
+
+	void setMesh(int meshId, int numVertices, const float* vertices, int numIndices, const int* indices);
+	void removeMesh(int meshId);
+	void markAllDirty();
+
+	// Rebuilds the dirty tiles and packs them into a NavMeshSet blob
+	// allocated with dtAlloc. Returns 0 on success or a negative error.
+	// The timings, memory and logs of the workers are merged into ctx,
+	// along with the size of the rebuilt tiles.
+	int build(BuildContext* ctx, unsigned char** outData, int* outDataSize);
+
+	const dtNavMeshParams& getNavMeshParams() const { return navMeshParams; }
+
+	// Scratch memory of the build workers, summed over all of them.
+	void getArenaStats(int* highWaterMark, int* capacity, int* systemAllocs) const;
+
+private:
+	struct Mesh
+	{
+		std::vector<float> vertices;
+		ChunkyTriMesh chunkyMesh;
+		float bmin[3];
+		float bmax[3];
+	};
+
+	struct TileResult
+	{
+		int tileX;
+		int tileY;
+		int status;
+		unsigned char* data;
+		int dataSize;
+		int polyCount;
+		int vertCount;
+		int detailTriCount;
+	};
+
+	rcConfig cfg;
+	bool monotonePartitioning;
+	float walkableHeight;
+	float walkableRadius;
+	float walkableClimb;
+	dtNavMeshParams navMeshParams;
+
+	int tilesWide;
+	int tilesHigh;
+	std::vector<unsigned char> dirtyTiles;
+	std::map<int, Mesh> meshes;
+
+	// One scratch arena and context per build worker, kept between builds.
+	std::vector<rcArena*> arenas;
+	std::vector<BuildContext*> contexts;
+
+	void markDirty(const float* bmin, const float* bmax);
+	void buildTiles(rcArena* arena, BuildContext* ctx, int first, int stride, std::vector<TileResult>& results) const;
+	void buildTile(rcContext* ctx, TileResult& result) const;
+};
+
+#endif
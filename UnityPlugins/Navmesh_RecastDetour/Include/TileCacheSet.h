@@ -0,0 +1,56 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILECACHESET_H
+#define TILECACHESET_H
+
+#include <DetourNavMesh.h>
+#include <DetourTileCache.h>
+#include <DetourTileCacheBuilder.h>
+#include <DetourTileCacheCompressor.h>
+
+// Layout of the blob produced by BuildTileCache and consumed by
+// SteeringManager::initTileCache:
+//
+//   TileCacheSetHeader
+//   (TileCacheTileHeader, tile data[dataSize]) * numTiles
+
+static const int TILECACHESET_MAGIC = 'T'<<24 | 'S'<<16 | 'E'<<8 | 'T';
+static const int TILECACHESET_VERSION = 2;
+
+struct TileCacheSetHeader
+{
+	int magic;
+	int version;
+	int numTiles;
+	int compressor; // dtTileCacheCompressorType used for the tile data
+	dtNavMeshParams meshParams;
+	dtTileCacheParams cacheParams;
+};
+
+struct TileCacheTileHeader
+{
+	dtCompressedTileRef tileRef;
+	int dataSize;
+};
+
+#endif
@@ -0,0 +1,246 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <RecastArena.h>
+#include <string.h>
+
+#include "BuildContext.h"
+
+#if defined(_MSC_VER)
+#define BUILDCONTEXT_THREAD_LOCAL __declspec(thread)
+#else
+#define BUILDCONTEXT_THREAD_LOCAL __thread
+#endif
+
+// Each tracked allocation is preceded by a header holding its size, padded
+// to keep the arena's alignment.
+static const int ALLOC_HEADER_SIZE = 16;
+
+static BUILDCONTEXT_THREAD_LOCAL BuildContext* s_threadContext = 0;
+
+BuildContext::BuildContext() :
+	numRunning(0),
+	liveBytes(0),
+	peakBytes(0),
+	allocCount(0),
+	numMessages(0),
+	textPoolSize(0),
+	tileCount(0),
+	polyCount(0),
+	vertCount(0),
+	detailTriCount(0),
+	dataSize(0)
+{
+	doResetTimers();
+	resetMemory();
+}
+
+void BuildContext::getReport(BuildReport* report) const
+{
+	for(int i = 0; i < RC_MAX_TIMERS; ++i)
+	{
+		report->stageUsec[i] = accTime[i] < 0 ? -1 : getPerfTimeUsec(accTime[i]);
+		report->stagePeakBytes[i] = stagePeak[i];
+	}
+	report->peakBytes = peakBytes;
+	report->allocCount = allocCount;
+	report->logCount = numMessages;
+	report->tileCount = tileCount;
+	report->polyCount = polyCount;
+	report->vertCount = vertCount;
+	report->detailTriCount = detailTriCount;
+	report->dataSize = dataSize;
+}
+
+void BuildContext::setOutputStats(int tiles, int polys, int verts, int detailTris, int bytes)
+{
+	tileCount = tiles;
+	polyCount = polys;
+	vertCount = verts;
+	detailTriCount = detailTris;
+	dataSize = bytes;
+}
+
+void BuildContext::merge(const BuildContext& worker)
+{
+	for(int i = 0; i < RC_MAX_TIMERS; ++i)
+	{
+		stagePeak[i] += worker.stagePeak[i];
+		if(i == RC_TIMER_TOTAL || worker.accTime[i] < 0) continue;
+		if(accTime[i] < 0)
+			accTime[i] = worker.accTime[i];
+		else
+			accTime[i] += worker.accTime[i];
+	}
+	peakBytes += worker.peakBytes;
+	allocCount += worker.allocCount;
+
+	for(int i = 0; i < worker.numMessages; ++i)
+		doLog((rcLogCategory)worker.categories[i], worker.messages[i], (int)strlen(worker.messages[i]));
+}
+
+int BuildContext::getLogMessage(int i, char* buffer, int bufferSize) const
+{
+	if(i < 0 || i >= numMessages) return -1;
+	if(bufferSize > 0)
+	{
+		strncpy(buffer, messages[i], bufferSize);
+		buffer[bufferSize-1] = 0;
+	}
+	return categories[i];
+}
+
+void BuildContext::installAllocHooks()
+{
+	rcAllocSetCustom(allocFunc, freeFunc);
+}
+
+void BuildContext::doResetLog()
+{
+	numMessages = 0;
+	textPoolSize = 0;
+}
+
+void BuildContext::doLog(const rcLogCategory category, const char* msg, const int len)
+{
+	if(!len || numMessages >= MAX_MESSAGES) return;
+	const int maxText = TEXT_POOL_SIZE - textPoolSize;
+	if(maxText < 1) return;
+
+	char* dst = &textPool[textPoolSize];
+	const int n = rcMin(len+1, maxText);
+	memcpy(dst, msg, n);
+	dst[n-1] = '\0';
+	textPoolSize += n;
+
+	categories[numMessages] = (unsigned char)category;
+	messages[numMessages++] = dst;
+}
+
+void BuildContext::doResetTimers()
+{
+	for(int i = 0; i < RC_MAX_TIMERS; ++i)
+		accTime[i] = -1;
+}
+
+void BuildContext::doStartTimer(const rcTimerLabel label)
+{
+	startTime[label] = getPerfTime();
+
+	for(int i = 0; i < numRunning; ++i)
+	{
+		if(running[i] == label) return;
+	}
+	stageBase[label] = liveBytes;
+	running[numRunning++] = label;
+}
+
+void BuildContext::doStopTimer(const rcTimerLabel label)
+{
+	const TimeVal deltaTime = getPerfTime() - startTime[label];
+	if(accTime[label] < 0)
+		accTime[label] = deltaTime;
+	else
+		accTime[label] += deltaTime;
+
+	for(int i = 0; i < numRunning; ++i)
+	{
+		if(running[i] == label)
+		{
+			running[i] = running[--numRunning];
+			break;
+		}
+	}
+}
+
+int BuildContext::doGetAccumulatedTime(const rcTimerLabel label) const
+{
+	return accTime[label] < 0 ? -1 : getPerfTimeUsec(accTime[label]);
+}
+
+void BuildContext::resetMemory()
+{
+	numRunning = 0;
+	liveBytes = 0;
+	peakBytes = 0;
+	allocCount = 0;
+	memset(stageBase, 0, sizeof(stageBase));
+	memset(stagePeak, 0, sizeof(stagePeak));
+}
+
+void BuildContext::trackAlloc(int size)
+{
+	liveBytes += size;
+	allocCount++;
+	if(liveBytes > peakBytes)
+		peakBytes = liveBytes;
+
+	for(int i = 0; i < numRunning; ++i)
+	{
+		const int label = running[i];
+		const int used = liveBytes - stageBase[label];
+		if(used > stagePeak[label])
+			stagePeak[label] = used;
+	}
+}
+
+void BuildContext::trackFree(int size)
+{
+	liveBytes -= size;
+}
+
+void* BuildContext::allocFunc(int size, rcAllocHint hint)
+{
+	unsigned char* mem = (unsigned char*)rcArenaAlloc(size + ALLOC_HEADER_SIZE, hint);
+	if(!mem) return 0;
+	*(int*)mem = size;
+	if(s_threadContext)
+		s_threadContext->trackAlloc(size);
+	return mem + ALLOC_HEADER_SIZE;
+}
+
+void BuildContext::freeFunc(void* ptr)
+{
+	if(!ptr) return;
+	unsigned char* mem = (unsigned char*)ptr - ALLOC_HEADER_SIZE;
+	if(s_threadContext)
+		s_threadContext->trackFree(*(int*)mem);
+	rcArenaFree(mem);
+}
+
+BuildContextScope::BuildContextScope(BuildContext* ctx) :
+	ctx(ctx),
+	prev(s_threadContext)
+{
+	ctx->resetLog();
+	ctx->resetTimers();
+	ctx->resetMemory();
+	ctx->setOutputStats(0, 0, 0, 0, 0);
+	s_threadContext = ctx;
+	ctx->startTimer(RC_TIMER_TOTAL);
+}
+
+BuildContextScope::~BuildContextScope()
+{
+	ctx->stopTimer(RC_TIMER_TOTAL);
+	s_threadContext = prev;
+}
@@ -43,16 +43,21 @@ rcContourSet* cset = NULL;
 rcPolyMesh* pmesh = NULL;
 rcPolyMeshDetail* dmesh = NULL;
 
+rcArena g_buildArena;
+BuildContext g_buildContext;
+
 void FreeIntermediateData()
 {
 	if(providedVertices)
 	{
 		delete [] providedVertices;
+		providedVertices = NULL;
 		numProvidedVertices = 0;
 	}
 	if(providedIndices)
 	{
 		delete [] providedIndices;
+		providedIndices = NULL;
 		numProvidedIndices = 0;
 	}
 	if(solid)
@@ -87,6 +92,24 @@ void FreeIntermediateData()
 	}
 }
 
+// Frees the intermediate data when the build fails or was not asked to
+// keep it. Declared after the arena scope, so the data is freed while the
+// scope is still active.
+class IntermediateDataScope
+{
+	bool keep;
+	IntermediateDataScope(const IntermediateDataScope&);
+	IntermediateDataScope& operator=(const IntermediateDataScope&);
+public:
+	IntermediateDataScope() : keep(false) {}
+	~IntermediateDataScope()
+	{
+		if(!keep)
+			FreeIntermediateData();
+	}
+	void keepData() { keep = true; }
+};
+
 EXPORT int BuildNavmesh(
 	int numVertices,
 	float* vertices,
@@ -117,6 +140,12 @@ EXPORT int BuildNavmesh(
 	if(oneMillion != 1000000) return -1;
 
 	FreeIntermediateData();
+	if(g_navData)
+	{
+		dtFree(g_navData);
+		g_navData = NULL;
+		g_navDataSize = 0;
+	}
 
 	if(keepIntermediate)
 	{
@@ -129,7 +158,12 @@ EXPORT int BuildNavmesh(
 		numProvidedIndices = numIndices;
 	}
 
-	rcContext ctx;
+	BuildContext::installAllocHooks();
+	BuildContextScope contextScope(&g_buildContext);
+	rcArenaScope arenaScope(&g_buildArena);
+	IntermediateDataScope intermediateScope;
+
+	BuildContext& ctx = g_buildContext;
 	rcConfig cfg;
 	memset(&cfg, 0, sizeof(cfg));
 
@@ -173,7 +207,7 @@ EXPORT int BuildNavmesh(
 
 	int ntris = numIndices / 3;
 
-	unsigned char* triAreas = new unsigned char[ntris];
+	triAreas = new unsigned char[ntris];
 	memset(triAreas, 0, ntris);
 
 	rcMarkWalkableTriangles(&ctx, cfg.walkableSlopeAngle, vertices, numVertices, indices, ntris, triAreas);
@@ -285,10 +319,13 @@ EXPORT int BuildNavmesh(
 	{
 		return -10;
 	}
+
+	ctx.setOutputStats(1, pmesh->npolys, pmesh->nverts, dmesh->ntris, g_navDataSize);
+	ctx.log(RC_LOG_PROGRESS, ">> Polymesh: %d vertices  %d polygons", pmesh->nverts, pmesh->npolys);
 	
-	if(!keepIntermediate)
+	if(keepIntermediate)
 	{
-		FreeIntermediateData();
+		intermediateScope.keepData();
 	}
 
 	return g_navDataSize;
@@ -302,4 +339,19 @@ EXPORT void RetrieveNavmeshData(unsigned char* buffer)
 	g_navDataSize = 0;
 }
 
+EXPORT void GetBuildArenaStats(int* highWaterMark, int* capacity, int* systemAllocs)
+{
+	*highWaterMark = g_buildArena.getHighWaterMark();
+	*capacity = g_buildArena.getCapacity();
+	*systemAllocs = g_buildArena.getSystemAllocCount();
+}
+
+EXPORT void GetBuildReport(BuildReport* report)
+{
+	g_buildContext.getReport(report);
+}
 
+EXPORT int GetBuildLogMessage(int index, char* buffer, int bufferSize)
+{
+	return g_buildContext.getLogMessage(index, buffer, bufferSize);
+}
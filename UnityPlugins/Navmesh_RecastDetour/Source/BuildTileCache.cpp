@@ -0,0 +1,346 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Recast.h>
+#include <DetourNavMesh.h>
+#include <DetourCommon.h>
+#include <DetourTileCache.h>
+#include <DetourTileCacheBuilder.h>
+#include <string.h>
+#include <math.h>
+#include "Navmesh.h"
+#include "TileCacheSet.h"
+#include "ChunkyTriMesh.h"
+#include <vector>
+
+static const int MAX_LAYERS_PER_TILE = 32;
+
+struct TileLayerData
+{
+	unsigned char* data;
+	int dataSize;
+};
+
+// Frees the per-tile intermediate results on every exit path.
+struct TileBuildScratch
+{
+	TileBuildScratch(int maxTris) :
+		solid(rcAllocHeightfield()),
+		chf(rcAllocCompactHeightfield()),
+		lset(rcAllocHeightfieldLayerSet()),
+		triAreas(new unsigned char[maxTris])
+	{
+	}
+
+	~TileBuildScratch()
+	{
+		delete [] triAreas;
+		rcFreeHeightfieldLayerSet(lset);
+		rcFreeCompactHeightfield(chf);
+		rcFreeHeightField(solid);
+	}
+
+	rcHeightfield* solid;
+	rcCompactHeightfield* chf;
+	rcHeightfieldLayerSet* lset;
+	unsigned char* triAreas;
+};
+
+static int RasterizeTileLayers(
+	rcContext* ctx,
+	const rcConfig& tileCfg,
+	const int tx,
+	const int ty,
+	const float* vertices,
+	const int numVertices,
+	const ChunkyTriMesh& chunkyMesh,
+	dtTileCacheCompressor* comp,
+	std::vector<TileLayerData>& layers)
+{
+	rcConfig cfg = tileCfg;
+	const float tcs = cfg.tileSize * cfg.cs;
+
+	// Expand the tile bounds by the border so that neighbouring
+	// tiles agree on the geometry along their shared edge.
+	cfg.bmin[0] = tileCfg.bmin[0] + tx*tcs - cfg.borderSize*cfg.cs;
+	cfg.bmin[2] = tileCfg.bmin[2] + ty*tcs - cfg.borderSize*cfg.cs;
+	cfg.bmax[0] = tileCfg.bmin[0] + (tx+1)*tcs + cfg.borderSize*cfg.cs;
+	cfg.bmax[2] = tileCfg.bmin[2] + (ty+1)*tcs + cfg.borderSize*cfg.cs;
+
+	TileBuildScratch scratch(rcMax(chunkyMesh.getMaxTrisPerChunk(), 1));
+
+	if(!scratch.solid || !rcCreateHeightfield(ctx, *scratch.solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch))
+	{
+		return -2;
+	}
+
+	const float tbmin[2] = { cfg.bmin[0], cfg.bmin[2] };
+	const float tbmax[2] = { cfg.bmax[0], cfg.bmax[2] };
+	std::vector<int> chunks;
+	chunkyMesh.getChunksOverlappingRect(tbmin, tbmax, chunks);
+
+	for(size_t i = 0; i < chunks.size(); ++i)
+	{
+		const int* tris = chunkyMesh.getChunkIndices(chunks[i]);
+		const int ntris = chunkyMesh.getChunkTriCount(chunks[i]);
+
+		memset(scratch.triAreas, 0, ntris);
+		rcMarkWalkableTriangles(ctx, cfg.walkableSlopeAngle, vertices, numVertices, tris, ntris, scratch.triAreas);
+		rcRasterizeTriangles(ctx, vertices, numVertices, tris, scratch.triAreas, ntris, *scratch.solid, cfg.walkableClimb);
+	}
+
+	rcFilterLowHangingWalkableObstacles(ctx, cfg.walkableClimb, *scratch.solid);
+	rcFilterLedgeSpans(ctx, cfg.walkableHeight, cfg.walkableClimb, *scratch.solid);
+	rcFilterWalkableLowHeightSpans(ctx, cfg.walkableHeight, *scratch.solid);
+
+	if(!scratch.chf || !rcBuildCompactHeightfield(ctx, cfg.walkableHeight, cfg.walkableClimb, *scratch.solid, *scratch.chf))
+	{
+		return -3;
+	}
+
+	if(!rcErodeWalkableArea(ctx, cfg.walkableRadius, *scratch.chf))
+	{
+		return -4;
+	}
+
+	if(!scratch.lset || !rcBuildHeightfieldLayers(ctx, *scratch.chf, cfg.borderSize, cfg.walkableHeight, *scratch.lset))
+	{
+		return -5;
+	}
+
+	const rcHeightfieldLayerSet* lset = scratch.lset;
+	for(int i = 0; i < rcMin(lset->nlayers, MAX_LAYERS_PER_TILE); ++i)
+	{
+		const rcHeightfieldLayer* layer = &lset->layers[i];
+
+		dtTileCacheLayerHeader header;
+		header.magic = DT_TILECACHE_MAGIC;
+		header.version = DT_TILECACHE_VERSION;
+		header.tx = tx;
+		header.ty = ty;
+		header.tlayer = i;
+		dtVcopy(header.bmin, layer->bmin);
+		dtVcopy(header.bmax, layer->bmax);
+		header.width = (unsigned char)layer->width;
+		header.height = (unsigned char)layer->height;
+		header.minx = (unsigned char)layer->minx;
+		header.maxx = (unsigned char)layer->maxx;
+		header.miny = (unsigned char)layer->miny;
+		header.maxy = (unsigned char)layer->maxy;
+		header.hmin = (unsigned short)layer->hmin;
+		header.hmax = (unsigned short)layer->hmax;
+
+		TileLayerData tile;
+		dtStatus status = dtBuildTileCacheLayer(
+			comp, &header, layer->heights, layer->areas, layer->cons,
+			&tile.data, &tile.dataSize);
+		if(dtStatusFailed(status))
+		{
+			return -6;
+		}
+		layers.push_back(tile);
+	}
+
+	return 0;
+}
+
+// Builds compressed heightfield layers for every tile of the input geometry
+// and packs them, together with the tile cache and navmesh parameters, into
+// a single blob (see TileCacheSet.h). The blob is retrieved the same way as
+// a navmesh, with RetrieveNavmeshData, and is loaded by the steering plugin
+// to support runtime obstacles. The layers are compressed with the
+// dtTileCacheCompressorType given by compressor.
+//
+// Returns the size of the blob, or a negative error: -2 to -6 when a tile
+// fails to build, -10 when out of memory and -12 for an unknown compressor.
+EXPORT int BuildTileCache(
+	int numVertices,
+	float* vertices,
+	int numIndices,
+	int* indices,
+	float minX,
+	float minY,
+	float minZ,
+	float maxX,
+	float maxY,
+	float maxZ,
+	float cellSize,
+	float cellHeight,
+	float walkableHeight,
+	float walkableSlopeAngle,
+	float walkableClimb,
+	float walkableRadius,
+	float maxSimplificationError,
+	int tileSize,
+	int maxObstacles,
+	int compressor,
+	int oneMillion)
+{
+	if(oneMillion != 1000000) return -1;
+	if(compressor < DT_TILECACHE_COMPRESSOR_NONE || compressor > DT_TILECACHE_COMPRESSOR_RLE) return -12;
+
+	FreeIntermediateData();
+	if(g_navData)
+	{
+		dtFree(g_navData);
+		g_navData = NULL;
+		g_navDataSize = 0;
+	}
+
+	BuildContext::installAllocHooks();
+	BuildContextScope contextScope(&g_buildContext);
+
+	BuildContext& ctx = g_buildContext;
+	rcConfig cfg;
+	memset(&cfg, 0, sizeof(cfg));
+
+	// Rasterization
+	cfg.cs = cellSize;
+	cfg.ch = cellHeight;
+
+	// Agent
+	cfg.walkableHeight = (int)ceilf(walkableHeight / cellHeight);
+	cfg.walkableRadius = (int)ceilf(walkableRadius / cellSize);
+	cfg.walkableClimb = (int)floorf(walkableClimb / cellHeight);
+	cfg.walkableSlopeAngle = walkableSlopeAngle;
+
+	// Polygonization
+	cfg.maxSimplificationError = maxSimplificationError;
+	cfg.maxVertsPerPoly = DT_VERTS_PER_POLYGON;
+
+	// Tiling
+	cfg.tileSize = tileSize;
+	cfg.borderSize = cfg.walkableRadius + 3;
+	cfg.width = cfg.tileSize + cfg.borderSize*2;
+	cfg.height = cfg.tileSize + cfg.borderSize*2;
+
+	cfg.bmin[0] = minX;
+	cfg.bmin[1] = minY;
+	cfg.bmin[2] = minZ;
+	cfg.bmax[0] = maxX;
+	cfg.bmax[1] = maxY;
+	cfg.bmax[2] = maxZ;
+
+	int gridWidth = 0;
+	int gridHeight = 0;
+	rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &gridWidth, &gridHeight);
+	const int tilesWide = (gridWidth + tileSize-1) / tileSize;
+	const int tilesHigh = (gridHeight + tileSize-1) / tileSize;
+
+	TileCacheSetHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = TILECACHESET_MAGIC;
+	header.version = TILECACHESET_VERSION;
+
+	dtTileCacheParams& tcparams = header.cacheParams;
+	rcVcopy(tcparams.orig, cfg.bmin);
+	tcparams.cs = cfg.cs;
+	tcparams.ch = cfg.ch;
+	tcparams.width = cfg.tileSize;
+	tcparams.height = cfg.tileSize;
+	tcparams.walkableHeight = walkableHeight;
+	tcparams.walkableRadius = walkableRadius;
+	tcparams.walkableClimb = walkableClimb;
+	tcparams.maxSimplificationError = maxSimplificationError;
+	tcparams.maxObstacles = maxObstacles;
+
+	dtNavMeshParams& meshParams = header.meshParams;
+	rcVcopy(meshParams.orig, cfg.bmin);
+	meshParams.tileWidth = cfg.tileSize*cfg.cs;
+	meshParams.tileHeight = cfg.tileSize*cfg.cs;
+
+	dtTileCacheCompressor* comp = dtAllocTileCacheCompressor(compressor);
+	if(!comp) return -10;
+	header.compressor = compressor;
+
+	// Built once so each tile only rasterizes the triangles near it.
+	ChunkyTriMesh chunkyMesh;
+	chunkyMesh.build(vertices, indices, numIndices / 3, CHUNKYTRIMESH_TRIS_PER_CHUNK);
+
+	std::vector<TileLayerData> layers;
+
+	// Each tile's Recast temporaries come from the build arena, which is
+	// reset after every tile.
+	int result = 0;
+	for(int ty = 0; ty < tilesHigh && result == 0; ++ty)
+	{
+		for(int tx = 0; tx < tilesWide && result == 0; ++tx)
+		{
+			rcArenaScope arenaScope(&g_buildArena);
+			result = RasterizeTileLayers(
+				&ctx, cfg, tx, ty, 
+				vertices, numVertices, chunkyMesh, 
+				comp, layers);
+		}
+	}
+
+	if(result == 0)
+	{
+		// Every layer becomes a tile of the cache and of the navmesh, and
+		// a tile can have up to MAX_LAYERS_PER_TILE of them, so size both
+		// from the layers actually built.
+		tcparams.maxTiles = rcMax((int)layers.size(), 1);
+
+		// Split the 32 bit poly ref between tile and poly indices.
+		const int tileBits = rcMin((int)dtIlog2(dtNextPow2(tcparams.maxTiles)), 14);
+		const int polyBits = 22 - tileBits;
+		meshParams.maxTiles = 1 << tileBits;
+		meshParams.maxPolys = 1 << polyBits;
+
+		int dataSize = sizeof(TileCacheSetHeader);
+		for(size_t i = 0; i < layers.size(); ++i)
+			dataSize += sizeof(TileCacheTileHeader) + layers[i].dataSize;
+
+		g_navData = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		if(g_navData)
+		{
+			header.numTiles = (int)layers.size();
+			unsigned char* out = g_navData;
+			memcpy(out, &header, sizeof(header));
+			out += sizeof(header);
+			for(size_t i = 0; i < layers.size(); ++i)
+			{
+				TileCacheTileHeader tileHeader;
+				tileHeader.tileRef = 0;
+				tileHeader.dataSize = layers[i].dataSize;
+				memcpy(out, &tileHeader, sizeof(tileHeader));
+				out += sizeof(tileHeader);
+				memcpy(out, layers[i].data, layers[i].dataSize);
+				out += layers[i].dataSize;
+			}
+			g_navDataSize = dataSize;
+			ctx.setOutputStats((int)layers.size(), 0, 0, 0, dataSize);
+		}
+		else
+		{
+			result = -10;
+		}
+	}
+
+	for(size_t i = 0; i < layers.size(); ++i)
+		dtFree(layers[i].data);
+	dtFreeTileCacheCompressor(comp);
+
+	if(result != 0)
+		return result;
+	return g_navDataSize;
+}
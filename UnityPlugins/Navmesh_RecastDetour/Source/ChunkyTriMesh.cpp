@@ -0,0 +1,170 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ChunkyTriMesh.h"
+#include <algorithm>
+
+struct CompareItemX
+{
+	template<class T> bool operator()(const T& a, const T& b) const
+	{
+		return a.bmin[0] < b.bmin[0];
+	}
+};
+
+struct CompareItemY
+{
+	template<class T> bool operator()(const T& a, const T& b) const
+	{
+		return a.bmin[1] < b.bmin[1];
+	}
+};
+
+ChunkyTriMesh::ChunkyTriMesh()
+	: maxTrisPerChunk(0)
+{
+}
+
+void ChunkyTriMesh::clear()
+{
+	nodes.clear();
+	indices.clear();
+	maxTrisPerChunk = 0;
+}
+
+bool ChunkyTriMesh::build(const float* vertices, const int* srcIndices, int ntris, int trisPerChunk)
+{
+	clear();
+	if(ntris <= 0 || trisPerChunk <= 0)
+		return false;
+
+	std::vector<BoundsItem> items(ntris);
+	for(int i = 0; i < ntris; ++i)
+	{
+		const int* t = &srcIndices[i*3];
+		BoundsItem& it = items[i];
+		it.i = i;
+		it.bmin[0] = it.bmax[0] = vertices[t[0]*3+0];
+		it.bmin[1] = it.bmax[1] = vertices[t[0]*3+2];
+		for(int j = 1; j < 3; ++j)
+		{
+			const float* v = &vertices[t[j]*3];
+			it.bmin[0] = std::min(it.bmin[0], v[0]);
+			it.bmin[1] = std::min(it.bmin[1], v[2]);
+			it.bmax[0] = std::max(it.bmax[0], v[0]);
+			it.bmax[1] = std::max(it.bmax[1], v[2]);
+		}
+	}
+
+	// A full binary tree over ntris/trisPerChunk leaves.
+	const int nchunks = (ntris + trisPerChunk-1) / trisPerChunk;
+	nodes.reserve(nchunks*4);
+	indices.reserve(ntris*3);
+
+	subdivide(items, 0, ntris, trisPerChunk, srcIndices);
+
+	for(size_t i = 0; i < nodes.size(); ++i)
+	{
+		if(nodes[i].i >= 0)
+			maxTrisPerChunk = std::max(maxTrisPerChunk, nodes[i].n);
+	}
+
+	return true;
+}
+
+void ChunkyTriMesh::subdivide(
+	std::vector<BoundsItem>& items, 
+	int imin, 
+	int imax, 
+	int trisPerChunk, 
+	const int* srcIndices)
+{
+	const int inum = imax - imin;
+	const int icur = (int)nodes.size();
+
+	Node node;
+	node.bmin[0] = items[imin].bmin[0];
+	node.bmin[1] = items[imin].bmin[1];
+	node.bmax[0] = items[imin].bmax[0];
+	node.bmax[1] = items[imin].bmax[1];
+	for(int i = imin+1; i < imax; ++i)
+	{
+		node.bmin[0] = std::min(node.bmin[0], items[i].bmin[0]);
+		node.bmin[1] = std::min(node.bmin[1], items[i].bmin[1]);
+		node.bmax[0] = std::max(node.bmax[0], items[i].bmax[0]);
+		node.bmax[1] = std::max(node.bmax[1], items[i].bmax[1]);
+	}
+
+	if(inum <= trisPerChunk)
+	{
+		// Leaf, copy the triangles so the chunk is contiguous.
+		node.i = (int)indices.size() / 3;
+		node.n = inum;
+		for(int i = imin; i < imax; ++i)
+		{
+			const int* t = &srcIndices[items[i].i*3];
+			indices.push_back(t[0]);
+			indices.push_back(t[1]);
+			indices.push_back(t[2]);
+		}
+		nodes.push_back(node);
+		return;
+	}
+
+	// Split along the longest axis.
+	node.i = 0;
+	node.n = 0;
+	nodes.push_back(node);
+
+	if(node.bmax[0] - node.bmin[0] >= node.bmax[1] - node.bmin[1])
+		std::sort(items.begin()+imin, items.begin()+imax, CompareItemX());
+	else
+		std::sort(items.begin()+imin, items.begin()+imax, CompareItemY());
+
+	const int isplit = imin + inum/2;
+	subdivide(items, imin, isplit, trisPerChunk, srcIndices);
+	subdivide(items, isplit, imax, trisPerChunk, srcIndices);
+
+	nodes[icur].i = -((int)nodes.size() - icur);
+}
+
+void ChunkyTriMesh::getChunksOverlappingRect(const float* bmin, const float* bmax, std::vector<int>& chunks) const
+{
+	const int nnodes = (int)nodes.size();
+	int i = 0;
+	while(i < nnodes)
+	{
+		const Node& node = nodes[i];
+		const bool overlap = 
+			bmin[0] <= node.bmax[0] && bmax[0] >= node.bmin[0] &&
+			bmin[1] <= node.bmax[1] && bmax[1] >= node.bmin[1];
+		const bool isLeaf = node.i >= 0;
+
+		if(isLeaf && overlap)
+			chunks.push_back(i);
+
+		if(overlap || isLeaf)
+			i++;
+		else
+			i += -node.i;
+	}
+}
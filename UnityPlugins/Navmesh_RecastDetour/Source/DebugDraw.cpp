@@ -24,40 +24,133 @@
 #include <RecastDebugDraw.h>
 #include <DetourDebugDraw.h>
 #include <DetourCommon.h>
+#include <string.h>
+#include <stddef.h>
 #include "Navmesh.h"
 
 #include <vector>
 
 static const float DD_SIZE_MULTIPLIER = 0.002f;
 
+// Vertex layout of RetrieveDebugDrawVertices, with the color as RGBA bytes
+// to match Color32.
+struct DebugDrawVertex
+{
+	float pos[3];
+	float normal[3];
+	unsigned int color;
+	float uv[2];
+};
+
+// Geometry of one debug draw call, or of one navmesh tile
+struct DebugMesh
+{
+	std::vector<DebugDrawVertex> vertices;
+	std::vector<int> indices;
+
+	void Release()
+	{
+		std::vector<DebugDrawVertex>().swap(vertices);
+		std::vector<int>().swap(indices);
+	}
+};
+
 class UnityDebugDraw : public duDebugDraw
 {
 public:
-	UnityDebugDraw() {}
+	UnityDebugDraw() : target(&mesh) {}
 	virtual ~UnityDebugDraw() {}
 
 	void InitDrawing(const float* screenUp, const float* screenRight, const float* screenOut)
 	{
-		vertices.clear();
-		normals.clear();
-		colors.clear();
-		uvs.clear();
-		indices.clear();
+		mesh.vertices.clear();
+		mesh.indices.clear();
+		target = &mesh;
+		output.clear();
+		output.push_back(&mesh);
 
 		dtVcopy(this->screenUp, screenUp);
 		dtVcopy(this->screenRight, screenRight);
 		dtVcopy(this->screenOut, screenOut);
 	}
-	int GetNumVertices() { return vertices.size()/3; }
-	int GetNumIndices() { return indices.size(); }
+
+	// Draws into the given mesh instead of the one of the draw call,
+	// clearing it and reserving room for the expected vertices and
+	// indices. NULL goes back to the mesh of the draw call.
+	void SetTarget(DebugMesh* target, int numVertices, int numIndices)
+	{
+		this->target = target ? target : &mesh;
+		if(target)
+		{
+			target->vertices.clear();
+			target->indices.clear();
+		}
+		Reserve(numVertices, numIndices);
+	}
+
+	void Reserve(int numVertices, int numIndices)
+	{
+		target->vertices.reserve(target->vertices.size() + numVertices);
+		target->indices.reserve(target->indices.size() + numIndices);
+	}
+
+	// Adds a mesh drawn earlier to the output of this draw call. It must
+	// stay unchanged until the output has been retrieved.
+	void AddToOutput(const DebugMesh* drawn) { output.push_back(drawn); }
+
+	int GetNumVertices()
+	{
+		int count = 0;
+		for(size_t i = 0; i < output.size(); ++i)
+			count += (int)output[i]->vertices.size();
+		return count;
+	}
+	int GetNumIndices()
+	{
+		int count = 0;
+		for(size_t i = 0; i < output.size(); ++i)
+			count += (int)output[i]->indices.size();
+		return count;
+	}
 
 	void RetrieveMesh(float* vertices, float* colors, float* uvs, float* normals, int* indices)
 	{
-		std::copy(this->vertices.begin(), this->vertices.end(), vertices);
-		std::copy(this->colors.begin(), this->colors.end(), colors);
-		std::copy(this->uvs.begin(), this->uvs.end(), uvs);
-		std::copy(this->normals.begin(), this->normals.end(), normals);
-		std::copy(this->indices.begin(), this->indices.end(), indices);
+		int base = 0;
+		for(size_t i = 0; i < output.size(); ++i)
+		{
+			const DebugMesh* drawn = output[i];
+			const int numVertices = (int)drawn->vertices.size();
+			for(int j = 0; j < numVertices; ++j)
+			{
+				const DebugDrawVertex& v = drawn->vertices[j];
+				dtVcopy(vertices, v.pos);
+				dtVcopy(normals, v.normal);
+				ExtractColor(v.color, colors);
+				uvs[0] = v.uv[0];
+				uvs[1] = v.uv[1];
+				vertices += 3;
+				normals += 3;
+				colors += 4;
+				uvs += 2;
+			}
+			indices = CopyIndices(drawn, base, indices);
+			base += numVertices;
+		}
+	}
+
+	void RetrieveInterleavedMesh(DebugDrawVertex* vertices, int* indices)
+	{
+		int base = 0;
+		for(size_t i = 0; i < output.size(); ++i)
+		{
+			const DebugMesh* drawn = output[i];
+			const int numVertices = (int)drawn->vertices.size();
+			if(numVertices > 0)
+				memcpy(vertices, &drawn->vertices[0], sizeof(DebugDrawVertex)*numVertices);
+			vertices += numVertices;
+			indices = CopyIndices(drawn, base, indices);
+			base += numVertices;
+		}
 	}
 
 	virtual void depthMask(bool state) { }
@@ -156,6 +249,7 @@ public:
 
 	void DrawProvidedGeometry() 
 	{
+		Reserve(numProvidedIndices, numProvidedIndices);
 		begin(DU_DRAW_TRIS);
 		for(int i=0; i<numProvidedIndices; i++)
 		{
@@ -215,14 +309,13 @@ private:
 
 	void doVertex(const float* pos, unsigned int color, const float* uv, const float* norms)
 	{
-		vertices.resize(vertices.size()+3);
-		dtVcopy(&vertices[vertices.size()-3], pos);
-		colors.resize(colors.size()+4);
-		ExtractColor(color, &colors[colors.size()-4]);
-		uvs.push_back(uv[0]);
-		uvs.push_back(uv[1]);
-		normals.resize(normals.size()+3);
-		dtVcopy(&normals[normals.size()-3], norms);
+		DebugDrawVertex v;
+		dtVcopy(v.pos, pos);
+		dtVcopy(v.normal, norms);
+		v.color = color;
+		v.uv[0] = uv[0];
+		v.uv[1] = uv[1];
+		target->vertices.push_back(v);
 	}
 	/*
 	void doVertex(const float x, const float y, const float z, unsigned int color)
@@ -246,11 +339,18 @@ private:
 
 	void makeTriangle(int offA, int offB, int offC)
 	{
-		int base = vertices.size()/3;
-		indices.resize(indices.size()+3);
-		indices[indices.size()-3] = base+offA;
-		indices[indices.size()-2] = base+offB;
-		indices[indices.size()-1] = base+offC;
+		const int base = (int)target->vertices.size();
+		target->indices.push_back(base+offA);
+		target->indices.push_back(base+offB);
+		target->indices.push_back(base+offC);
+	}
+
+	static int* CopyIndices(const DebugMesh* drawn, int base, int* indices)
+	{
+		const int numIndices = (int)drawn->indices.size();
+		for(int i = 0; i < numIndices; ++i)
+			indices[i] = base + drawn->indices[i];
+		return indices + numIndices;
 	}
 
 	duDebugDrawPrimitives currentPrim;
@@ -264,15 +364,100 @@ private:
 	float screenRight[3];
 	float screenOut[3];
 
-	std::vector<float> vertices;
-	std::vector<float> normals;
-	std::vector<float> colors;
-	std::vector<float> uvs;
-	std::vector<int> indices;
+	DebugMesh mesh;
+	DebugMesh* target;
+	std::vector<const DebugMesh*> output;
 };
 
 UnityDebugDraw unityDebugDraw;
 
+// Room to reserve for a tile: every detail triangle has its own three
+// vertices and every polygon edge becomes a quad, and more where the
+// detail mesh splits an edge.
+static void EstimateTileDebugMesh(const dtMeshTile* tile, int* numVertices, int* numIndices)
+{
+	int edges = 0;
+	for(int i = 0; i < tile->header->polyCount; ++i)
+		edges += tile->polys[i].vertCount;
+	const int tris = tile->header->detailTriCount;
+	*numVertices = tris*3 + edges*4;
+	*numIndices = tris*3 + edges*6;
+}
+
+// FNV-1a over the tile data, which holds the polygon flags and areas and
+// the links to neighbouring tiles along with the geometry.
+static unsigned int HashTileData(const dtMeshTile* tile)
+{
+	const unsigned int* words = (const unsigned int*)tile->data;
+	const int numWords = tile->dataSize / 4;
+	unsigned int hash = 2166136261u;
+	for(int i = 0; i < numWords; ++i)
+		hash = (hash ^ words[i]) * 16777619u;
+	return hash;
+}
+
+// Keeps the debug mesh of every tile of the navmesh last drawn, and only
+// draws a tile again when its data has changed. A navmesh created again
+// from the same data reuses the meshes.
+class NavmeshDebugCache
+{
+public:
+	void Draw(UnityDebugDraw* dd, const dtNavMesh& navMesh, unsigned char flags)
+	{
+		if((int)tiles.size() != navMesh.getMaxTiles())
+			tiles.resize(navMesh.getMaxTiles());
+
+		for(int i = 0; i < navMesh.getMaxTiles(); ++i)
+		{
+			const dtMeshTile* tile = navMesh.getTile(i);
+			CachedTile& cached = tiles[i];
+			if(!tile->header)
+			{
+				if(cached.ref)
+				{
+					cached.ref = 0;
+					cached.mesh.Release();
+				}
+				continue;
+			}
+
+			const dtTileRef ref = navMesh.getTileRef(tile);
+			const unsigned int hash = HashTileData(tile);
+			if(cached.ref != ref || cached.dataSize != tile->dataSize || 
+				cached.hash != hash || cached.flags != flags)
+			{
+				int numVertices, numIndices;
+				EstimateTileDebugMesh(tile, &numVertices, &numIndices);
+				dd->SetTarget(&cached.mesh, numVertices, numIndices);
+				duDebugDrawNavMeshTile(dd, navMesh, tile, flags);
+				dd->SetTarget(NULL, 0, 0);
+
+				cached.ref = ref;
+				cached.dataSize = tile->dataSize;
+				cached.hash = hash;
+				cached.flags = flags;
+			}
+			dd->AddToOutput(&cached.mesh);
+		}
+	}
+
+private:
+	struct CachedTile
+	{
+		CachedTile() : ref(0), dataSize(0), hash(0), flags(0) {}
+
+		dtTileRef ref;
+		int dataSize;
+		unsigned int hash;
+		unsigned char flags;
+		DebugMesh mesh;
+	};
+
+	std::vector<CachedTile> tiles;
+};
+
+NavmeshDebugCache navmeshDebugCache;
+
 enum DebugDrawType
 {
 	DDT_None = 0,
@@ -292,7 +477,7 @@ enum DebugDrawType
 EXPORT void DebugDrawNavmesh(dtNavMesh* navMesh, float* screenUp, float* screenRight, float* screenOut, int* outNumVertices, int* outNumIndices)
 {
 	unityDebugDraw.InitDrawing(screenUp, screenRight, screenOut);
-	duDebugDrawNavMesh(&unityDebugDraw, *navMesh, 0);
+	navmeshDebugCache.Draw(&unityDebugDraw, *navMesh, 0);
 	*outNumVertices = unityDebugDraw.GetNumVertices();
 	*outNumIndices = unityDebugDraw.GetNumIndices();
 }
@@ -373,6 +558,11 @@ EXPORT void RetrieveDebugDrawData(float* vertices, float* colors, float* uvs, fl
 	unityDebugDraw.RetrieveMesh(vertices, colors, uvs, normals, indices);
 }
 
+EXPORT void RetrieveDebugDrawVertices(DebugDrawVertex* vertices, int* indices)
+{
+	unityDebugDraw.RetrieveInterleavedMesh(vertices, indices);
+}
+
 EXPORT dtNavMesh* DebugInitNavmesh(unsigned char* data, int dataSize)
 {
 	dtNavMesh* nm = new dtNavMesh;
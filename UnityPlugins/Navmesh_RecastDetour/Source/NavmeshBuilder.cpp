@@ -0,0 +1,612 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Recast.h>
+#include <DetourNavMesh.h>
+#include <DetourNavMeshBuilder.h>
+#include <DetourCommon.h>
+#include <string.h>
+#include <math.h>
+#include "Navmesh.h"
+#include "NavmeshBuilder.h"
+#include "NavMeshSet.h"
+#include <vector>
+#ifdef _MSC_VER
+#include <ppl.h>
+#endif
+
+// Frees the per-tile intermediate results on every exit path.
+struct NavmeshTileScratch
+{
+	NavmeshTileScratch() :
+		solid(rcAllocHeightfield()),
+		chf(rcAllocCompactHeightfield()),
+		cset(rcAllocContourSet()),
+		pmesh(rcAllocPolyMesh()),
+		dmesh(rcAllocPolyMeshDetail())
+	{
+	}
+
+	~NavmeshTileScratch()
+	{
+		rcFreePolyMeshDetail(dmesh);
+		rcFreePolyMesh(pmesh);
+		rcFreeContourSet(cset);
+		rcFreeCompactHeightfield(chf);
+		rcFreeHeightField(solid);
+	}
+
+	rcHeightfield* solid;
+	rcCompactHeightfield* chf;
+	rcContourSet* cset;
+	rcPolyMesh* pmesh;
+	rcPolyMeshDetail* dmesh;
+	std::vector<unsigned char> triAreas;
+	std::vector<int> chunks;
+};
+
+NavmeshBuilder::NavmeshBuilder()
+	: monotonePartitioning(false), walkableHeight(0), walkableRadius(0), walkableClimb(0),
+	tilesWide(0), tilesHigh(0)
+{
+	memset(&cfg, 0, sizeof(cfg));
+	memset(&navMeshParams, 0, sizeof(navMeshParams));
+}
+
+NavmeshBuilder::~NavmeshBuilder()
+{
+	for(size_t i = 0; i < arenas.size(); ++i)
+		delete arenas[i];
+	for(size_t i = 0; i < contexts.size(); ++i)
+		delete contexts[i];
+}
+
+bool NavmeshBuilder::init(
+	const rcConfig& config, 
+	bool monotone, 
+	float agentHeight, 
+	float agentRadius, 
+	float agentClimb)
+{
+	if(config.tileSize <= 0)
+		return false;
+
+	cfg = config;
+	cfg.borderSize = cfg.walkableRadius + 3;
+	cfg.width = cfg.tileSize + cfg.borderSize*2;
+	cfg.height = cfg.tileSize + cfg.borderSize*2;
+	monotonePartitioning = monotone;
+	walkableHeight = agentHeight;
+	walkableRadius = agentRadius;
+	walkableClimb = agentClimb;
+
+	int gridWidth = 0;
+	int gridHeight = 0;
+	rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &gridWidth, &gridHeight);
+	tilesWide = (gridWidth + cfg.tileSize-1) / cfg.tileSize;
+	tilesHigh = (gridHeight + cfg.tileSize-1) / cfg.tileSize;
+
+	// Split the 32 bit poly ref between tile and poly indices.
+	const int tileBits = rcMin((int)dtIlog2(dtNextPow2(tilesWide*tilesHigh)), 14);
+	const int polyBits = 22 - tileBits;
+
+	rcVcopy(navMeshParams.orig, cfg.bmin);
+	navMeshParams.tileWidth = cfg.tileSize*cfg.cs;
+	navMeshParams.tileHeight = cfg.tileSize*cfg.cs;
+	navMeshParams.maxTiles = 1 << tileBits;
+	navMeshParams.maxPolys = 1 << polyBits;
+
+	meshes.clear();
+	markAllDirty();
+	return true;
+}
+
+void NavmeshBuilder::setMesh(
+	int meshId, 
+	int numVertices, 
+	const float* vertices, 
+	int numIndices, 
+	const int* indices)
+{
+	// A moved or edited mesh dirties the tiles it left as well as the
+	// ones it now covers.
+	std::map<int, Mesh>::iterator it = meshes.find(meshId);
+	if(it != meshes.end())
+	{
+		markDirty(it->second.bmin, it->second.bmax);
+		meshes.erase(it);
+	}
+	if(numVertices <= 0 || numIndices < 3)
+		return;
+
+	Mesh& mesh = meshes[meshId];
+	mesh.vertices.assign(vertices, vertices + numVertices*3);
+	mesh.chunkyMesh.build(vertices, indices, numIndices/3, CHUNKYTRIMESH_TRIS_PER_CHUNK);
+	rcCalcBounds(vertices, numVertices, mesh.bmin, mesh.bmax);
+	markDirty(mesh.bmin, mesh.bmax);
+}
+
+void NavmeshBuilder::removeMesh(int meshId)
+{
+	std::map<int, Mesh>::iterator it = meshes.find(meshId);
+	if(it == meshes.end())
+		return;
+	markDirty(it->second.bmin, it->second.bmax);
+	meshes.erase(it);
+}
+
+void NavmeshBuilder::markAllDirty()
+{
+	dirtyTiles.assign(tilesWide*tilesHigh, 1);
+}
+
+void NavmeshBuilder::markDirty(const float* bmin, const float* bmax)
+{
+	// Tiles rasterize a border around themselves, so geometry near an
+	// edge also affects the neighbouring tile.
+	const float border = cfg.borderSize*cfg.cs;
+	const float tileWorld = cfg.tileSize*cfg.cs;
+	int minX = (int)floorf((bmin[0] - border - cfg.bmin[0]) / tileWorld);
+	int minY = (int)floorf((bmin[2] - border - cfg.bmin[2]) / tileWorld);
+	int maxX = (int)floorf((bmax[0] + border - cfg.bmin[0]) / tileWorld);
+	int maxY = (int)floorf((bmax[2] + border - cfg.bmin[2]) / tileWorld);
+	if(maxX < 0 || maxY < 0 || minX >= tilesWide || minY >= tilesHigh)
+		return;
+
+	minX = rcMax(minX, 0);
+	minY = rcMax(minY, 0);
+	maxX = rcMin(maxX, tilesWide-1);
+	maxY = rcMin(maxY, tilesHigh-1);
+	for(int y = minY; y <= maxY; ++y)
+		for(int x = minX; x <= maxX; ++x)
+			dirtyTiles[x + y*tilesWide] = 1;
+}
+
+void NavmeshBuilder::buildTile(rcContext* ctx, TileResult& result) const
+{
+	result.status = 0;
+	result.data = NULL;
+	result.dataSize = 0;
+
+	const float tileWorld = cfg.tileSize*cfg.cs;
+	const float border = cfg.borderSize*cfg.cs;
+
+	rcConfig tileCfg = cfg;
+	tileCfg.bmin[0] = cfg.bmin[0] + result.tileX*tileWorld - border;
+	tileCfg.bmin[2] = cfg.bmin[2] + result.tileY*tileWorld - border;
+	tileCfg.bmax[0] = cfg.bmin[0] + (result.tileX+1)*tileWorld + border;
+	tileCfg.bmax[2] = cfg.bmin[2] + (result.tileY+1)*tileWorld + border;
+
+	NavmeshTileScratch scratch;
+	if(!scratch.solid || !scratch.chf || !scratch.cset || !scratch.pmesh || !scratch.dmesh)
+	{
+		result.status = -11;
+		return;
+	}
+
+	if(!rcCreateHeightfield(ctx, *scratch.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
+	{
+		result.status = -2;
+		return;
+	}
+
+	const float tbmin[2] = { tileCfg.bmin[0], tileCfg.bmin[2] };
+	const float tbmax[2] = { tileCfg.bmax[0], tileCfg.bmax[2] };
+
+	bool hasGeometry = false;
+	for(std::map<int, Mesh>::const_iterator it = meshes.begin(); it != meshes.end(); ++it)
+	{
+		const Mesh& mesh = it->second;
+		if(mesh.bmin[0] > tbmax[0] || mesh.bmax[0] < tbmin[0] ||
+			mesh.bmin[2] > tbmax[1] || mesh.bmax[2] < tbmin[1])
+			continue;
+
+		scratch.chunks.clear();
+		mesh.chunkyMesh.getChunksOverlappingRect(tbmin, tbmax, scratch.chunks);
+		if(scratch.chunks.empty())
+			continue;
+
+		const float* verts = &mesh.vertices[0];
+		const int nverts = (int)mesh.vertices.size() / 3;
+		scratch.triAreas.resize(mesh.chunkyMesh.getMaxTrisPerChunk());
+		for(size_t i = 0; i < scratch.chunks.size(); ++i)
+		{
+			const int* tris = mesh.chunkyMesh.getChunkIndices(scratch.chunks[i]);
+			const int ntris = mesh.chunkyMesh.getChunkTriCount(scratch.chunks[i]);
+
+			memset(&scratch.triAreas[0], 0, ntris);
+			rcMarkWalkableTriangles(ctx, tileCfg.walkableSlopeAngle, verts, nverts, tris, ntris, &scratch.triAreas[0]);
+			rcRasterizeTriangles(ctx, verts, nverts, tris, &scratch.triAreas[0], ntris, *scratch.solid, tileCfg.walkableClimb);
+		}
+		hasGeometry = true;
+	}
+
+	// Nothing to walk on; the tile is sent with no data so it gets removed.
+	if(!hasGeometry)
+		return;
+
+	rcFilterLowHangingWalkableObstacles(ctx, tileCfg.walkableClimb, *scratch.solid);
+	rcFilterLedgeSpans(ctx, tileCfg.walkableHeight, tileCfg.walkableClimb, *scratch.solid);
+	rcFilterWalkableLowHeightSpans(ctx, tileCfg.walkableHeight, *scratch.solid);
+
+	if(!rcBuildCompactHeightfield(ctx, tileCfg.walkableHeight, tileCfg.walkableClimb, *scratch.solid, *scratch.chf))
+	{
+		result.status = -3;
+		return;
+	}
+
+	if(!rcErodeWalkableArea(ctx, tileCfg.walkableRadius, *scratch.chf))
+	{
+		result.status = -4;
+		return;
+	}
+
+	if(!rcBuildDistanceField(ctx, *scratch.chf))
+	{
+		result.status = -5;
+		return;
+	}
+
+	if(monotonePartitioning)
+	{
+		if(!rcBuildRegionsMonotone(ctx, *scratch.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
+		{
+			result.status = -6;
+			return;
+		}
+	}
+	else
+	{
+		if(!rcBuildRegions(ctx, *scratch.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
+		{
+			result.status = -6;
+			return;
+		}
+	}
+
+	if(!rcBuildContours(ctx, *scratch.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *scratch.cset))
+	{
+		result.status = -7;
+		return;
+	}
+
+	if(scratch.cset->nconts == 0)
+		return;
+
+	if(!rcBuildPolyMesh(ctx, *scratch.cset, tileCfg.maxVertsPerPoly, *scratch.pmesh))
+	{
+		result.status = -8;
+		return;
+	}
+
+	if(!rcBuildPolyMeshDetail(ctx, *scratch.pmesh, *scratch.chf, tileCfg.detailSampleDist, tileCfg.detailSampleMaxError, *scratch.dmesh))
+	{
+		result.status = -9;
+		return;
+	}
+
+	rcPolyMesh* pmesh = scratch.pmesh;
+	rcPolyMeshDetail* dmesh = scratch.dmesh;
+	if(pmesh->npolys == 0)
+		return;
+	result.polyCount = pmesh->npolys;
+	result.vertCount = pmesh->nverts;
+	result.detailTriCount = dmesh->ntris;
+
+	for(int i = 0; i < pmesh->npolys; ++i)
+	{
+		if(pmesh->areas[i] == RC_WALKABLE_AREA)
+		{
+			pmesh->flags[i] = -1;
+		}
+		else
+		{
+			pmesh->flags[i] = 0;
+		}
+	}
+
+	dtNavMeshCreateParams params;
+	memset(&params, 0, sizeof(params));
+	params.verts = pmesh->verts;
+	params.vertCount = pmesh->nverts;
+	params.polys = pmesh->polys;
+	params.polyAreas = pmesh->areas;
+	params.polyFlags = pmesh->flags;
+	params.polyCount = pmesh->npolys;
+	params.nvp = pmesh->nvp;
+	params.detailMeshes = dmesh->meshes;
+	params.detailVerts = dmesh->verts;
+	params.detailVertsCount = dmesh->nverts;
+	params.detailTris = dmesh->tris;
+	params.detailTriCount = dmesh->ntris;
+	params.walkableHeight = walkableHeight;
+	params.walkableRadius = walkableRadius;
+	params.walkableClimb = walkableClimb;
+	params.tileX = result.tileX;
+	params.tileY = result.tileY;
+	params.tileLayer = 0;
+	rcVcopy(params.bmin, pmesh->bmin);
+	rcVcopy(params.bmax, pmesh->bmax);
+	params.cs = tileCfg.cs;
+	params.ch = tileCfg.ch;
+	params.buildBvTree = true;
+
+	if(!dtCreateNavMeshData(&params, &result.data, &result.dataSize))
+	{
+		result.status = -10;
+		return;
+	}
+}
+
+void NavmeshBuilder::buildTiles(rcArena* arena, BuildContext* ctx, int first, int stride, std::vector<TileResult>& results) const
+{
+	BuildContextScope contextScope(ctx);
+	for(int i = first; i < (int)results.size(); i += stride)
+	{
+		rcArenaScope scope(arena);
+		buildTile(ctx, results[i]);
+	}
+}
+
+int NavmeshBuilder::build(BuildContext* ctx, unsigned char** outData, int* outDataSize)
+{
+	*outData = NULL;
+	*outDataSize = 0;
+
+	std::vector<TileResult> results;
+	for(int y = 0; y < tilesHigh; ++y)
+	{
+		for(int x = 0; x < tilesWide; ++x)
+		{
+			if(!dirtyTiles[x + y*tilesWide])
+				continue;
+			TileResult tile;
+			memset(&tile, 0, sizeof(tile));
+			tile.tileX = x;
+			tile.tileY = y;
+			results.push_back(tile);
+		}
+	}
+
+	// Tiles are independent, each reads the shared geometry and writes
+	// only its own result. Every worker takes every numWorkers'th tile
+	// and builds it in its own scratch arena.
+	const int numTiles = (int)results.size();
+#ifdef _MSC_VER
+	const int numWorkers = rcMin((int)Concurrency::GetProcessorCount(), numTiles);
+#else
+	const int numWorkers = rcMin(1, numTiles);
+#endif
+	while((int)arenas.size() < numWorkers)
+		arenas.push_back(new rcArena);
+	while((int)contexts.size() < numWorkers)
+		contexts.push_back(new BuildContext);
+
+	// The same hooks as the single-shot builds, since Recast memory may
+	// be freed under either.
+	BuildContext::installAllocHooks();
+#ifdef _MSC_VER
+	Concurrency::parallel_for(0, numWorkers, [&](int worker)
+	{
+		buildTiles(arenas[worker], contexts[worker], worker, numWorkers, results);
+	});
+#else
+	for(int worker = 0; worker < numWorkers; ++worker)
+		buildTiles(arenas[worker], contexts[worker], worker, numWorkers, results);
+#endif
+
+	for(int worker = 0; worker < numWorkers; ++worker)
+		ctx->merge(*contexts[worker]);
+
+	int status = 0;
+	int dataSize = sizeof(NavMeshSetHeader);
+	int polyCount = 0;
+	int vertCount = 0;
+	int detailTriCount = 0;
+	for(int i = 0; i < numTiles; ++i)
+	{
+		if(results[i].status != 0 && status == 0)
+			status = results[i].status;
+		dataSize += sizeof(NavMeshTileHeader) + results[i].dataSize;
+		polyCount += results[i].polyCount;
+		vertCount += results[i].vertCount;
+		detailTriCount += results[i].detailTriCount;
+	}
+
+	unsigned char* data = NULL;
+	if(status == 0)
+	{
+		data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		if(!data)
+			status = -11;
+	}
+
+	if(status == 0)
+	{
+		NavMeshSetHeader header;
+		header.magic = NAVMESHSET_MAGIC;
+		header.version = NAVMESHSET_VERSION;
+		header.numTiles = numTiles;
+		header.params = navMeshParams;
+
+		unsigned char* out = data;
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		for(int i = 0; i < numTiles; ++i)
+		{
+			NavMeshTileHeader tileHeader;
+			tileHeader.tileX = results[i].tileX;
+			tileHeader.tileY = results[i].tileY;
+			tileHeader.dataSize = results[i].dataSize;
+			memcpy(out, &tileHeader, sizeof(tileHeader));
+			out += sizeof(tileHeader);
+			if(results[i].dataSize > 0)
+			{
+				memcpy(out, results[i].data, results[i].dataSize);
+				out += results[i].dataSize;
+			}
+			dirtyTiles[results[i].tileX + results[i].tileY*tilesWide] = 0;
+		}
+
+		*outData = data;
+		*outDataSize = dataSize;
+		ctx->setOutputStats(numTiles, polyCount, vertCount, detailTriCount, dataSize);
+	}
+
+	for(int i = 0; i < numTiles; ++i)
+		dtFree(results[i].data);
+
+	return status;
+}
+
+void NavmeshBuilder::getArenaStats(int* highWaterMark, int* capacity, int* systemAllocs) const
+{
+	*highWaterMark = 0;
+	*capacity = 0;
+	*systemAllocs = 0;
+	for(size_t i = 0; i < arenas.size(); ++i)
+	{
+		*highWaterMark += arenas[i]->getHighWaterMark();
+		*capacity += arenas[i]->getCapacity();
+		*systemAllocs += arenas[i]->getSystemAllocCount();
+	}
+}
+
+EXPORT NavmeshBuilder* CreateNavmeshBuilder(
+	float minX,
+	float minY,
+	float minZ,
+	float maxX,
+	float maxY,
+	float maxZ,
+	float cellSize,
+	float cellHeight,
+	float walkableHeight,
+	float walkableSlopeAngle,
+	float walkableClimb,
+	float walkableRadius,
+	float maxEdgeLen,
+	float maxSimplificationError,
+	bool monotonePartitioning,
+	float minRegionArea,
+	float mergeRegionArea,
+	float detailSampleDist,
+	float detailSampleMaxError,
+	int tileSize,
+	int oneMillion)
+{
+	if(oneMillion != 1000000) return NULL;
+
+	rcConfig cfg;
+	memset(&cfg, 0, sizeof(cfg));
+
+	// Rasterization
+	cfg.cs = cellSize;
+	cfg.ch = cellHeight;
+
+	// Agent
+	cfg.walkableHeight = (int)ceilf(walkableHeight / cellHeight);
+	cfg.walkableRadius = (int)ceilf(walkableRadius / cellSize);
+	cfg.walkableClimb = (int)floorf(walkableClimb / cellHeight);
+	cfg.walkableSlopeAngle = walkableSlopeAngle;
+
+	// Region
+	cfg.minRegionArea = (int)floorf(minRegionArea / (cellSize*cellSize));
+	cfg.mergeRegionArea = (int)floorf(mergeRegionArea / (cellSize*cellSize));
+
+	// Polygonization
+	cfg.maxEdgeLen = (int)(maxEdgeLen / cellSize);
+	cfg.maxSimplificationError = maxSimplificationError;
+	cfg.maxVertsPerPoly = DT_VERTS_PER_POLYGON;
+
+	// Detail Mesh
+	cfg.detailSampleDist = detailSampleDist < 0.9f ? 0 : cellSize * detailSampleDist;
+	cfg.detailSampleMaxError = cellHeight * detailSampleMaxError;
+
+	// Tiling
+	cfg.tileSize = tileSize;
+
+	cfg.bmin[0] = minX;
+	cfg.bmin[1] = minY;
+	cfg.bmin[2] = minZ;
+	cfg.bmax[0] = maxX;
+	cfg.bmax[1] = maxY;
+	cfg.bmax[2] = maxZ;
+
+	NavmeshBuilder* builder = new NavmeshBuilder;
+	if(!builder->init(cfg, monotonePartitioning, walkableHeight, walkableRadius, walkableClimb))
+	{
+		delete builder;
+		return NULL;
+	}
+	return builder;
+}
+
+EXPORT void DestroyNavmeshBuilder(NavmeshBuilder* builder)
+{
+	delete builder;
+}
+
+EXPORT void NavmeshBuilderSetMesh(
+	NavmeshBuilder* builder,
+	int meshId,
+	int numVertices,
+	float* vertices,
+	int numIndices,
+	int* indices)
+{
+	builder->setMesh(meshId, numVertices, vertices, numIndices, indices);
+}
+
+EXPORT void NavmeshBuilderRemoveMesh(NavmeshBuilder* builder, int meshId)
+{
+	builder->removeMesh(meshId);
+}
+
+// Rebuilds every tile touched since the last build. The first build covers
+// all tiles. The resulting NavMeshSet blob is retrieved with
+// RetrieveNavmeshData and passed to SteeringManager::initNavMeshSet or
+// SteeringManager::updateNavMeshTiles.
+EXPORT int NavmeshBuilderBuild(NavmeshBuilder* builder)
+{
+	if(g_navData)
+	{
+		dtFree(g_navData);
+		g_navData = NULL;
+		g_navDataSize = 0;
+	}
+
+	BuildContextScope contextScope(&g_buildContext);
+	int result = builder->build(&g_buildContext, &g_navData, &g_navDataSize);
+	if(result != 0)
+		return result;
+	return g_navDataSize;
+}
+
+EXPORT void NavmeshBuilderGetArenaStats(
+	NavmeshBuilder* builder, 
+	int* highWaterMark, 
+	int* capacity, 
+	int* systemAllocs)
+{
+	builder->getArenaStats(highWaterMark, capacity, systemAllocs);
+}
@@ -0,0 +1,129 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CROWDLOD_H
+#define CROWDLOD_H
+
+#include <vector>
+
+#include <DetourCrowd.h>
+
+enum CrowdLodTier
+{
+	CROWDLOD_FULL,				// Full steering and avoidance every update
+	CROWDLOD_REDUCED,			// Collision resolution only, every reducedInterval updates
+	CROWDLOD_KINEMATIC,			// Corridor following only, every kinematicInterval updates
+	CROWDLOD_TIER_COUNT
+};
+
+struct CrowdLodSettings
+{
+	float fullRadius;			// Agents this close to an observer are CROWDLOD_FULL
+	float reducedRadius;		// Agents this close to an observer are CROWDLOD_REDUCED
+	int reducedInterval;		// Updates between steps of a CROWDLOD_REDUCED agent
+	int kinematicInterval;		// Updates between steps of a CROWDLOD_KINEMATIC agent
+	int budgetUsec;				// Crowd update time to hold, 0 for no budget
+};
+
+struct CrowdLodStats
+{
+	int tierAgents[CROWDLOD_TIER_COUNT];	// Active agents per tier at the last update
+	int lastUpdateUsec;			// Time of the last crowd update
+	float radiusScale;			// Applied to both radii to stay within the budget
+};
+
+// Steps agents far from the observers less often and with fewer
+// features. Before each crowd update every agent is put in a tier by its
+// distance to the nearest observer, which sets its update flags and
+// dtCrowdAgentParams::updateInterval. After the update the radii are
+// scaled down while the update takes longer than the budget and grown
+// back while it is well under it.
+//
+// Agents that are not stepped every update stand still in between, so
+// their display position is interpolated from their previous step
+// towards their last one, one interval behind the simulation.
+class CrowdLod
+{
+public:
+	CrowdLod();
+
+	void init(int maxAgents);
+	void setEnabled(dtCrowd* crowd, bool enabled);
+	bool isEnabled() const { return enabled; }
+
+	void setSettings(const CrowdLodSettings& settings);
+	// Lets the budget scale the radii. While disabled the radii stay at
+	// their settings, so the tiers do not depend on timings.
+	void setBudgetEnabled(bool enabled);
+	const CrowdLodSettings& getSettings() const { return settings; }
+	void setObservers(const float* positions, int count);
+
+	// The update flags an agent uses at CROWDLOD_FULL. The other tiers
+	// use a subset of them.
+	void setAgentFlags(int agent, unsigned char flags);
+	unsigned char getAgentFlags(int agent) const { return agents[agent].flags; }
+	// Sets the update flags and interval of the agent's current tier.
+	void applyTier(int agent, dtCrowdAgentParams* params) const;
+	CrowdLodTier getAgentTier(int agent) const { return (CrowdLodTier)agents[agent].tier; }
+
+	// Restarts the interpolation of an agent from where it stands now
+	void resetAgent(const dtCrowd* crowd, int agent);
+	void resetAgents(const dtCrowd* crowd);
+
+	void assignTiers(dtCrowd* crowd);
+	void finishUpdate(const dtCrowd* crowd, int updateUsec);
+
+	void getAgentPosition(const dtCrowd* crowd, int agent, float* pos) const;
+	void getStats(CrowdLodStats* stats) const;
+
+	// The tiers and flags of the agents and the radius scale, which the
+	// next assignTiers depends on. restoreState returns false and changes
+	// nothing if the state is for a different number of agents.
+	int getStateSize() const;
+	void storeState(unsigned char* data) const;
+	bool restoreState(const unsigned char* data, int size);
+
+private:
+	struct Agent
+	{
+		unsigned char flags;
+		unsigned char tier;
+		unsigned char interval;	// Of the step that moved the agent to 'to'
+		unsigned char elapsed;	// Updates since that step
+		float from[3];
+		float to[3];
+	};
+
+	bool enabled;
+	bool budgetEnabled;
+	CrowdLodSettings settings;
+	float radiusScale;
+	int lastUpdateUsec;
+	int tierAgents[CROWDLOD_TIER_COUNT];
+
+	std::vector<Agent> agents;
+	std::vector<float> observers;
+
+	void getInterpolatedPosition(const Agent& agent, float* pos) const;
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CROWDTRACE_H
+#define CROWDTRACE_H
+
+#include <vector>
+
+#include <DetourCrowd.h>
+
+#include "PerfTimer.h"
+
+struct CrowdUpdateTimings
+{
+	int phaseUsec[DT_CROWD_MAX_PHASES];	// Indexed by dtCrowdUpdatePhase
+	int totalUsec;
+	int slices;					// Agent slices the expensive phases were split into
+	dtCrowdUpdateCounters counters;
+};
+
+// Records the timings of the last crowd updates and writes them out in
+// the Chrome trace event format, for chrome://tracing or Perfetto. Each
+// update becomes a slice with its phases nested inside, and the
+// counters are written as counter tracks.
+class CrowdTrace
+{
+public:
+	CrowdTrace();
+
+	// Keeps the last maxFrames updates. 0 stops recording.
+	void start(int maxFrames);
+	void stop();
+	bool isRecording() const { return !frames.empty(); }
+
+	void addFrame(TimeVal start, const CrowdUpdateTimings& timings);
+
+	// Returns false if the file could not be written.
+	bool write(const char* path) const;
+
+private:
+	struct Frame
+	{
+		TimeVal start;
+		CrowdUpdateTimings timings;
+	};
+
+	std::vector<Frame> frames;
+	int head;				// Next frame to write over
+	int count;
+	TimeVal traceStart;
+};
+
+#endif
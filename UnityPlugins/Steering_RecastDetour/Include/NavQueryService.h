@@ -0,0 +1,138 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAVQUERYSERVICE_H
+#define NAVQUERYSERVICE_H
+
+#include <DetourNavMesh.h>
+#include <DetourNavMeshQuery.h>
+#include <map>
+#include <vector>
+#ifdef _MSC_VER
+#include <ppl.h>
+#include <concrt.h>
+#endif
+
+enum NavQueryType
+{
+	NAVQUERY_NEAREST,	// Snaps start to the navmesh
+	NAVQUERY_RAYCAST,	// Walks a ray along the navmesh from start toward end
+	NAVQUERY_PATH,		// Finds the straight path from start to end
+	NAVQUERY_PATH_BIDIRECTIONAL,	// NAVQUERY_PATH, searching from both ends
+};
+
+struct NavQueryRequest
+{
+	int type;
+	int filter;		// Index into the service's query filters
+	float start[3];
+	float end[3];
+};
+
+struct NavQueryResult
+{
+	unsigned int status;	// dtStatus of the query
+	float position[3];		// Nearest point, ray end or last path corner
+	float t;				// Ray hit parameter, FLT_MAX if the ray reached end
+	unsigned int poly;		// Polygon of position
+	int cornerCount;		// Path corners, read with getBatchPath
+};
+
+// Most path corners kept per path request
+static const int NAVQUERY_MAX_CORNERS = 32;
+
+// Runs navmesh queries from many threads against one shared navmesh.
+// Each query needs its own dtNavMeshQuery for the node pools and open
+// list, so threads borrow one from a pool. The navmesh itself is only
+// read; whoever changes it (tile cache rebuilds, tile swaps) has to do
+// so between beginNavMeshUpdate and endNavMeshUpdate, which waits for
+// running queries and holds off new ones.
+//
+// Batches copy their requests, run on the worker threads and are
+// polled or waited on by handle. Without ConcRT batches run inside
+// submitBatch. Requests pick one of a table of query filters that the
+// service only reads, so change the filters between batches. A pooled
+// query gets the second node pool of the bidirectional search the first
+// time it runs one.
+class NavQueryService
+{
+public:
+	NavQueryService();
+	~NavQueryService();
+
+	bool init(const dtNavMesh* navMesh, int maxNodes, const dtQueryFilter* filters, int filterCount);
+
+	// Borrows a query for the calling thread and blocks navmesh updates
+	// until it is released. Release it from the same thread.
+	dtNavMeshQuery* acquireQuery();
+	void releaseQuery(dtNavMeshQuery* query);
+
+	// Returns a batch handle, or 0 on failure.
+	int submitBatch(const NavQueryRequest* requests, int count);
+	bool isBatchComplete(int batch);
+	void waitBatch(int batch);
+	// Both wait for the batch to complete. Returns the number of results
+	// or corners copied.
+	int getBatchResults(int batch, NavQueryResult* results, int maxResults);
+	int getBatchPath(int batch, int request, float* corners, int maxCorners);
+	void releaseBatch(int batch);
+
+	void beginNavMeshUpdate();
+	void endNavMeshUpdate();
+
+private:
+	struct Batch
+	{
+		std::vector<NavQueryRequest> requests;
+		std::vector<NavQueryResult> results;
+		std::vector<int> cornerOffsets;
+		std::vector<float> corners;
+		volatile long complete;
+#ifdef _MSC_VER
+		Concurrency::task_group tasks;
+#endif
+	};
+
+	const dtNavMesh* navMesh;
+	int maxNodes;
+	const dtQueryFilter* filters;
+	int filterCount;
+	float extents[3];
+
+	std::vector<dtNavMeshQuery*> queries;
+	std::vector<dtNavMeshQuery*> freeQueries;
+	std::map<int, Batch*> batches;
+	int nextBatch;
+
+#ifdef _MSC_VER
+	Concurrency::critical_section poolLock;
+	Concurrency::critical_section batchLock;
+	Concurrency::reader_writer_lock navMeshLock;
+#endif
+
+	Batch* findBatch(int batch);
+	void runBatch(Batch* batch, int first, int count);
+	void runQuery(dtNavMeshQuery* query, const NavQueryRequest& request, NavQueryResult& result, float* corners);
+	void clear();
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATHLATENCY_H
+#define PATHLATENCY_H
+
+#include <vector>
+
+#include <DetourCrowd.h>
+
+#include "PerfTimer.h"
+
+struct PathLatencyStats
+{
+	int samples;				// Requests the percentiles are taken over
+	int pending;				// Requests still waiting for a path
+	int p50Usec;
+	int p90Usec;
+	int p99Usec;
+	int maxUsec;
+};
+
+// Measures the time from a move request until the crowd has resolved it,
+// which includes the updates spent waiting in the path queue. The last
+// MAX_SAMPLES requests are kept for the percentiles.
+class PathLatency
+{
+public:
+	PathLatency();
+
+	void init(int maxAgents);
+	void reset();
+
+	// Called after the crowd accepted a move request. A new request
+	// restarts the measurement of an agent that is still waiting.
+	void requested(int agent);
+	void update(const dtCrowd* crowd);
+
+	void getStats(PathLatencyStats* stats) const;
+
+private:
+	static const int MAX_SAMPLES = 1024;
+
+	std::vector<TimeVal> requestTimes;	// 0 when the agent has no request pending
+	std::vector<int> pending;
+	std::vector<int> stillPending;		// Scratch for the crowd's unresolved requests
+	std::vector<unsigned char> waiting;
+	std::vector<int> samples;
+	int head;
+	int count;
+};
+
+#endif
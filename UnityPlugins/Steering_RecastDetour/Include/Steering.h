@@ -26,12 +26,39 @@
 #include <DetourNavMesh.h>
 #include <DetourCrowd.h>
 #include <DetourNavMeshQuery.h>
+#include <DetourTileCache.h>
+#include <DetourTileCacheBuilder.h>
+
+#include "TileCacheSet.h"
+#include "NavMeshSet.h"
+#include "NavQueryService.h"
+#include "TileStreamer.h"
+#include "CrowdLod.h"
+#include "CrowdTrace.h"
+#include "PathLatency.h"
 
 struct Vector3
 {
 	float x, y, z;
 };
 
+// A navmesh raycast from an agent, or from a point on a known polygon
+struct NavRaycast
+{
+	int agent;					// Agent to cast from, or -1 to use startPoly and start
+	unsigned int startPoly;
+	Vector3 start;
+	Vector3 end;
+};
+
+struct NavRaycastHit
+{
+	float t;					// Hit parameter along start-end, FLT_MAX if the ray reached end
+	Vector3 normal;				// Normal of the wall that was hit
+	unsigned int lastPoly;		// Last polygon the ray crossed, 0 if the ray failed
+};
+
+
 enum NavigationQuality 
 {
 	NAVIGATIONQUALITY_LOW,
@@ -49,7 +76,18 @@ enum Pushiness
 class SteeringManager
 {
 public:
+	SteeringManager();
+	~SteeringManager();
+
 	bool init(unsigned char* navMeshData, int navMeshDataSize, int maxAgents, float maxAgentRadius);
+	bool initTileCache(unsigned char* tileCacheData, int tileCacheDataSize, int maxAgents, float maxAgentRadius);
+	bool initNavMeshSet(unsigned char* navMeshSetData, int navMeshSetDataSize, int maxAgents, float maxAgentRadius);
+	// Streams the tiles of a NavMeshSet file instead of loading them all.
+	// Only the tiles within streamingRadius of an agent or its target are
+	// kept, up to maxResidentTiles. Use requestTiles and isTileResident to
+	// load the area around a spawn point or target before using it.
+	bool initStreaming(const char* navMeshSetPath, int maxAgents, float maxAgentRadius, 
+		float streamingRadius, int maxResidentTiles);
 	void update(float dT);
 
 	int addAgent(Vector3 pos, float radius, float height, float accel, float maxSpeed);
@@ -60,7 +98,18 @@ public:
 	void updateAgentMaxSpeed(int agent, float maxSpeed);
 	void updateAgentMaxAcceleration(int agent, float accel);
 
-	void setAgentTarget(int agent, Vector3 target);
+	// Agents share a table of DT_CROWD_MAX_QUERY_FILTER_TYPE query
+	// filters and each uses one of them for its paths and moves. All
+	// filters start out passing every polygon at unit cost. Queries
+	// that are not made for an agent use filter 0, except query service
+	// batches, whose requests name their filter.
+	bool setAgentQueryFilter(int agent, int filter);
+	bool setQueryFilterAreaCost(int filter, int area, float cost);
+	bool setQueryFilterFlags(int filter, unsigned short includeFlags, unsigned short excludeFlags);
+
+	// Returns false if the target is off the navmesh or cannot be
+	// reached from the agent's position.
+	bool setAgentTarget(int agent, Vector3 target);
 	void setAgentMobile(int agent, bool mobile);
 
 	Vector3 getAgentPosition(int agent);
@@ -69,14 +118,143 @@ public:
 
 	Vector3 getClosestWalkablePosition(Vector3 pos);
 
+	// Snaps many points at once. Points are visited in Morton order so
+	// neighbouring queries walk the same BV-tree nodes, and the work is
+	// split across worker threads. A point with no polygon nearby is
+	// returned unchanged with a zero poly ref. polys may be NULL.
+	// Returns the number of points that found a polygon.
+	int getClosestWalkablePositions(const Vector3* positions, int count, Vector3* results, unsigned int* polys);
+
+	// Constant time check against the navmesh's connected components.
+	// False means no path exists. True means the points are on the same
+	// island, though area flags may still block the path.
+	bool isReachable(Vector3 from, Vector3 to);
+	bool isPolyReachable(unsigned int fromPoly, unsigned int toPoly);
+
+	// Walks many rays along the navmesh surface at once, split across
+	// worker threads, using the casting agent's query filter. Cheap line of
+	// sight between agents. Returns the number of rays that were cast;
+	// a ray with a bad agent or start polygon gets lastPoly 0.
+	int raycastBatch(const NavRaycast* rays, int count, NavRaycastHit* hits);
+
+	// Obstacles are only available after initTileCache. Changes are
+	// applied to the navmesh over the following updates, rebuilding at
+	// most maxTileRebuildsPerUpdate tiles each frame. moveObstacle returns
+	// the new ref, or 0 if the obstacle could not be removed, which leaves
+	// it in place, or its replacement could not be added.
+	unsigned int addObstacle(Vector3 pos, float radius, float height);
+	unsigned int moveObstacle(unsigned int obstacle, Vector3 pos);
+	void removeObstacle(unsigned int obstacle);
+	void setMaxTileRebuildsPerUpdate(int maxRebuilds);
+
+	// Swaps rebuilt tiles from a NavmeshBuilderBuild blob into the live
+	// navmesh. Only available after initNavMeshSet.
+	bool updateNavMeshTiles(unsigned char* navMeshSetData, int navMeshSetDataSize);
+
+	// Only available after initStreaming. Requested tiles are loaded over
+	// the following updates.
+	void requestTiles(Vector3 pos);
+	bool isTileResident(Vector3 pos);
+	void getStreamingStats(TileStreamingStats* stats);
+
+	// Rollback support. A snapshot holds the flags and areas of every
+	// navmesh tile and the full state of the crowd agents. saveSnapshot
+	// returns the bytes written, the size needed when buffer is NULL, or
+	// -1 if the buffer is too small. A restore needs the same tiles to be
+	// loaded; it returns false if the crowd could not be restored or a
+	// tile has changed since, which keeps its current state.
+	int saveSnapshot(unsigned char* buffer, int maxSize);
+	bool restoreSnapshot(const unsigned char* buffer, int size);
+
+	// Caps the cost of the crowd update. While the update takes longer
+	// than budgetUsec the agents are split into more slices, up to
+	// maxSlices, and only one slice refreshes its boundaries, neighbours
+	// and avoidance each update. 0 turns slicing off.
+	void setCrowdUpdateBudget(int budgetUsec, int maxSlices);
+	// Phase times and work counters of the last update, including the
+	// node pool probes of its path searches
+	void getCrowdUpdateTimings(CrowdUpdateTimings* timings);
+
+	// Records the timings of the last maxFrames updates, which
+	// writeCrowdTrace saves as a Chrome trace JSON file.
+	void startCrowdTrace(int maxFrames);
+	void stopCrowdTrace();
+	bool writeCrowdTrace(const char* path);
+
+	// Wall clock time from setAgentTarget until the crowd has resolved
+	// the request, over the recent requests.
+	void getPathLatencyStats(PathLatencyStats* stats);
+	void resetPathLatencyStats();
+
+	// Simulation level of detail. While enabled, agents far from every
+	// observer are stepped less often and with fewer update flags, and
+	// getAgentPosition interpolates between their steps. The flags set by
+	// updateAgentNavigationQuality are the ones used close to an observer.
+	// With a budget the tier radii shrink until the crowd update fits.
+	void setLodEnabled(bool enabled);
+	void setLodSettings(const CrowdLodSettings& settings);
+	void setLodObservers(const Vector3* positions, int count);
+	CrowdLodTier getAgentLodTier(int agent);
+	void getLodStats(CrowdLodStats* stats);
+
+	// Deterministic mode for lockstep crowds. With a fixed time step,
+	// update() advances the crowd in whole steps of stepSeconds and
+	// carries the rest of dT over to the next call, running at most
+	// maxSteps steps per call. Paths arrive in the step after they are
+	// requested unless that step's searches outrun a fixed iteration
+	// budget, and the slicing and LOD radii stop adapting to timings:
+	// with a budget the crowd stays at its maximum slices. Streamed tiles
+	// are read inside the step that requests them. Peers running the
+	// same build that apply the same inputs before the same step, with
+	// the same LOD observers, then reach the same state, which
+	// getStateChecksum compares. 0 goes back to variable steps.
+	void setFixedTimeStep(float stepSeconds, int maxSteps);
+	// Steps taken since init, the tick that inputs are scheduled against
+	unsigned int getStepCount() { return stepCount; }
+	// Hash of the step count and the state of every active agent
+	unsigned int getStateChecksum();
+
+	// Thread-safe queries against the navmesh, for job threads and
+	// asynchronous batches.
+	NavQueryService* getQueryService() { return &queryService; }
+
 private:
 	dtNavMesh navMesh;
 	dtNavMeshQuery query;
+	NavQueryService queryService;
 	dtCrowd crowd;
 
+	dtTileCache* tileCache;
+	dtTileCacheAlloc tileCacheAlloc;
+	dtTileCacheCompressor* tileCacheCompressor;
+	bool tileCacheDirty;
+	int maxTileRebuildsPerUpdate;
+
+	TileStreamer tileStreamer;
+	CrowdLod lod;
+
+	int crowdBudgetUsec;
+	int crowdMaxSlices;
+	CrowdUpdateTimings crowdTimings;
+	CrowdTrace crowdTrace;
+	PathLatency pathLatency;
+
+	float fixedTimeStep;
+	int maxFixedSteps;
+	float stepAccumulator;
+	unsigned int stepCount;
+
 	bool initNavMesh(unsigned char* navmeshData, int navmeshDataSize);
+	bool initTileCacheNavMesh(unsigned char* tileCacheData, int tileCacheDataSize);
+	bool readNavMeshSet(unsigned char* navMeshSetData, int navMeshSetDataSize, bool init);
 	bool initQuery();
 	bool initCrowd(int maxAgents, float maxAgentRadius);
+
+	void step(float dT);
+	void updateCrowdSlices();
+	void updateTileCache(float dT);
+	void updateStreaming();
+	void updateCrowdTimings(TimeVal startTime, int updateUsec);
 };
 
 #endif
\ No newline at end of file
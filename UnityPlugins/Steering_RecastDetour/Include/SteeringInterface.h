@@ -40,6 +40,25 @@ EXPORT bool init(SteeringManager* manager,unsigned char* navMeshData,
 	return manager->init(navMeshData, navMeshDataSize, maxAgents, maxAgentRadius);
 }
 
+EXPORT bool initTileCache(SteeringManager* manager, unsigned char* tileCacheData, 
+	int tileCacheDataSize, int maxAgents, float maxAgentRadius)
+{
+	return manager->initTileCache(tileCacheData, tileCacheDataSize, maxAgents, maxAgentRadius);
+}
+
+EXPORT bool initNavMeshSet(SteeringManager* manager, unsigned char* navMeshSetData, 
+	int navMeshSetDataSize, int maxAgents, float maxAgentRadius)
+{
+	return manager->initNavMeshSet(navMeshSetData, navMeshSetDataSize, maxAgents, maxAgentRadius);
+}
+
+EXPORT bool initStreaming(SteeringManager* manager, const char* navMeshSetPath, 
+	int maxAgents, float maxAgentRadius, float streamingRadius, int maxResidentTiles)
+{
+	return manager->initStreaming(navMeshSetPath, maxAgents, maxAgentRadius, 
+		streamingRadius, maxResidentTiles);
+}
+
 EXPORT void update(SteeringManager* manager, float dT)
 {
 	manager->update(dT);
@@ -80,10 +99,28 @@ EXPORT void updateAgentMaxAcceleration(
 	manager->updateAgentMaxAcceleration(agent, accel);
 }
 
-EXPORT void setAgentTarget(
+EXPORT bool setAgentQueryFilter(
+	SteeringManager* manager, int agent, int filter)
+{
+	return manager->setAgentQueryFilter(agent, filter);
+}
+
+EXPORT bool setQueryFilterAreaCost(
+	SteeringManager* manager, int filter, int area, float cost)
+{
+	return manager->setQueryFilterAreaCost(filter, area, cost);
+}
+
+EXPORT bool setQueryFilterFlags(
+	SteeringManager* manager, int filter, unsigned short includeFlags, unsigned short excludeFlags)
+{
+	return manager->setQueryFilterFlags(filter, includeFlags, excludeFlags);
+}
+
+EXPORT bool setAgentTarget(
 	SteeringManager* manager, int agent, Vector3 pos)
 {
-	manager->setAgentTarget(agent, pos);
+	return manager->setAgentTarget(agent, pos);
 }
 
 EXPORT void setAgentMobile(
@@ -114,4 +151,216 @@ EXPORT Vector3 getClosestWalkablePosition(
 	SteeringManager* manager, Vector3 pos)
 {
 	return manager->getClosestWalkablePosition(pos);
+}
+
+EXPORT int getClosestWalkablePositions(
+	SteeringManager* manager, const Vector3* positions, int count, 
+	Vector3* results, unsigned int* polys)
+{
+	return manager->getClosestWalkablePositions(positions, count, results, polys);
+}
+
+EXPORT bool isReachable(
+	SteeringManager* manager, Vector3 from, Vector3 to)
+{
+	return manager->isReachable(from, to);
+}
+
+EXPORT bool isPolyReachable(
+	SteeringManager* manager, unsigned int fromPoly, unsigned int toPoly)
+{
+	return manager->isPolyReachable(fromPoly, toPoly);
+}
+
+EXPORT int raycastBatch(
+	SteeringManager* manager, const NavRaycast* rays, int count, NavRaycastHit* hits)
+{
+	return manager->raycastBatch(rays, count, hits);
+}
+
+EXPORT unsigned int addObstacle(
+	SteeringManager* manager, Vector3 pos, float radius, float height)
+{
+	return manager->addObstacle(pos, radius, height);
+}
+
+EXPORT unsigned int moveObstacle(
+	SteeringManager* manager, unsigned int obstacle, Vector3 pos)
+{
+	return manager->moveObstacle(obstacle, pos);
+}
+
+EXPORT void removeObstacle(
+	SteeringManager* manager, unsigned int obstacle)
+{
+	manager->removeObstacle(obstacle);
+}
+
+EXPORT void setMaxTileRebuildsPerUpdate(
+	SteeringManager* manager, int maxRebuilds)
+{
+	manager->setMaxTileRebuildsPerUpdate(maxRebuilds);
+}
+
+EXPORT bool updateNavMeshTiles(
+	SteeringManager* manager, unsigned char* navMeshSetData, int navMeshSetDataSize)
+{
+	return manager->updateNavMeshTiles(navMeshSetData, navMeshSetDataSize);
+}
+
+EXPORT void requestTiles(
+	SteeringManager* manager, Vector3 pos)
+{
+	manager->requestTiles(pos);
+}
+
+EXPORT bool isTileResident(
+	SteeringManager* manager, Vector3 pos)
+{
+	return manager->isTileResident(pos);
+}
+
+EXPORT void getStreamingStats(
+	SteeringManager* manager, TileStreamingStats* stats)
+{
+	manager->getStreamingStats(stats);
+}
+
+EXPORT int saveSnapshot(
+	SteeringManager* manager, unsigned char* buffer, int maxSize)
+{
+	return manager->saveSnapshot(buffer, maxSize);
+}
+
+EXPORT bool restoreSnapshot(
+	SteeringManager* manager, const unsigned char* buffer, int size)
+{
+	return manager->restoreSnapshot(buffer, size);
+}
+
+EXPORT void setCrowdUpdateBudget(
+	SteeringManager* manager, int budgetUsec, int maxSlices)
+{
+	manager->setCrowdUpdateBudget(budgetUsec, maxSlices);
+}
+
+EXPORT void getCrowdUpdateTimings(
+	SteeringManager* manager, CrowdUpdateTimings* timings)
+{
+	manager->getCrowdUpdateTimings(timings);
+}
+
+EXPORT void startCrowdTrace(
+	SteeringManager* manager, int maxFrames)
+{
+	manager->startCrowdTrace(maxFrames);
+}
+
+EXPORT void stopCrowdTrace(
+	SteeringManager* manager)
+{
+	manager->stopCrowdTrace();
+}
+
+EXPORT bool writeCrowdTrace(
+	SteeringManager* manager, const char* path)
+{
+	return manager->writeCrowdTrace(path);
+}
+
+EXPORT void getPathLatencyStats(
+	SteeringManager* manager, PathLatencyStats* stats)
+{
+	manager->getPathLatencyStats(stats);
+}
+
+EXPORT void resetPathLatencyStats(
+	SteeringManager* manager)
+{
+	manager->resetPathLatencyStats();
+}
+
+EXPORT void setFixedTimeStep(
+	SteeringManager* manager, float stepSeconds, int maxSteps)
+{
+	manager->setFixedTimeStep(stepSeconds, maxSteps);
+}
+
+EXPORT unsigned int getStepCount(
+	SteeringManager* manager)
+{
+	return manager->getStepCount();
+}
+
+EXPORT unsigned int getStateChecksum(
+	SteeringManager* manager)
+{
+	return manager->getStateChecksum();
+}
+
+EXPORT void setLodEnabled(
+	SteeringManager* manager, bool enabled)
+{
+	manager->setLodEnabled(enabled);
+}
+
+EXPORT void setLodSettings(
+	SteeringManager* manager, float fullRadius, float reducedRadius, 
+	int reducedInterval, int kinematicInterval, int budgetUsec)
+{
+	CrowdLodSettings settings;
+	settings.fullRadius = fullRadius;
+	settings.reducedRadius = reducedRadius;
+	settings.reducedInterval = reducedInterval;
+	settings.kinematicInterval = kinematicInterval;
+	settings.budgetUsec = budgetUsec;
+	manager->setLodSettings(settings);
+}
+
+EXPORT void setLodObservers(
+	SteeringManager* manager, const Vector3* positions, int count)
+{
+	manager->setLodObservers(positions, count);
+}
+
+EXPORT int getAgentLodTier(
+	SteeringManager* manager, int agent)
+{
+	return manager->getAgentLodTier(agent);
+}
+
+EXPORT void getLodStats(
+	SteeringManager* manager, CrowdLodStats* stats)
+{
+	manager->getLodStats(stats);
+}
+
+EXPORT int submitQueryBatch(
+	SteeringManager* manager, const NavQueryRequest* requests, int count)
+{
+	return manager->getQueryService()->submitBatch(requests, count);
+}
+
+EXPORT bool isQueryBatchComplete(
+	SteeringManager* manager, int batch)
+{
+	return manager->getQueryService()->isBatchComplete(batch);
+}
+
+EXPORT int getQueryBatchResults(
+	SteeringManager* manager, int batch, NavQueryResult* results, int maxResults)
+{
+	return manager->getQueryService()->getBatchResults(batch, results, maxResults);
+}
+
+EXPORT int getQueryBatchPath(
+	SteeringManager* manager, int batch, int request, Vector3* corners, int maxCorners)
+{
+	return manager->getQueryService()->getBatchPath(batch, request, (float*)corners, maxCorners);
+}
+
+EXPORT void releaseQueryBatch(
+	SteeringManager* manager, int batch)
+{
+	manager->getQueryService()->releaseBatch(batch);
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILESTREAMER_H
+#define TILESTREAMER_H
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+#ifdef _MSC_VER
+#include <ppl.h>
+#endif
+
+#include <DetourNavMesh.h>
+
+#include "NavQueryService.h"
+#include "PerfTimer.h"
+
+struct TileStreamingStats
+{
+	int storedTiles;		// Tiles in the store
+	int residentTiles;		// Tiles in the navmesh
+	int residentBytes;		// Tile data held by the navmesh
+	int pendingLoads;		// Reads still running
+	int loads;				// Tiles added to the navmesh
+	int evictions;			// Tiles removed to stay under the budget
+	int failedLoads;		// Reads or addTile calls that failed
+	float lastLoadMs;		// Time from request to residency of the last tile
+	float averageLoadMs;
+	float maxLoadMs;
+};
+
+// Keeps only the navmesh tiles near points of interest resident. Tiles
+// are read on demand from a NavMeshSet file, the format written by
+// NavmeshBuilderBuild. Opening the file only reads its tile index.
+//
+// Every update the tiles within the streaming radius of the interest
+// points are requested. Reads run on the worker threads and finished
+// tiles are added to the navmesh at the next update. When more tiles
+// are resident than the budget allows, the least recently requested
+// ones that are not needed right now are removed. Without ConcRT, or
+// when synchronous, reads run inside update and their tiles are added
+// by the same update, in request order.
+class TileStreamer
+{
+public:
+	TileStreamer();
+	~TileStreamer();
+
+	bool open(const char* path);
+	void close();
+	bool isOpen() const { return file != NULL; }
+	const dtNavMeshParams& getNavMeshParams() const { return params; }
+
+	// maxResidentTiles is a soft limit: tiles within the radius of an
+	// interest point are never evicted.
+	void setLimits(float radius, int maxResidentTiles);
+	// Waits for the reads in flight, which are added by the next update
+	void setSynchronous(bool sync);
+
+	// Interest points are collected between updates and cleared by update.
+	void addInterest(const float* pos);
+	bool isResident(const float* pos) const;
+
+	// Adds finished tiles, requests the tiles around the interest points
+	// and evicts down to the budget. Navmesh changes are made between
+	// beginNavMeshUpdate and endNavMeshUpdate of queryService. Returns
+	// the number of tiles added or removed.
+	int update(dtNavMesh* navMesh, NavQueryService* queryService);
+
+	void getStats(TileStreamingStats* stats) const;
+
+private:
+	enum TileState
+	{
+		TILE_ABSENT,
+		TILE_LOADING,
+		TILE_RESIDENT,
+		TILE_FAILED,
+	};
+
+	struct Tile
+	{
+		int tileX;
+		int tileY;
+		long offset;			// Of the tile data in the file
+		int dataSize;
+		int state;
+		unsigned int lastUsed;	// Update that last requested the tile
+	};
+
+	struct Load
+	{
+		int tile;
+		long offset;
+		int dataSize;
+		unsigned char* data;	// NULL if the read failed
+		TimeVal requested;
+	};
+
+	FILE* file;
+	dtNavMeshParams params;
+	float radius;
+	int maxResidentTiles;
+	bool synchronous;
+	unsigned int frame;
+
+	std::vector<Tile> tiles;
+	std::map<int, int> tileLookup;
+	std::vector<float> interest;
+	// Reads hand their loads back through finishedLoads
+	std::vector<Load*> finishedLoads;
+	int pendingLoads;
+
+	int residentTiles;
+	int residentBytes;
+	int loadCount;
+	int evictions;
+	int failedLoads;
+	float lastLoadMs;
+	float totalLoadMs;
+	float maxLoadMs;
+
+#ifdef _MSC_VER
+	Concurrency::critical_section fileLock;
+	Concurrency::critical_section loadLock;
+	Concurrency::task_group readTasks;
+#endif
+
+	int findTile(int tileX, int tileY) const;
+	void requestTiles(const float* pos);
+	void readTile(Load* load);
+	int addLoadedTiles(dtNavMesh* navMesh, const std::vector<Load*>& loaded);
+	int evictTiles(dtNavMesh* navMesh);
+};
+
+#endif
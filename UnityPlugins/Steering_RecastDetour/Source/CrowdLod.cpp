@@ -0,0 +1,272 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+#include <DetourCommon.h>
+
+#include "CrowdLod.h"
+
+// An agent keeps a closer tier until it is this much further out than
+// the tier's radius, so agents on a boundary do not switch every update
+static const float TIER_HYSTERESIS = 1.1f;
+// Smallest radius scale the budget may push the radii down to
+static const float MIN_RADIUS_SCALE = 0.05f;
+
+CrowdLod::CrowdLod()
+	: enabled(false), budgetEnabled(true), radiusScale(1.0f), lastUpdateUsec(0)
+{
+	memset(tierAgents, 0, sizeof(tierAgents));
+	settings.fullRadius = 20.0f;
+	settings.reducedRadius = 50.0f;
+	settings.reducedInterval = 2;
+	settings.kinematicInterval = 4;
+	settings.budgetUsec = 0;
+}
+
+void CrowdLod::init(int maxAgents)
+{
+	Agent agent;
+	memset(&agent, 0, sizeof(agent));
+	agent.flags = 0xff;
+	agent.tier = CROWDLOD_FULL;
+	agent.interval = 1;
+	agents.assign(maxAgents, agent);
+	radiusScale = 1.0f;
+	lastUpdateUsec = 0;
+	memset(tierAgents, 0, sizeof(tierAgents));
+}
+
+void CrowdLod::setEnabled(dtCrowd* crowd, bool enabled)
+{
+	if (this->enabled == enabled)
+		return;
+	this->enabled = enabled;
+	radiusScale = 1.0f;
+	memset(tierAgents, 0, sizeof(tierAgents));
+
+	for (int i = 0; i < (int)agents.size(); ++i)
+	{
+		agents[i].tier = CROWDLOD_FULL;
+		const dtCrowdAgent* ag = crowd->getAgent(i);
+		if (!ag->active)
+			continue;
+		dtCrowdAgentParams params = ag->params;
+		applyTier(i, &params);
+		crowd->updateAgentParameters(i, &params);
+		resetAgent(crowd, i);
+	}
+}
+
+void CrowdLod::setSettings(const CrowdLodSettings& settings)
+{
+	this->settings = settings;
+	this->settings.reducedRadius = std::max(settings.reducedRadius, settings.fullRadius);
+	this->settings.reducedInterval = dtClamp(settings.reducedInterval, 1, 255);
+	this->settings.kinematicInterval = dtClamp(settings.kinematicInterval, 1, 255);
+}
+
+void CrowdLod::setBudgetEnabled(bool enabled)
+{
+	budgetEnabled = enabled;
+	if (!budgetEnabled)
+		radiusScale = 1.0f;
+}
+
+void CrowdLod::setObservers(const float* positions, int count)
+{
+	observers.assign(positions, positions + count*3);
+}
+
+void CrowdLod::setAgentFlags(int agent, unsigned char flags)
+{
+	agents[agent].flags = flags;
+}
+
+void CrowdLod::applyTier(int agent, dtCrowdAgentParams* params) const
+{
+	const Agent& a = agents[agent];
+	if (!enabled || a.tier == CROWDLOD_FULL)
+	{
+		params->updateFlags = a.flags;
+		params->updateInterval = 1;
+	}
+	else if (a.tier == CROWDLOD_REDUCED)
+	{
+		params->updateFlags = a.flags & DT_CROWD_COLLISION_RESOLUTION;
+		params->updateInterval = (unsigned char)settings.reducedInterval;
+	}
+	else
+	{
+		params->updateFlags = 0;
+		params->updateInterval = (unsigned char)settings.kinematicInterval;
+	}
+}
+
+void CrowdLod::resetAgent(const dtCrowd* crowd, int agent)
+{
+	Agent& a = agents[agent];
+	const dtCrowdAgent* ag = crowd->getAgent(agent);
+	dtVcopy(a.from, ag->npos);
+	dtVcopy(a.to, ag->npos);
+	a.interval = 1;
+	a.elapsed = 1;
+}
+
+void CrowdLod::resetAgents(const dtCrowd* crowd)
+{
+	for (int i = 0; i < (int)agents.size(); ++i)
+	{
+		if (crowd->getAgent(i)->active)
+			resetAgent(crowd, i);
+	}
+}
+
+void CrowdLod::assignTiers(dtCrowd* crowd)
+{
+	const float fullRadius = settings.fullRadius * radiusScale;
+	const float reducedRadius = settings.reducedRadius * radiusScale;
+	const int numObservers = (int)observers.size() / 3;
+	memset(tierAgents, 0, sizeof(tierAgents));
+
+	for (int i = 0; i < (int)agents.size(); ++i)
+	{
+		const dtCrowdAgent* ag = crowd->getAgent(i);
+		if (!ag->active)
+			continue;
+		Agent& a = agents[i];
+
+		// Without observers every agent is out of sight
+		float distSqr = FLT_MAX;
+		for (int j = 0; j < numObservers; ++j)
+			distSqr = std::min(distSqr, dtVdistSqr(ag->npos, &observers[j*3]));
+
+		const float fullScale = a.tier == CROWDLOD_FULL ? TIER_HYSTERESIS : 1.0f;
+		const float reducedScale = a.tier != CROWDLOD_KINEMATIC ? TIER_HYSTERESIS : 1.0f;
+		unsigned char tier = CROWDLOD_KINEMATIC;
+		if (distSqr <= dtSqr(fullRadius * fullScale))
+			tier = CROWDLOD_FULL;
+		else if (distSqr <= dtSqr(reducedRadius * reducedScale))
+			tier = CROWDLOD_REDUCED;
+		a.tier = tier;
+		tierAgents[tier]++;
+
+		dtCrowdAgentParams params = ag->params;
+		applyTier(i, &params);
+		if (params.updateFlags != ag->params.updateFlags 
+			|| params.updateInterval != ag->params.updateInterval)
+			crowd->updateAgentParameters(i, &params);
+	}
+}
+
+void CrowdLod::finishUpdate(const dtCrowd* crowd, int updateUsec)
+{
+	lastUpdateUsec = updateUsec;
+	if (budgetEnabled && settings.budgetUsec > 0)
+	{
+		if (updateUsec > settings.budgetUsec)
+			radiusScale = std::max(radiusScale * 0.9f, MIN_RADIUS_SCALE);
+		else if (updateUsec < settings.budgetUsec * 0.8f)
+			radiusScale = std::min(radiusScale * 1.05f, 1.0f);
+	}
+
+	for (int i = 0; i < (int)agents.size(); ++i)
+	{
+		const dtCrowdAgent* ag = crowd->getAgent(i);
+		if (!ag->active)
+			continue;
+		Agent& a = agents[i];
+
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		{
+			// Off-mesh connections move the agent every update
+			resetAgent(crowd, i);
+		}
+		else if (ag->pendingTime == 0)
+		{
+			// Stepped this update
+			getInterpolatedPosition(a, a.from);
+			dtVcopy(a.to, ag->npos);
+			a.interval = std::max(ag->params.updateInterval, (unsigned char)1);
+			a.elapsed = 1;
+		}
+		else if (a.elapsed < a.interval)
+		{
+			a.elapsed++;
+		}
+	}
+}
+
+void CrowdLod::getAgentPosition(const dtCrowd* crowd, int agent, float* pos) const
+{
+	if (enabled)
+		getInterpolatedPosition(agents[agent], pos);
+	else
+		dtVcopy(pos, crowd->getAgent(agent)->npos);
+}
+
+void CrowdLod::getStats(CrowdLodStats* stats) const
+{
+	memcpy(stats->tierAgents, tierAgents, sizeof(tierAgents));
+	stats->lastUpdateUsec = lastUpdateUsec;
+	stats->radiusScale = radiusScale;
+}
+
+void CrowdLod::getInterpolatedPosition(const Agent& agent, float* pos) const
+{
+	if (agent.elapsed >= agent.interval)
+		dtVcopy(pos, agent.to);
+	else
+		dtVlerp(pos, agent.from, agent.to, (float)agent.elapsed / agent.interval);
+}
+
+int CrowdLod::getStateSize() const
+{
+	return sizeof(float) + (int)agents.size()*2;
+}
+
+void CrowdLod::storeState(unsigned char* data) const
+{
+	memcpy(data, &radiusScale, sizeof(float));
+	data += sizeof(float);
+	for (int i = 0; i < (int)agents.size(); ++i)
+	{
+		*data++ = agents[i].flags;
+		*data++ = agents[i].tier;
+	}
+}
+
+bool CrowdLod::restoreState(const unsigned char* data, int size)
+{
+	if (size != getStateSize())
+		return false;
+	memcpy(&radiusScale, data, sizeof(float));
+	data += sizeof(float);
+	for (int i = 0; i < (int)agents.size(); ++i)
+	{
+		agents[i].flags = *data++;
+		agents[i].tier = *data++;
+	}
+	return true;
+}
@@ -0,0 +1,115 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+
+#include "CrowdTrace.h"
+
+static const char* PHASE_NAMES[DT_CROWD_MAX_PHASES] =
+{
+	"PathValidity",
+	"MoveRequests",
+	"Topology",
+	"Proximity",
+	"Steering",
+	"Avoidance",
+	"Collision",
+	"Move",
+};
+
+CrowdTrace::CrowdTrace()
+	: head(0), count(0), traceStart(0)
+{
+}
+
+void CrowdTrace::start(int maxFrames)
+{
+	frames.clear();
+	if (maxFrames > 0)
+		frames.resize(maxFrames);
+	head = 0;
+	count = 0;
+	traceStart = getPerfTime();
+}
+
+void CrowdTrace::stop()
+{
+	start(0);
+}
+
+void CrowdTrace::addFrame(TimeVal start, const CrowdUpdateTimings& timings)
+{
+	if (frames.empty())
+		return;
+	frames[head].start = start;
+	frames[head].timings = timings;
+	head = (head + 1) % (int)frames.size();
+	if (count < (int)frames.size())
+		count++;
+}
+
+bool CrowdTrace::write(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Crowd\"}}");
+
+	const int first = count < (int)frames.size() ? 0 : head;
+	for (int i = 0; i < count; ++i)
+	{
+		const Frame& frame = frames[(first + i) % frames.size()];
+		const CrowdUpdateTimings& t = frame.timings;
+		const dtCrowdUpdateCounters& c = t.counters;
+		int ts = getPerfTimeUsec(frame.start - traceStart);
+
+		fprintf(file, ",\n{\"name\":\"CrowdUpdate\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%d,\"dur\":%d,"
+			"\"args\":{\"slices\":%d}}", ts, t.totalUsec, t.slices);
+
+		// The phases follow each other without gaps
+		for (int p = 0; p < DT_CROWD_MAX_PHASES; ++p)
+		{
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%d,\"dur\":%d}", 
+				PHASE_NAMES[p], ts, t.phaseUsec[p]);
+			ts += t.phaseUsec[p];
+		}
+
+		ts = getPerfTimeUsec(frame.start - traceStart);
+		fprintf(file, ",\n{\"name\":\"Agents\",\"ph\":\"C\",\"pid\":1,\"ts\":%d,"
+			"\"args\":{\"active\":%d,\"stepped\":%d}}", ts, c.activeAgents, c.steppedAgents);
+		fprintf(file, ",\n{\"name\":\"Paths\",\"ph\":\"C\",\"pid\":1,\"ts\":%d,"
+			"\"args\":{\"replans\":%d,\"iterations\":%d,\"topologyOptimizations\":%d}}", 
+			ts, c.replans, c.pathIterations, c.topologyOptimizations);
+		fprintf(file, ",\n{\"name\":\"Path Nodes\",\"ph\":\"C\",\"pid\":1,\"ts\":%d,"
+			"\"args\":{\"lookups\":%d,\"probes\":%d,\"maxProbe\":%d}}", 
+			ts, c.nodeLookups, c.nodeProbes, c.maxNodeProbe);
+		fprintf(file, ",\n{\"name\":\"Proximity\",\"ph\":\"C\",\"pid\":1,\"ts\":%d,"
+			"\"args\":{\"boundaryUpdates\":%d,\"neighbours\":%d}}", ts, c.boundaryUpdates, c.neighbours);
+		fprintf(file, ",\n{\"name\":\"Avoidance\",\"ph\":\"C\",\"pid\":1,\"ts\":%d,"
+			"\"args\":{\"velocitySamples\":%d,\"collisions\":%d}}", ts, c.velocitySamples, c.collisions);
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	return fclose(file) == 0;
+}
@@ -0,0 +1,398 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <float.h>
+#include <string.h>
+
+#include <DetourCommon.h>
+
+#include "NavQueryService.h"
+
+// Requests per worker task
+static const int QUERY_BATCH_CHUNK = 16;
+// Polygons kept for path and raycast corridors
+static const int QUERY_MAX_POLYS = 256;
+
+static bool IsPathQuery(int type)
+{
+	return type == NAVQUERY_PATH || type == NAVQUERY_PATH_BIDIRECTIONAL;
+}
+
+NavQueryService::NavQueryService()
+	: navMesh(NULL), maxNodes(0), filters(NULL), filterCount(0), nextBatch(1)
+{
+	extents[0] = 1.0f;
+	extents[1] = 20.0f;
+	extents[2] = 1.0f;
+}
+
+NavQueryService::~NavQueryService()
+{
+	clear();
+}
+
+bool NavQueryService::init(const dtNavMesh* mesh, int nodes, const dtQueryFilter* queryFilters, int queryFilterCount)
+{
+	clear();
+	navMesh = mesh;
+	maxNodes = nodes;
+	filters = queryFilters;
+	filterCount = queryFilterCount;
+	return navMesh != NULL && filters != NULL && filterCount > 0;
+}
+
+void NavQueryService::clear()
+{
+	// Batches may still be running
+	for (std::map<int, Batch*>::iterator it = batches.begin(); it != batches.end(); ++it)
+	{
+#ifdef _MSC_VER
+		it->second->tasks.wait();
+#endif
+		delete it->second;
+	}
+	batches.clear();
+
+	for (size_t i = 0; i < queries.size(); ++i)
+		dtFreeNavMeshQuery(queries[i]);
+	queries.clear();
+	freeQueries.clear();
+}
+
+dtNavMeshQuery* NavQueryService::acquireQuery()
+{
+	if (navMesh == NULL)
+		return NULL;
+
+#ifdef _MSC_VER
+	navMeshLock.lock_read();
+#endif
+
+	dtNavMeshQuery* query = NULL;
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(poolLock);
+#endif
+		if (!freeQueries.empty())
+		{
+			query = freeQueries.back();
+			freeQueries.pop_back();
+		}
+	}
+	if (query != NULL)
+		return query;
+
+	// The pool grows to the number of threads querying at once
+	query = dtAllocNavMeshQuery();
+	if (query == NULL || dtStatusFailed(query->init(navMesh, maxNodes)))
+	{
+		dtFreeNavMeshQuery(query);
+#ifdef _MSC_VER
+		navMeshLock.unlock();
+#endif
+		return NULL;
+	}
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(poolLock);
+#endif
+		queries.push_back(query);
+	}
+	return query;
+}
+
+void NavQueryService::releaseQuery(dtNavMeshQuery* query)
+{
+	if (query == NULL)
+		return;
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(poolLock);
+#endif
+		freeQueries.push_back(query);
+	}
+#ifdef _MSC_VER
+	navMeshLock.unlock();
+#endif
+}
+
+int NavQueryService::submitBatch(const NavQueryRequest* requests, int count)
+{
+	if (navMesh == NULL || requests == NULL || count <= 0)
+		return 0;
+
+	Batch* batch = new Batch();
+	batch->requests.assign(requests, requests + count);
+	batch->results.resize(count);
+	batch->cornerOffsets.resize(count);
+	int cornerFloats = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		batch->cornerOffsets[i] = cornerFloats;
+		if (IsPathQuery(requests[i].type))
+			cornerFloats += NAVQUERY_MAX_CORNERS * 3;
+	}
+	batch->corners.resize(cornerFloats);
+	batch->complete = 0;
+
+	int handle;
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(batchLock);
+#endif
+		handle = nextBatch++;
+		if (nextBatch <= 0)
+			nextBatch = 1;
+		batches[handle] = batch;
+	}
+
+#ifdef _MSC_VER
+	batch->tasks.run([this, batch, count]()
+	{
+		const int chunks = (count + QUERY_BATCH_CHUNK - 1) / QUERY_BATCH_CHUNK;
+		Concurrency::parallel_for(0, chunks, [this, batch, count](int chunk)
+		{
+			const int first = chunk * QUERY_BATCH_CHUNK;
+			runBatch(batch, first, dtMin(QUERY_BATCH_CHUNK, count - first));
+		});
+		batch->complete = 1;
+	});
+#else
+	runBatch(batch, 0, count);
+	batch->complete = 1;
+#endif
+	return handle;
+}
+
+bool NavQueryService::isBatchComplete(int batch)
+{
+	Batch* b = findBatch(batch);
+	return b == NULL || b->complete != 0;
+}
+
+void NavQueryService::waitBatch(int batch)
+{
+	Batch* b = findBatch(batch);
+	if (b == NULL)
+		return;
+#ifdef _MSC_VER
+	b->tasks.wait();
+#endif
+}
+
+int NavQueryService::getBatchResults(int batch, NavQueryResult* results, int maxResults)
+{
+	Batch* b = findBatch(batch);
+	if (b == NULL || results == NULL)
+		return 0;
+	waitBatch(batch);
+
+	const int count = dtMin((int)b->results.size(), maxResults);
+	if (count > 0)
+		memcpy(results, &b->results[0], sizeof(NavQueryResult) * count);
+	return count;
+}
+
+int NavQueryService::getBatchPath(int batch, int request, float* corners, int maxCorners)
+{
+	Batch* b = findBatch(batch);
+	if (b == NULL || corners == NULL)
+		return 0;
+	if (request < 0 || request >= (int)b->requests.size())
+		return 0;
+	if (!IsPathQuery(b->requests[request].type))
+		return 0;
+	waitBatch(batch);
+
+	const int count = dtMin(b->results[request].cornerCount, maxCorners);
+	if (count > 0)
+		memcpy(corners, &b->corners[b->cornerOffsets[request]], sizeof(float) * 3 * count);
+	return count;
+}
+
+void NavQueryService::releaseBatch(int batch)
+{
+	Batch* b = NULL;
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(batchLock);
+#endif
+		std::map<int, Batch*>::iterator it = batches.find(batch);
+		if (it == batches.end())
+			return;
+		b = it->second;
+		batches.erase(it);
+	}
+#ifdef _MSC_VER
+	b->tasks.wait();
+#endif
+	delete b;
+}
+
+void NavQueryService::beginNavMeshUpdate()
+{
+#ifdef _MSC_VER
+	navMeshLock.lock();
+#endif
+}
+
+void NavQueryService::endNavMeshUpdate()
+{
+#ifdef _MSC_VER
+	navMeshLock.unlock();
+#endif
+}
+
+NavQueryService::Batch* NavQueryService::findBatch(int batch)
+{
+#ifdef _MSC_VER
+	Concurrency::critical_section::scoped_lock lock(batchLock);
+#endif
+	std::map<int, Batch*>::iterator it = batches.find(batch);
+	return it == batches.end() ? NULL : it->second;
+}
+
+void NavQueryService::runBatch(Batch* batch, int first, int count)
+{
+	dtNavMeshQuery* query = acquireQuery();
+	for (int i = first; i < first + count; ++i)
+	{
+		NavQueryResult& result = batch->results[i];
+		if (query == NULL)
+		{
+			memset(&result, 0, sizeof(result));
+			result.status = DT_FAILURE | DT_OUT_OF_MEMORY;
+			continue;
+		}
+		float* corners = NULL;
+		if (IsPathQuery(batch->requests[i].type))
+			corners = &batch->corners[batch->cornerOffsets[i]];
+		runQuery(query, batch->requests[i], result, corners);
+	}
+	releaseQuery(query);
+}
+
+void NavQueryService::runQuery(
+	dtNavMeshQuery* query, 
+	const NavQueryRequest& request, 
+	NavQueryResult& result, 
+	float* corners)
+{
+	memset(&result, 0, sizeof(result));
+	dtVcopy(result.position, request.start);
+	if (request.filter < 0 || request.filter >= filterCount)
+	{
+		result.status = DT_FAILURE | DT_INVALID_PARAM;
+		return;
+	}
+	const dtQueryFilter* filter = &filters[request.filter];
+
+	dtPolyRef startRef = 0;
+	float startPos[3];
+	dtStatus status = query->findNearestPoly(request.start, extents, filter, &startRef, startPos);
+	if (dtStatusFailed(status) || startRef == 0)
+	{
+		result.status = DT_FAILURE | (status & DT_STATUS_DETAIL_MASK);
+		return;
+	}
+
+	switch (request.type)
+	{
+	case NAVQUERY_NEAREST:
+		{
+			result.status = status;
+			result.poly = startRef;
+			dtVcopy(result.position, startPos);
+		}
+		break;
+
+	case NAVQUERY_RAYCAST:
+		{
+			dtPolyRef visited[QUERY_MAX_POLYS];
+			int visitedCount = 0;
+			float hitNormal[3];
+			result.status = query->raycast(startRef, startPos, request.end, filter, 
+				&result.t, hitNormal, visited, &visitedCount, QUERY_MAX_POLYS);
+			if (dtStatusFailed(result.status))
+				break;
+			if (result.t > 1.0f)
+				dtVcopy(result.position, request.end);
+			else
+				dtVlerp(result.position, startPos, request.end, result.t);
+			result.poly = visitedCount > 0 ? visited[visitedCount-1] : startRef;
+		}
+		break;
+
+	case NAVQUERY_PATH:
+	case NAVQUERY_PATH_BIDIRECTIONAL:
+		{
+			const bool bidirectional = request.type == NAVQUERY_PATH_BIDIRECTIONAL;
+			if (bidirectional && !query->isBidirectional())
+			{
+				status = query->init(navMesh, maxNodes, true);
+				if (dtStatusFailed(status))
+				{
+					result.status = status;
+					break;
+				}
+			}
+
+			dtPolyRef endRef = 0;
+			float endPos[3];
+			status = query->findNearestPoly(request.end, extents, filter, &endRef, endPos);
+			if (dtStatusFailed(status) || endRef == 0)
+			{
+				result.status = DT_FAILURE | (status & DT_STATUS_DETAIL_MASK);
+				break;
+			}
+
+			dtPolyRef path[QUERY_MAX_POLYS];
+			int pathCount = 0;
+			if (bidirectional)
+				result.status = query->findPathBidirectional(startRef, endRef, startPos, endPos, filter, 
+					path, &pathCount, QUERY_MAX_POLYS);
+			else
+				result.status = query->findPath(startRef, endRef, startPos, endPos, filter, 
+					path, &pathCount, QUERY_MAX_POLYS);
+			if (dtStatusFailed(result.status) || pathCount == 0)
+				break;
+
+			// A partial path ends on the polygon closest to the goal
+			float pathEnd[3];
+			dtVcopy(pathEnd, endPos);
+			if (path[pathCount-1] != endRef)
+				query->closestPointOnPoly(path[pathCount-1], endPos, pathEnd);
+
+			dtStatus cornerStatus = query->findStraightPath(startPos, pathEnd, path, pathCount, 
+				corners, NULL, NULL, &result.cornerCount, NAVQUERY_MAX_CORNERS);
+			result.status |= cornerStatus & DT_STATUS_DETAIL_MASK;
+			if (result.cornerCount > 0)
+				dtVcopy(result.position, &corners[(result.cornerCount-1)*3]);
+			result.poly = path[pathCount-1];
+		}
+		break;
+
+	default:
+		result.status = DT_FAILURE | DT_INVALID_PARAM;
+		break;
+	}
+}
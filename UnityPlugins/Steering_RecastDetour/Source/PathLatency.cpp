@@ -0,0 +1,106 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <algorithm>
+
+#include "PathLatency.h"
+
+PathLatency::PathLatency()
+	: head(0), count(0)
+{
+}
+
+void PathLatency::init(int maxAgents)
+{
+	requestTimes.assign(maxAgents, 0);
+	waiting.assign(maxAgents, 0);
+	stillPending.resize(maxAgents);
+	pending.clear();
+	pending.reserve(maxAgents);
+	samples.assign(MAX_SAMPLES, 0);
+	reset();
+}
+
+void PathLatency::reset()
+{
+	head = 0;
+	count = 0;
+}
+
+void PathLatency::requested(int agent)
+{
+	if (requestTimes[agent] == 0)
+		pending.push_back(agent);
+	requestTimes[agent] = getPerfTime();
+}
+
+void PathLatency::update(const dtCrowd* crowd)
+{
+	if (pending.empty())
+		return;
+
+	const TimeVal now = getPerfTime();
+	const int nwaiting = crowd->getPendingMoveTargets(&stillPending[0], (int)stillPending.size());
+	for (int i = 0; i < nwaiting; ++i)
+		waiting[stillPending[i]] = 1;
+
+	int n = 0;
+	for (size_t i = 0; i < pending.size(); ++i)
+	{
+		const int agent = pending[i];
+		if (waiting[agent])
+		{
+			pending[n++] = agent;
+			continue;
+		}
+
+		// Agents removed while waiting are dropped
+		if (crowd->getAgent(agent)->active)
+		{
+			samples[head] = getPerfTimeUsec(now - requestTimes[agent]);
+			head = (head + 1) % MAX_SAMPLES;
+			count = std::min(count + 1, (int)MAX_SAMPLES);
+		}
+		requestTimes[agent] = 0;
+	}
+	pending.resize(n);
+
+	for (int i = 0; i < nwaiting; ++i)
+		waiting[stillPending[i]] = 0;
+}
+
+void PathLatency::getStats(PathLatencyStats* stats) const
+{
+	memset(stats, 0, sizeof(PathLatencyStats));
+	stats->samples = count;
+	stats->pending = (int)pending.size();
+	if (count == 0)
+		return;
+
+	std::vector<int> sorted(samples.begin(), samples.begin() + count);
+	std::sort(sorted.begin(), sorted.end());
+	stats->p50Usec = sorted[(count - 1) * 50 / 100];
+	stats->p90Usec = sorted[(count - 1) * 90 / 100];
+	stats->p99Usec = sorted[(count - 1) * 99 / 100];
+	stats->maxUsec = sorted[count - 1];
+}
@@ -21,8 +21,17 @@
 */
 
 #include <iostream>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#ifdef _MSC_VER
+#include <ppl.h>
+#endif
+
+#include <DetourCommon.h>
 
 #include "Steering.h"
+#include "PerfTimer.h"
 
 float* Vector3ToFloat(Vector3 v)
 {
@@ -42,6 +51,93 @@ Vector3 FloatToVec3(const float* f)
 	return v;
 }
 
+// Spreads the low 16 bits of x over the even bits of the result.
+static unsigned int MortonSpread(unsigned int x)
+{
+	x &= 0xffff;
+	x = (x | (x << 8)) & 0x00ff00ff;
+	x = (x | (x << 4)) & 0x0f0f0f0f;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	return x;
+}
+
+static const int SNAPSHOT_MAGIC = 'S'<<24 | 'N'<<16 | 'A'<<8 | 'P';
+static const int SNAPSHOT_VERSION = 2;
+
+// Layout of a snapshot:
+//
+//   SnapshotHeader
+//   (SnapshotTileHeader, tile state[stateSize]) * numTiles
+//   crowd state[crowdStateSize]
+//   LOD state[lodStateSize]
+struct SnapshotHeader
+{
+	int magic;
+	int version;
+	int numTiles;
+	int crowdStateSize;
+	int lodStateSize;
+	unsigned int stepCount;
+	float stepAccumulator;
+};
+
+struct SnapshotTileHeader
+{
+	dtTileRef ref;
+	int stateSize;
+};
+
+// Slices are added when the crowd update is over budget and removed
+// when the update would still fit with one slice less, with some margin
+static const float CROWD_BUDGET_MARGIN = 0.8f;
+
+// Path iterations per crowd update. The fixed step budget is enough for
+// every search the path queue holds to use up its node pool, so searches
+// normally finish in the update they start in. One that does not goes on
+// in the next step on every peer alike.
+static const int DEFAULT_PATH_ITERATIONS = 100;
+static const int DETERMINISTIC_PATH_ITERATIONS = 8 * 4096;
+
+// FNV-1a, for the state checksum
+static const unsigned int FNV_OFFSET_BASIS = 2166136261u;
+static const unsigned int FNV_PRIME = 16777619u;
+
+static unsigned int HashBytes(unsigned int hash, const void* data, int size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (int i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	return hash;
+}
+
+static long long CrowdClock()
+{
+	return (long long)getPerfTime();
+}
+
+// Points per worker task in getClosestWalkablePositions
+static const int SNAP_BATCH_SIZE = 64;
+// Rays per worker task in raycastBatch
+static const int RAYCAST_BATCH_SIZE = 64;
+// Polygons a batched ray may cross
+static const int RAYCAST_MAX_POLYS = 128;
+
+SteeringManager::SteeringManager()
+	: tileCache(NULL), tileCacheCompressor(NULL), tileCacheDirty(false), maxTileRebuildsPerUpdate(1),
+	crowdBudgetUsec(0), crowdMaxSlices(1),
+	fixedTimeStep(0.0f), maxFixedSteps(1), stepAccumulator(0.0f), stepCount(0)
+{
+	memset(&crowdTimings, 0, sizeof(crowdTimings));
+	crowdTimings.slices = 1;
+}
+
+SteeringManager::~SteeringManager()
+{
+	dtFreeTileCache(tileCache);
+	dtFreeTileCacheCompressor(tileCacheCompressor);
+}
+
 bool SteeringManager::init(
 	unsigned char* navMeshData, 
 	int navMeshDataSize, 
@@ -57,9 +153,156 @@ bool SteeringManager::init(
 	return true;
 }
 
+bool SteeringManager::initTileCache(
+	unsigned char* tileCacheData, 
+	int tileCacheDataSize, 
+	int maxAgents,
+	float maxAgentRadius)
+{
+	if (!initTileCacheNavMesh(tileCacheData, tileCacheDataSize))
+		return false;
+	if (!initQuery())
+		return false;
+	if (!initCrowd(maxAgents, maxAgentRadius))
+		return false;
+	return true;
+}
+
+bool SteeringManager::initNavMeshSet(
+	unsigned char* navMeshSetData, 
+	int navMeshSetDataSize, 
+	int maxAgents,
+	float maxAgentRadius)
+{
+	if (!readNavMeshSet(navMeshSetData, navMeshSetDataSize, true))
+		return false;
+	if (!initQuery())
+		return false;
+	if (!initCrowd(maxAgents, maxAgentRadius))
+		return false;
+	return true;
+}
+
+bool SteeringManager::initStreaming(
+	const char* navMeshSetPath, 
+	int maxAgents, 
+	float maxAgentRadius,
+	float streamingRadius,
+	int maxResidentTiles)
+{
+	if (!tileStreamer.open(navMeshSetPath))
+		return false;
+	tileStreamer.setLimits(streamingRadius, maxResidentTiles);
+	dtStatus status = navMesh.init(&tileStreamer.getNavMeshParams());
+	if (status & DT_FAILURE)
+		return false;
+	if (!initQuery())
+		return false;
+	if (!initCrowd(maxAgents, maxAgentRadius))
+		return false;
+	return true;
+}
+
 void SteeringManager::update(float dT)
 {
+	if (fixedTimeStep <= 0.0f)
+	{
+		step(dT);
+		return;
+	}
+
+	// Time beyond maxSteps is kept rather than dropped, so a slow frame
+	// delays steps but never changes them.
+	stepAccumulator += dT;
+	for (int i = 0; i < maxFixedSteps && stepAccumulator >= fixedTimeStep; ++i)
+	{
+		step(fixedTimeStep);
+		stepAccumulator -= fixedTimeStep;
+	}
+}
+
+void SteeringManager::step(float dT)
+{
+	if (tileCacheDirty)
+		updateTileCache(dT);
+	if (tileStreamer.isOpen())
+		updateStreaming();
+
+	if (lod.isEnabled())
+		lod.assignTiers(&crowd);
+	const TimeVal startTime = getPerfTime();
 	crowd.update(dT, nullptr);
+	const int updateUsec = getPerfTimeUsec(getPerfTime() - startTime);
+	if (lod.isEnabled())
+		lod.finishUpdate(&crowd, updateUsec);
+	updateCrowdTimings(startTime, updateUsec);
+	pathLatency.update(&crowd);
+	stepCount++;
+}
+
+void SteeringManager::updateCrowdTimings(TimeVal startTime, int updateUsec)
+{
+	crowdTimings.totalUsec = updateUsec;
+	crowdTimings.slices = crowd.getUpdateSlices();
+	for (int i = 0; i < DT_CROWD_MAX_PHASES; ++i)
+		crowdTimings.phaseUsec[i] = getPerfTimeUsec((TimeVal)crowd.getPhaseTime(i));
+	crowdTimings.counters = crowd.getUpdateCounters();
+	crowdTrace.addFrame(startTime, crowdTimings);
+	if (crowdBudgetUsec <= 0 || fixedTimeStep > 0.0f)
+		return;
+
+	// Only the sliced phases shrink with more slices
+	const int slices = crowd.getUpdateSlices();
+	const int slicedUsec = 
+		crowdTimings.phaseUsec[DT_CROWD_PHASE_PROXIMITY] + 
+		crowdTimings.phaseUsec[DT_CROWD_PHASE_AVOIDANCE];
+	if (updateUsec > crowdBudgetUsec && slices < crowdMaxSlices)
+	{
+		crowd.setUpdateSlices(slices + 1);
+	}
+	else if (slices > 1)
+	{
+		const int fewerSlicesUsec = updateUsec + slicedUsec / (slices - 1);
+		if (fewerSlicesUsec < crowdBudgetUsec * CROWD_BUDGET_MARGIN)
+			crowd.setUpdateSlices(slices - 1);
+	}
+}
+
+void SteeringManager::updateTileCache(float dT)
+{
+	// Time-slice the rebuild: each tile cache update rebuilds one tile
+	bool upToDate = false;
+	queryService.beginNavMeshUpdate();
+	for (int i = 0; i < maxTileRebuildsPerUpdate && !upToDate; ++i)
+	{
+		dtCompressedTileRef rebuilt = 0;
+		tileCache->update(dT, &navMesh, &upToDate, &rebuilt);
+
+		// Rebuilt tiles get new polygon refs, so the corridors running
+		// through them have to be replanned, not just the next few polys
+		const dtCompressedTile* tile = rebuilt ? tileCache->getTileByRef(rebuilt) : NULL;
+		if (tile != NULL && tile->header != NULL)
+			crowd.requestTilePathValidation(tile->header->tx, tile->header->ty);
+	}
+	queryService.endNavMeshUpdate();
+	tileCacheDirty = !upToDate;
+}
+
+void SteeringManager::updateStreaming()
+{
+	for (int i = 0; i < crowd.getAgentCount(); ++i)
+	{
+		const dtCrowdAgent* ag = crowd.getAgent(i);
+		if (!ag->active)
+			continue;
+		tileStreamer.addInterest(ag->npos);
+		if (ag->corridor.getPathCount() > 0)
+			tileStreamer.addInterest(ag->corridor.getTarget());
+	}
+
+	// Evicted tiles take their polygon refs with them
+	if (tileStreamer.update(&navMesh, &queryService) > 0)
+		crowd.requestFullPathValidation();
 }
 
 int SteeringManager::addAgent(
@@ -87,8 +330,16 @@ int SteeringManager::addAgent(
 		;
 	params.obstacleAvoidanceType = 3;
 	params.separationWeight = 2.0f;
+	params.queryFilterType = 0;
+	params.updateInterval = 1;
 
-	return crowd.addAgent(Vector3ToFloat(pos), &params);
+	int agent = crowd.addAgent(Vector3ToFloat(pos), &params);
+	if (agent != -1)
+	{
+		lod.setAgentFlags(agent, params.updateFlags);
+		lod.resetAgent(&crowd, agent);
+	}
+	return agent;
 }
 
 void SteeringManager::removeAgent(int agent)
@@ -99,6 +350,7 @@ void SteeringManager::removeAgent(int agent)
 void SteeringManager::updateAgentNavigationQuality(int agent, NavigationQuality nq)
 {
 	dtCrowdAgentParams params = crowd.getAgent(agent)->params;
+	params.updateFlags = lod.getAgentFlags(agent);
 	switch(nq)
 	{
 	case NAVIGATIONQUALITY_LOW:
@@ -141,6 +393,8 @@ void SteeringManager::updateAgentNavigationQuality(int agent, NavigationQuality
 		break;
 	}
 
+	lod.setAgentFlags(agent, params.updateFlags);
+	lod.applyTier(agent, &params);
 	crowd.updateAgentParameters(agent, &params);
 }
 
@@ -181,28 +435,65 @@ void SteeringManager::updateAgentMaxAcceleration(int agent, float accel)
 	crowd.updateAgentParameters(agent, &params);
 }
 
-void SteeringManager::setAgentTarget(int agent, Vector3 target)
+bool SteeringManager::setAgentQueryFilter(int agent, int filter)
 {
-	dtPolyRef polyRef;
+	if (filter < 0 || filter >= DT_CROWD_MAX_QUERY_FILTER_TYPE)
+		return false;
+	dtCrowdAgentParams params = crowd.getAgent(agent)->params;
+	params.queryFilterType = (unsigned char)filter;
+	crowd.updateAgentParameters(agent, &params);
+	return true;
+}
+
+bool SteeringManager::setQueryFilterAreaCost(int filter, int area, float cost)
+{
+	dtQueryFilter* queryFilter = crowd.getEditableFilter(filter);
+	if (queryFilter == NULL || area < 0 || area >= DT_MAX_AREAS)
+		return false;
+	queryFilter->setAreaCost(area, cost);
+	return true;
+}
+
+bool SteeringManager::setQueryFilterFlags(int filter, unsigned short includeFlags, unsigned short excludeFlags)
+{
+	dtQueryFilter* queryFilter = crowd.getEditableFilter(filter);
+	if (queryFilter == NULL)
+		return false;
+	queryFilter->setIncludeFlags(includeFlags);
+	queryFilter->setExcludeFlags(excludeFlags);
+	return true;
+}
+
+bool SteeringManager::setAgentTarget(int agent, Vector3 target)
+{
+	// getAgent does no bounds check, and the agent is read below
+	if (agent < 0 || agent >= crowd.getAgentCount())
+		return false;
+	const dtCrowdAgent* ag = crowd.getAgent(agent);
+	if (!ag->active)
+		return false;
+
+	dtPolyRef polyRef = 0;
 	float nearestPos[3];
 	dtStatus status = query.findNearestPoly(
 		Vector3ToFloat(target),
 		crowd.getQueryExtents(),
-		crowd.getFilter(),
+		crowd.getFilter(ag->params.queryFilterType),
 		&polyRef,
 		nearestPos);
 
-	if((status & DT_FAILURE) == 0)
-	{
-		if(!crowd.requestMoveTarget(agent, polyRef, nearestPos))
-		{
-			// TODO: Handle Failure (Couldn't request new target.)
-		}
-	}
-	else
-	{
-		// TODO: Handle failure (Couldn't find nearest polygon.)
-	}
+	if((status & DT_FAILURE) != 0 || polyRef == 0)
+		return false;
+
+	// A target on another island would only make the crowd search
+	// the whole island every update without ever finding it.
+	if(!navMesh.isConnected(ag->corridor.getFirstPoly(), polyRef))
+		return false;
+
+	if (!crowd.requestMoveTarget(agent, polyRef, nearestPos))
+		return false;
+	pathLatency.requested(agent);
+	return true;
 }
 
 void SteeringManager::setAgentMobile(int person, bool mobile)
@@ -213,7 +504,9 @@ void SteeringManager::setAgentMobile(int person, bool mobile)
 
 Vector3 SteeringManager::getAgentPosition(int person)
 {
-	return FloatToVec3(crowd.getAgent(person)->npos);
+	float pos[3];
+	lod.getAgentPosition(&crowd, person, pos);
+	return FloatToVec3(pos);
 }
 
 Vector3 SteeringManager::getAgentCurrentVelocity(int person)
@@ -231,16 +524,477 @@ Vector3 SteeringManager::getClosestWalkablePosition(Vector3 pos)
 	float closest[3];
 	const static float extents[] = { 1.0f, 20.0f, 1.0f };
 	dtPolyRef closestPoly;
-	dtQueryFilter filter;
 	dtStatus status = query.findNearestPoly(
 		Vector3ToFloat(pos),
 		extents, 
-		&filter, 
+		crowd.getFilter(0), 
 		&closestPoly, 
 		closest);
 	return FloatToVec3(closest);
 }
 
+bool SteeringManager::isReachable(Vector3 from, Vector3 to)
+{
+	float nearest[3];
+	const static float extents[] = { 1.0f, 20.0f, 1.0f };
+	dtPolyRef fromPoly = 0;
+	dtPolyRef toPoly = 0;
+	const dtQueryFilter* filter = crowd.getFilter(0);
+	query.findNearestPoly(Vector3ToFloat(from), extents, filter, &fromPoly, nearest);
+	query.findNearestPoly(Vector3ToFloat(to), extents, filter, &toPoly, nearest);
+	if (fromPoly == 0 || toPoly == 0)
+		return false;
+	return navMesh.isConnected(fromPoly, toPoly);
+}
+
+bool SteeringManager::isPolyReachable(unsigned int fromPoly, unsigned int toPoly)
+{
+	if (!navMesh.isValidPolyRef(fromPoly) || !navMesh.isValidPolyRef(toPoly))
+		return false;
+	return navMesh.isConnected(fromPoly, toPoly);
+}
+
+int SteeringManager::getClosestWalkablePositions(
+	const Vector3* positions, 
+	int count, 
+	Vector3* results, 
+	unsigned int* polys)
+{
+	if (count <= 0)
+		return 0;
+
+	// Morton codes over the xz bounds of the batch
+	float bmin[2] = { positions[0].x, positions[0].z };
+	float bmax[2] = { positions[0].x, positions[0].z };
+	for (int i = 1; i < count; ++i)
+	{
+		bmin[0] = dtMin(bmin[0], positions[i].x);
+		bmin[1] = dtMin(bmin[1], positions[i].z);
+		bmax[0] = dtMax(bmax[0], positions[i].x);
+		bmax[1] = dtMax(bmax[1], positions[i].z);
+	}
+	const float sx = bmax[0] > bmin[0] ? 65535.0f / (bmax[0] - bmin[0]) : 0.0f;
+	const float sz = bmax[1] > bmin[1] ? 65535.0f / (bmax[1] - bmin[1]) : 0.0f;
+
+	std::vector<std::pair<unsigned int, int> > order(count);
+	for (int i = 0; i < count; ++i)
+	{
+		const unsigned int qx = (unsigned int)((positions[i].x - bmin[0]) * sx);
+		const unsigned int qz = (unsigned int)((positions[i].z - bmin[1]) * sz);
+		order[i].first = MortonSpread(qx) | (MortonSpread(qz) << 1);
+		order[i].second = i;
+	}
+	std::sort(order.begin(), order.end());
+
+	// findNearestPoly only reads the navmesh, so one query serves all threads
+	const static float extents[] = { 1.0f, 20.0f, 1.0f };
+	const dtQueryFilter* filter = crowd.getFilter(0);
+	std::vector<dtPolyRef> refs(count);
+	const int numBatches = (count + SNAP_BATCH_SIZE-1) / SNAP_BATCH_SIZE;
+	const dtNavMeshQuery& sharedQuery = query;
+
+	auto snapBatch = [&](int batch)
+	{
+		const int end = dtMin(count, (batch+1) * SNAP_BATCH_SIZE);
+		for (int j = batch * SNAP_BATCH_SIZE; j < end; ++j)
+		{
+			const int i = order[j].second;
+			const float pos[3] = { positions[i].x, positions[i].y, positions[i].z };
+			float closest[3];
+			dtPolyRef ref = 0;
+			sharedQuery.findNearestPoly(pos, extents, filter, &ref, closest);
+			refs[i] = ref;
+			results[i] = ref ? FloatToVec3(closest) : positions[i];
+		}
+	};
+
+#ifdef _MSC_VER
+	Concurrency::parallel_for(0, numBatches, snapBatch);
+#else
+	for (int batch = 0; batch < numBatches; ++batch)
+		snapBatch(batch);
+#endif
+
+	int found = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		if (polys)
+			polys[i] = refs[i];
+		if (refs[i])
+			found++;
+	}
+	return found;
+}
+
+int SteeringManager::raycastBatch(const NavRaycast* rays, int count, NavRaycastHit* hits)
+{
+	if (count <= 0)
+		return 0;
+
+	// Agent positions are read here, before the workers start
+	std::vector<dtPolyRef> startRefs(count);
+	std::vector<float> startPos(count * 3);
+	std::vector<const dtQueryFilter*> filters(count, crowd.getFilter(0));
+	for (int i = 0; i < count; ++i)
+	{
+		const NavRaycast& ray = rays[i];
+		float* pos = &startPos[i * 3];
+		startRefs[i] = 0;
+		hits[i].t = 0.0f;
+		hits[i].normal.x = hits[i].normal.y = hits[i].normal.z = 0.0f;
+		hits[i].lastPoly = 0;
+		if (ray.agent >= 0)
+		{
+			if (ray.agent >= crowd.getAgentCount())
+				continue;
+			const dtCrowdAgent* ag = crowd.getAgent(ray.agent);
+			if (!ag->active)
+				continue;
+			startRefs[i] = ag->corridor.getFirstPoly();
+			filters[i] = crowd.getFilter(ag->params.queryFilterType);
+			dtVcopy(pos, ag->npos);
+		}
+		else
+		{
+			startRefs[i] = ray.startPoly;
+			pos[0] = ray.start.x;
+			pos[1] = ray.start.y;
+			pos[2] = ray.start.z;
+		}
+	}
+
+	std::vector<unsigned char> cast(count, 0);
+	const int numBatches = (count + RAYCAST_BATCH_SIZE-1) / RAYCAST_BATCH_SIZE;
+
+	auto raycastRange = [&](int batch)
+	{
+		dtNavMeshQuery* batchQuery = queryService.acquireQuery();
+		if (batchQuery == NULL)
+			return;
+
+		dtPolyRef visited[RAYCAST_MAX_POLYS];
+		const int end = dtMin(count, (batch+1) * RAYCAST_BATCH_SIZE);
+		for (int i = batch * RAYCAST_BATCH_SIZE; i < end; ++i)
+		{
+			NavRaycastHit& hit = hits[i];
+			if (!navMesh.isValidPolyRef(startRefs[i]))
+				continue;
+
+			const float endPos[3] = { rays[i].end.x, rays[i].end.y, rays[i].end.z };
+			float normal[3] = { 0.0f, 0.0f, 0.0f };
+			int visitedCount = 0;
+			dtStatus status = batchQuery->raycast(startRefs[i], &startPos[i * 3], endPos, filters[i],
+				&hit.t, normal, visited, &visitedCount, RAYCAST_MAX_POLYS);
+			if (dtStatusFailed(status))
+				continue;
+
+			hit.normal = FloatToVec3(normal);
+			hit.lastPoly = visitedCount > 0 ? visited[visitedCount-1] : startRefs[i];
+			cast[i] = 1;
+		}
+
+		queryService.releaseQuery(batchQuery);
+	};
+
+#ifdef _MSC_VER
+	Concurrency::parallel_for(0, numBatches, raycastRange);
+#else
+	for (int batch = 0; batch < numBatches; ++batch)
+		raycastRange(batch);
+#endif
+
+	int numCast = 0;
+	for (int i = 0; i < count; ++i)
+		numCast += cast[i];
+	return numCast;
+}
+
+unsigned int SteeringManager::addObstacle(Vector3 pos, float radius, float height)
+{
+	if (tileCache == NULL)
+		return 0;
+
+	float p[3] = { pos.x, pos.y, pos.z };
+	dtObstacleRef ref = 0;
+	if (dtStatusFailed(tileCache->addObstacle(p, radius, height, &ref)))
+		return 0;
+	tileCacheDirty = true;
+	return ref;
+}
+
+unsigned int SteeringManager::moveObstacle(unsigned int obstacle, Vector3 pos)
+{
+	if (tileCache == NULL)
+		return 0;
+
+	// Obstacles can't be moved in place, so replace it with a new one
+	const dtTileCacheObstacle* ob = tileCache->getObstacleByRef(obstacle);
+	if (ob == NULL || ob->state == DT_OBSTACLE_EMPTY || ob->state == DT_OBSTACLE_REMOVING)
+		return 0;
+	const float radius = ob->radius;
+	const float height = ob->height;
+
+	// A full request queue would leave the old obstacle in place next
+	// to the new one, with the caller holding neither ref
+	if (dtStatusFailed(tileCache->removeObstacle(obstacle)))
+		return 0;
+	tileCacheDirty = true;
+	return addObstacle(pos, radius, height);
+}
+
+void SteeringManager::removeObstacle(unsigned int obstacle)
+{
+	if (tileCache == NULL)
+		return;
+	if (dtStatusSucceed(tileCache->removeObstacle(obstacle)))
+		tileCacheDirty = true;
+}
+
+void SteeringManager::setMaxTileRebuildsPerUpdate(int maxRebuilds)
+{
+	maxTileRebuildsPerUpdate = maxRebuilds > 1 ? maxRebuilds : 1;
+}
+
+bool SteeringManager::updateNavMeshTiles(unsigned char* navMeshSetData, int navMeshSetDataSize)
+{
+	// Tile cache navmeshes are rebuilt from their layers, not replaced
+	if (tileCache != NULL)
+		return false;
+	queryService.beginNavMeshUpdate();
+	const bool read = readNavMeshSet(navMeshSetData, navMeshSetDataSize, false);
+	queryService.endNavMeshUpdate();
+	if (!read)
+		return false;
+
+	// Replaced tiles get new polygon refs, same as a tile cache rebuild
+	crowd.requestFullPathValidation();
+	return true;
+}
+
+void SteeringManager::requestTiles(Vector3 pos)
+{
+	const float p[3] = { pos.x, pos.y, pos.z };
+	tileStreamer.addInterest(p);
+}
+
+bool SteeringManager::isTileResident(Vector3 pos)
+{
+	const float p[3] = { pos.x, pos.y, pos.z };
+	return tileStreamer.isResident(p);
+}
+
+void SteeringManager::getStreamingStats(TileStreamingStats* stats)
+{
+	tileStreamer.getStats(stats);
+}
+
+int SteeringManager::saveSnapshot(unsigned char* buffer, int maxSize)
+{
+	const dtNavMesh& mesh = navMesh;
+	SnapshotHeader header;
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.numTiles = 0;
+	header.crowdStateSize = crowd.getStateSize();
+	header.lodStateSize = lod.getStateSize();
+	header.stepCount = stepCount;
+	header.stepAccumulator = stepAccumulator;
+
+	int size = sizeof(SnapshotHeader);
+	for (int i = 0; i < mesh.getMaxTiles(); ++i)
+	{
+		const dtMeshTile* tile = mesh.getTile(i);
+		if (tile == NULL || tile->header == NULL)
+			continue;
+		header.numTiles++;
+		size += sizeof(SnapshotTileHeader) + mesh.getTileStateSize(tile);
+	}
+	size += header.crowdStateSize + header.lodStateSize;
+
+	if (buffer == NULL)
+		return size;
+	if (maxSize < size)
+		return -1;
+
+	int offset = 0;
+	memcpy(buffer, &header, sizeof(SnapshotHeader));
+	offset += sizeof(SnapshotHeader);
+	for (int i = 0; i < mesh.getMaxTiles(); ++i)
+	{
+		const dtMeshTile* tile = mesh.getTile(i);
+		if (tile == NULL || tile->header == NULL)
+			continue;
+		SnapshotTileHeader tileHeader;
+		tileHeader.ref = mesh.getTileRef(tile);
+		tileHeader.stateSize = mesh.getTileStateSize(tile);
+		memcpy(buffer + offset, &tileHeader, sizeof(SnapshotTileHeader));
+		offset += sizeof(SnapshotTileHeader);
+		mesh.storeTileState(tile, buffer + offset, tileHeader.stateSize);
+		offset += tileHeader.stateSize;
+	}
+	if (dtStatusFailed(crowd.storeState(buffer + offset, header.crowdStateSize)))
+		return -1;
+	offset += header.crowdStateSize;
+	lod.storeState(buffer + offset);
+	return size;
+}
+
+bool SteeringManager::restoreSnapshot(const unsigned char* buffer, int size)
+{
+	if (buffer == NULL || size < (int)sizeof(SnapshotHeader))
+		return false;
+	SnapshotHeader header;
+	memcpy(&header, buffer, sizeof(SnapshotHeader));
+	if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION)
+		return false;
+
+	// Find the crowd state first, so a truncated snapshot changes nothing
+	int offset = sizeof(SnapshotHeader);
+	for (int i = 0; i < header.numTiles; ++i)
+	{
+		SnapshotTileHeader tileHeader;
+		if (offset + (int)sizeof(SnapshotTileHeader) > size)
+			return false;
+		memcpy(&tileHeader, buffer + offset, sizeof(SnapshotTileHeader));
+		offset += sizeof(SnapshotTileHeader);
+		if (tileHeader.stateSize < 0 || offset + tileHeader.stateSize > size)
+			return false;
+		offset += tileHeader.stateSize;
+	}
+	if (offset + header.crowdStateSize + header.lodStateSize > size ||
+		header.lodStateSize != lod.getStateSize())
+		return false;
+	if (dtStatusFailed(crowd.restoreState(buffer + offset, header.crowdStateSize)))
+		return false;
+	lod.restoreState(buffer + offset + header.crowdStateSize, header.lodStateSize);
+	lod.resetAgents(&crowd);
+	stepCount = header.stepCount;
+	stepAccumulator = header.stepAccumulator;
+
+	bool restored = true;
+	offset = sizeof(SnapshotHeader);
+	queryService.beginNavMeshUpdate();
+	for (int i = 0; i < header.numTiles; ++i)
+	{
+		SnapshotTileHeader tileHeader;
+		memcpy(&tileHeader, buffer + offset, sizeof(SnapshotTileHeader));
+		offset += sizeof(SnapshotTileHeader);
+
+		// Only the flags and areas of the tile change
+		const dtMeshTile* tile = navMesh.getTileByRef(tileHeader.ref);
+		if (tile == NULL || dtStatusFailed(navMesh.restoreTileState(
+			const_cast<dtMeshTile*>(tile), buffer + offset, tileHeader.stateSize)))
+			restored = false;
+		offset += tileHeader.stateSize;
+	}
+	queryService.endNavMeshUpdate();
+	return restored;
+}
+
+void SteeringManager::setCrowdUpdateBudget(int budgetUsec, int maxSlices)
+{
+	crowdBudgetUsec = budgetUsec;
+	crowdMaxSlices = std::max(maxSlices, 1);
+	updateCrowdSlices();
+}
+
+void SteeringManager::updateCrowdSlices()
+{
+	if (crowdBudgetUsec <= 0)
+		crowd.setUpdateSlices(1);
+	else if (fixedTimeStep > 0.0f)
+		crowd.setUpdateSlices(crowdMaxSlices);
+	else if (crowd.getUpdateSlices() > crowdMaxSlices)
+		crowd.setUpdateSlices(crowdMaxSlices);
+}
+
+void SteeringManager::setFixedTimeStep(float stepSeconds, int maxSteps)
+{
+	fixedTimeStep = std::max(stepSeconds, 0.0f);
+	maxFixedSteps = std::max(maxSteps, 1);
+	stepAccumulator = 0.0f;
+
+	const bool fixed = fixedTimeStep > 0.0f;
+	crowd.setMaxPathIterations(fixed ? DETERMINISTIC_PATH_ITERATIONS : DEFAULT_PATH_ITERATIONS);
+	tileStreamer.setSynchronous(fixed);
+	lod.setBudgetEnabled(!fixed);
+	updateCrowdSlices();
+}
+
+unsigned int SteeringManager::getStateChecksum()
+{
+	unsigned int hash = HashBytes(FNV_OFFSET_BASIS, &stepCount, sizeof(stepCount));
+	for (int i = 0; i < crowd.getAgentCount(); ++i)
+	{
+		const dtCrowdAgent* ag = crowd.getAgent(i);
+		if (!ag->active)
+			continue;
+		const int npath = ag->corridor.getPathCount();
+		hash = HashBytes(hash, &i, sizeof(i));
+		hash = HashBytes(hash, &ag->state, sizeof(ag->state));
+		hash = HashBytes(hash, ag->npos, sizeof(ag->npos));
+		hash = HashBytes(hash, ag->vel, sizeof(ag->vel));
+		hash = HashBytes(hash, ag->corridor.getTarget(), sizeof(float)*3);
+		hash = HashBytes(hash, ag->corridor.getPath(), sizeof(dtPolyRef)*npath);
+	}
+	return hash;
+}
+
+void SteeringManager::getCrowdUpdateTimings(CrowdUpdateTimings* timings)
+{
+	*timings = crowdTimings;
+}
+
+void SteeringManager::startCrowdTrace(int maxFrames)
+{
+	crowdTrace.start(maxFrames);
+}
+
+void SteeringManager::stopCrowdTrace()
+{
+	crowdTrace.stop();
+}
+
+bool SteeringManager::writeCrowdTrace(const char* path)
+{
+	return crowdTrace.write(path);
+}
+
+void SteeringManager::getPathLatencyStats(PathLatencyStats* stats)
+{
+	pathLatency.getStats(stats);
+}
+
+void SteeringManager::resetPathLatencyStats()
+{
+	pathLatency.reset();
+}
+
+void SteeringManager::setLodEnabled(bool enabled)
+{
+	lod.setEnabled(&crowd, enabled);
+}
+
+void SteeringManager::setLodSettings(const CrowdLodSettings& settings)
+{
+	lod.setSettings(settings);
+}
+
+void SteeringManager::setLodObservers(const Vector3* positions, int count)
+{
+	lod.setObservers(count > 0 ? &positions[0].x : NULL, count);
+}
+
+CrowdLodTier SteeringManager::getAgentLodTier(int agent)
+{
+	return lod.getAgentTier(agent);
+}
+
+void SteeringManager::getLodStats(CrowdLodStats* stats)
+{
+	lod.getStats(stats);
+}
+
 bool SteeringManager::initNavMesh(unsigned char* navmeshData, int navmeshDataSize)
 {
 	dtStatus status = navMesh.init(navmeshData, navmeshDataSize, 0);
@@ -249,12 +1003,127 @@ bool SteeringManager::initNavMesh(unsigned char* navmeshData, int navmeshDataSiz
 	return true;
 }
 
+bool SteeringManager::initTileCacheNavMesh(unsigned char* tileCacheData, int tileCacheDataSize)
+{
+	if (tileCacheDataSize < (int)sizeof(TileCacheSetHeader))
+		return false;
+
+	TileCacheSetHeader header;
+	memcpy(&header, tileCacheData, sizeof(TileCacheSetHeader));
+	if (header.magic != TILECACHESET_MAGIC || header.version != TILECACHESET_VERSION)
+		return false;
+
+	dtStatus status = navMesh.init(&header.meshParams);
+	if (status & DT_FAILURE)
+		return false;
+
+	// The tile cache keeps a pointer to the compressor, so free it first
+	dtFreeTileCache(tileCache);
+	tileCache = NULL;
+	dtFreeTileCacheCompressor(tileCacheCompressor);
+	tileCacheCompressor = dtAllocTileCacheCompressor(header.compressor);
+	if (tileCacheCompressor == NULL)
+		return false;
+	tileCache = dtAllocTileCache();
+	if (tileCache == NULL)
+		return false;
+	status = tileCache->init(&header.cacheParams, &tileCacheAlloc, tileCacheCompressor);
+	if (status & DT_FAILURE)
+		return false;
+
+	// The caller's buffer is only borrowed, so the tile cache gets its own copy of each tile
+	int offset = sizeof(TileCacheSetHeader);
+	for (int i = 0; i < header.numTiles; ++i)
+	{
+		if (offset + (int)sizeof(TileCacheTileHeader) > tileCacheDataSize)
+			return false;
+		TileCacheTileHeader tileHeader;
+		memcpy(&tileHeader, tileCacheData + offset, sizeof(TileCacheTileHeader));
+		offset += sizeof(TileCacheTileHeader);
+
+		if (tileHeader.dataSize <= 0 || offset + tileHeader.dataSize > tileCacheDataSize)
+			return false;
+		unsigned char* data = (unsigned char*)dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM);
+		if (data == NULL)
+			return false;
+		memcpy(data, tileCacheData + offset, tileHeader.dataSize);
+		offset += tileHeader.dataSize;
+
+		dtCompressedTileRef tile = 0;
+		status = tileCache->addTile(data, tileHeader.dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tile);
+		if (status & DT_FAILURE)
+		{
+			dtFree(data);
+			return false;
+		}
+		tileCache->buildNavMeshTile(tile, &navMesh);
+	}
+
+	tileCacheDirty = false;
+	return true;
+}
+
+bool SteeringManager::readNavMeshSet(unsigned char* navMeshSetData, int navMeshSetDataSize, bool init)
+{
+	if (navMeshSetDataSize < (int)sizeof(NavMeshSetHeader))
+		return false;
+
+	NavMeshSetHeader header;
+	memcpy(&header, navMeshSetData, sizeof(NavMeshSetHeader));
+	if (header.magic != NAVMESHSET_MAGIC || header.version != NAVMESHSET_VERSION)
+		return false;
+
+	if (init)
+	{
+		dtStatus status = navMesh.init(&header.params);
+		if (status & DT_FAILURE)
+			return false;
+	}
+
+	int offset = sizeof(NavMeshSetHeader);
+	for (int i = 0; i < header.numTiles; ++i)
+	{
+		if (offset + (int)sizeof(NavMeshTileHeader) > navMeshSetDataSize)
+			return false;
+		NavMeshTileHeader tileHeader;
+		memcpy(&tileHeader, navMeshSetData + offset, sizeof(NavMeshTileHeader));
+		offset += sizeof(NavMeshTileHeader);
+
+		if (tileHeader.dataSize < 0 || offset + tileHeader.dataSize > navMeshSetDataSize)
+			return false;
+
+		dtTileRef oldTile = navMesh.getTileRefAt(tileHeader.tileX, tileHeader.tileY, 0);
+		if (oldTile)
+			navMesh.removeTile(oldTile, 0, 0);
+
+		// An empty tile only removes what was there
+		if (tileHeader.dataSize == 0)
+			continue;
+
+		// The caller's buffer is only borrowed, so the navmesh gets its own copy of each tile
+		unsigned char* data = (unsigned char*)dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM);
+		if (data == NULL)
+			return false;
+		memcpy(data, navMeshSetData + offset, tileHeader.dataSize);
+		offset += tileHeader.dataSize;
+
+		dtStatus status = navMesh.addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA, 0, 0);
+		if (status & DT_FAILURE)
+		{
+			dtFree(data);
+			return false;
+		}
+	}
+	return true;
+}
+
 bool SteeringManager::initQuery()
 {
 	dtStatus status = query.init(&navMesh, 4096);
 	if (status & DT_FAILURE)
 		return false;
-	return true;
+	// Batches share the agents' filter table
+	return queryService.init(&navMesh, 2048, crowd.getFilter(0), DT_CROWD_MAX_QUERY_FILTER_TYPE);
 }
 
 bool SteeringManager::initCrowd(int maxAgents, float maxAgentRadius)
@@ -262,6 +1131,9 @@ bool SteeringManager::initCrowd(int maxAgents, float maxAgentRadius)
 	bool result = crowd.init(maxAgents, maxAgentRadius, &navMesh);
 	if (result == false)
 		return false;
+	lod.init(maxAgents);
+	pathLatency.init(maxAgents);
+	crowd.setClock(CrowdClock);
 
 	// Use mostly default settings, copy from dtCrowd
 	dtObstacleAvoidanceParams params;
@@ -0,0 +1,346 @@
+/*
+* Agent Development and Prototyping Testbed
+* https://github.com/ashoulson/ADAPT
+* 
+* Copyright (C) 2011-2015 Alexander Shoulson - ashoulson@gmail.com
+*
+* This file is part of ADAPT.
+* 
+* ADAPT is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* ADAPT is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+* 
+* You should have received a copy of the GNU Lesser General Public License
+* along with ADAPT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include <DetourAlloc.h>
+
+#include "NavMeshSet.h"
+#include "TileStreamer.h"
+
+// Most tile reads in flight at once
+static const int MAX_PENDING_LOADS = 16;
+
+static int TileKey(int tileX, int tileY)
+{
+	return (tileY << 16) | (tileX & 0xffff);
+}
+
+TileStreamer::TileStreamer()
+	: file(NULL), radius(50.0f), maxResidentTiles(64), synchronous(false), frame(0)
+{
+	memset(&params, 0, sizeof(params));
+	close();
+}
+
+TileStreamer::~TileStreamer()
+{
+	close();
+}
+
+bool TileStreamer::open(const char* path)
+{
+	close();
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+
+	NavMeshSetHeader header;
+	if (fread(&header, sizeof(NavMeshSetHeader), 1, file) != 1 
+		|| header.magic != NAVMESHSET_MAGIC || header.version != NAVMESHSET_VERSION)
+	{
+		close();
+		return false;
+	}
+	params = header.params;
+
+	// Only the tile headers are read, the data is skipped
+	long offset = sizeof(NavMeshSetHeader);
+	for (int i = 0; i < header.numTiles; ++i)
+	{
+		NavMeshTileHeader tileHeader;
+		if (fseek(file, offset, SEEK_SET) != 0 
+			|| fread(&tileHeader, sizeof(NavMeshTileHeader), 1, file) != 1
+			|| tileHeader.dataSize < 0)
+		{
+			close();
+			return false;
+		}
+		offset += sizeof(NavMeshTileHeader);
+
+		// An empty tile has nothing to stream
+		if (tileHeader.dataSize > 0)
+		{
+			Tile tile;
+			tile.tileX = tileHeader.tileX;
+			tile.tileY = tileHeader.tileY;
+			tile.offset = offset;
+			tile.dataSize = tileHeader.dataSize;
+			tile.state = TILE_ABSENT;
+			tile.lastUsed = 0;
+
+			// A later copy of a tile replaces the earlier one
+			const int existing = findTile(tile.tileX, tile.tileY);
+			if (existing >= 0)
+			{
+				tiles[existing] = tile;
+			}
+			else
+			{
+				tileLookup[TileKey(tile.tileX, tile.tileY)] = (int)tiles.size();
+				tiles.push_back(tile);
+			}
+		}
+		offset += tileHeader.dataSize;
+	}
+	return true;
+}
+
+void TileStreamer::close()
+{
+#ifdef _MSC_VER
+	readTasks.wait();
+#endif
+	for (size_t i = 0; i < finishedLoads.size(); ++i)
+	{
+		dtFree(finishedLoads[i]->data);
+		delete finishedLoads[i];
+	}
+	finishedLoads.clear();
+	pendingLoads = 0;
+
+	if (file != NULL)
+		fclose(file);
+	file = NULL;
+
+	tiles.clear();
+	tileLookup.clear();
+	interest.clear();
+	residentTiles = 0;
+	residentBytes = 0;
+	loadCount = 0;
+	evictions = 0;
+	failedLoads = 0;
+	lastLoadMs = 0.0f;
+	totalLoadMs = 0.0f;
+	maxLoadMs = 0.0f;
+}
+
+void TileStreamer::setLimits(float streamingRadius, int maxTiles)
+{
+	radius = streamingRadius > 0.0f ? streamingRadius : 0.0f;
+	maxResidentTiles = maxTiles > 1 ? maxTiles : 1;
+}
+
+void TileStreamer::setSynchronous(bool sync)
+{
+#ifdef _MSC_VER
+	readTasks.wait();
+#endif
+	synchronous = sync;
+}
+
+void TileStreamer::addInterest(const float* pos)
+{
+	interest.push_back(pos[0]);
+	interest.push_back(pos[1]);
+	interest.push_back(pos[2]);
+}
+
+bool TileStreamer::isResident(const float* pos) const
+{
+	if (file == NULL)
+		return false;
+	const int tileX = (int)floorf((pos[0] - params.orig[0]) / params.tileWidth);
+	const int tileY = (int)floorf((pos[2] - params.orig[2]) / params.tileHeight);
+	const int tile = findTile(tileX, tileY);
+	return tile >= 0 && tiles[tile].state == TILE_RESIDENT;
+}
+
+int TileStreamer::findTile(int tileX, int tileY) const
+{
+	std::map<int, int>::const_iterator it = tileLookup.find(TileKey(tileX, tileY));
+	return it != tileLookup.end() ? it->second : -1;
+}
+
+int TileStreamer::update(dtNavMesh* navMesh, NavQueryService* queryService)
+{
+	if (file == NULL)
+		return 0;
+
+	frame++;
+	for (size_t i = 0; i < interest.size(); i += 3)
+		requestTiles(&interest[i]);
+	interest.clear();
+
+	std::vector<Load*> loaded;
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(loadLock);
+#endif
+		loaded.swap(finishedLoads);
+	}
+	if (loaded.empty() && residentTiles <= maxResidentTiles)
+		return 0;
+
+	queryService->beginNavMeshUpdate();
+	int changed = addLoadedTiles(navMesh, loaded);
+	changed += evictTiles(navMesh);
+	queryService->endNavMeshUpdate();
+	return changed;
+}
+
+void TileStreamer::requestTiles(const float* pos)
+{
+	const int minX = (int)floorf((pos[0] - radius - params.orig[0]) / params.tileWidth);
+	const int maxX = (int)floorf((pos[0] + radius - params.orig[0]) / params.tileWidth);
+	const int minY = (int)floorf((pos[2] - radius - params.orig[2]) / params.tileHeight);
+	const int maxY = (int)floorf((pos[2] + radius - params.orig[2]) / params.tileHeight);
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const int index = findTile(x, y);
+			if (index < 0)
+				continue;
+			Tile& tile = tiles[index];
+			tile.lastUsed = frame;
+			if (tile.state != TILE_ABSENT || pendingLoads >= MAX_PENDING_LOADS)
+				continue;
+
+			Load* load = new Load();
+			load->tile = index;
+			load->offset = tile.offset;
+			load->dataSize = tile.dataSize;
+			load->data = NULL;
+			load->requested = getPerfTime();
+			tile.state = TILE_LOADING;
+			pendingLoads++;
+
+#ifdef _MSC_VER
+			if (!synchronous)
+			{
+				readTasks.run([this, load]()
+				{
+					readTile(load);
+				});
+				continue;
+			}
+#endif
+			readTile(load);
+		}
+	}
+}
+
+void TileStreamer::readTile(Load* load)
+{
+	unsigned char* data = (unsigned char*)dtAlloc(load->dataSize, DT_ALLOC_PERM);
+	if (data != NULL)
+	{
+#ifdef _MSC_VER
+		Concurrency::critical_section::scoped_lock lock(fileLock);
+#endif
+		if (fseek(file, load->offset, SEEK_SET) != 0 || fread(data, load->dataSize, 1, file) != 1)
+		{
+			dtFree(data);
+			data = NULL;
+		}
+	}
+	load->data = data;
+
+#ifdef _MSC_VER
+	Concurrency::critical_section::scoped_lock lock(loadLock);
+#endif
+	finishedLoads.push_back(load);
+}
+
+int TileStreamer::addLoadedTiles(dtNavMesh* navMesh, const std::vector<Load*>& loaded)
+{
+	int added = 0;
+	for (size_t i = 0; i < loaded.size(); ++i)
+	{
+		Load* load = loaded[i];
+		pendingLoads--;
+
+		Tile& tile = tiles[load->tile];
+		if (load->data != NULL 
+			&& dtStatusSucceed(navMesh->addTile(load->data, load->dataSize, DT_TILE_FREE_DATA, 0, 0)))
+		{
+			tile.state = TILE_RESIDENT;
+			residentTiles++;
+			residentBytes += load->dataSize;
+			loadCount++;
+			added++;
+
+			lastLoadMs = getPerfTimeUsec(getPerfTime() - load->requested) / 1000.0f;
+			totalLoadMs += lastLoadMs;
+			maxLoadMs = std::max(maxLoadMs, lastLoadMs);
+		}
+		else
+		{
+			// A tile that cannot be read or added is not tried again
+			dtFree(load->data);
+			tile.state = TILE_FAILED;
+			failedLoads++;
+		}
+
+		delete load;
+	}
+	return added;
+}
+
+int TileStreamer::evictTiles(dtNavMesh* navMesh)
+{
+	if (residentTiles <= maxResidentTiles)
+		return 0;
+
+	// Tiles requested this update are in use and stay
+	std::vector<std::pair<unsigned int, int> > candidates;
+	for (size_t i = 0; i < tiles.size(); ++i)
+	{
+		if (tiles[i].state == TILE_RESIDENT && tiles[i].lastUsed != frame)
+			candidates.push_back(std::make_pair(tiles[i].lastUsed, (int)i));
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	int evicted = 0;
+	for (size_t i = 0; i < candidates.size() && residentTiles > maxResidentTiles; ++i)
+	{
+		Tile& tile = tiles[candidates[i].second];
+		const dtTileRef ref = navMesh->getTileRefAt(tile.tileX, tile.tileY, 0);
+		if (ref)
+			navMesh->removeTile(ref, 0, 0);
+		tile.state = TILE_ABSENT;
+		residentTiles--;
+		residentBytes -= tile.dataSize;
+		evictions++;
+		evicted++;
+	}
+	return evicted;
+}
+
+void TileStreamer::getStats(TileStreamingStats* stats) const
+{
+	stats->storedTiles = (int)tiles.size();
+	stats->residentTiles = residentTiles;
+	stats->residentBytes = residentBytes;
+	stats->pendingLoads = pendingLoads;
+	stats->loads = loadCount;
+	stats->evictions = evictions;
+	stats->failedLoads = failedLoads;
+	stats->lastLoadMs = lastLoadMs;
+	stats->averageLoadMs = loadCount > 0 ? totalLoadMs / loadCount : 0.0f;
+	stats->maxLoadMs = maxLoadMs;
+}